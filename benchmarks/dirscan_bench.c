@@ -0,0 +1,281 @@
+// // // // // //
+//             //
+//   LITE FM   //
+//             //
+// // // // // //
+
+/*
+ * ---------------------------------------------------------------------------
+ *  File:        dirscan_bench.c
+ *  Description: Compares the old two pass readdir + lstat listing with the
+ *               single pass getdents64 scanner used by list_dir.
+ *
+ *  Author:      Siddharth Karanam
+ *  Created:     <17/10/26>
+ *
+ *  Copyright:   2024 nots1dd. All rights reserved.
+ *
+ *  License:     <GNU GPL v3>
+ *
+ *  Notes:       Usage: dirscan_bench [-n entries] [-i iterations] [dir]
+ *
+ *               Without a directory argument a scratch directory with
+ *               `entries` files (+1 subdir every 16 files) is created in
+ *               /tmp and removed afterwards. Both scanners run against a
+ *               warm dentry cache, so the numbers are syscall + CPU cost.
+ *
+ *  Revision History:
+ *      <17/10/26> - Initial creation.
+ *
+ * ---------------------------------------------------------------------------
+ */
+
+#define _GNU_SOURCE
+
+#include "../include/dirscan.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+typedef struct
+{
+  char*  buf;
+  size_t len;
+  size_t cap;
+  int    count;
+} NameSink;
+
+static void sink_push(NameSink* sink, const char* name, size_t len)
+{
+  if (sink->len + len + 1 > sink->cap)
+  {
+    sink->cap = sink->cap ? sink->cap * 2 : 1 << 20;
+    while (sink->cap < sink->len + len + 1)
+      sink->cap *= 2;
+    sink->buf = realloc(sink->buf, sink->cap);
+  }
+  memcpy(sink->buf + sink->len, name, len + 1);
+  sink->len += len + 1;
+  sink->count++;
+}
+
+static double now_ms(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+/* What list_dir used to do: two readdir passes with an lstat per entry per pass */
+static int legacy_two_pass(const char* path, NameSink* sink)
+{
+  DIR* dir = opendir(path);
+  if (!dir)
+    return -1;
+
+  struct dirent* entry;
+  struct stat    st;
+  char           full_path[PATH_MAX];
+  char           target[PATH_MAX];
+  char           label[NAME_MAX * 2 + 8];
+
+  while ((entry = readdir(dir)) != NULL)
+  {
+    if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
+      continue;
+    snprintf(full_path, sizeof(full_path), "%s/%s", path, entry->d_name);
+    if (lstat(full_path, &st) == -1)
+      continue;
+    if (S_ISLNK(st.st_mode))
+    {
+      ssize_t len = readlink(full_path, target, sizeof(target) - 1);
+      target[len < 0 ? 0 : len] = '\0';
+      int n = snprintf(label, sizeof(label), "%s -> %s", entry->d_name, target);
+      sink_push(sink, label, (size_t)n);
+    }
+    else if (S_ISDIR(st.st_mode))
+    {
+      sink_push(sink, entry->d_name, strlen(entry->d_name));
+    }
+  }
+
+  rewinddir(dir);
+
+  while ((entry = readdir(dir)) != NULL)
+  {
+    if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
+      continue;
+    snprintf(full_path, sizeof(full_path), "%s/%s", path, entry->d_name);
+    if (lstat(full_path, &st) == -1)
+      continue;
+    if (!S_ISLNK(st.st_mode) && !S_ISDIR(st.st_mode))
+      sink_push(sink, entry->d_name, strlen(entry->d_name));
+  }
+
+  closedir(dir);
+  return sink->count;
+}
+
+typedef struct
+{
+  NameSink dirs;
+  NameSink files;
+  int      dir_fd;
+} SplitSink;
+
+static int single_pass_collect(void* data, const char* name, size_t len, unsigned char d_type)
+{
+  SplitSink* split = (SplitSink*)data;
+  if (d_type == DT_LNK)
+  {
+    char    target[PATH_MAX];
+    char    label[NAME_MAX * 2 + 8];
+    ssize_t tlen = readlinkat(split->dir_fd, name, target, sizeof(target) - 1);
+    target[tlen < 0 ? 0 : tlen] = '\0';
+    int n = snprintf(label, sizeof(label), "%s -> %s", name, target);
+    sink_push(&split->dirs, label, (size_t)n);
+  }
+  else if (d_type == DT_DIR)
+  {
+    sink_push(&split->dirs, name, len);
+  }
+  else
+  {
+    sink_push(&split->files, name, len);
+  }
+  return 0;
+}
+
+static int single_pass(const char* path, NameSink* sink)
+{
+  SplitSink split = {{NULL, 0, 0, 0}, {NULL, 0, 0, 0}, -1};
+  split.dir_fd    = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (split.dir_fd == -1)
+    return -1;
+
+  dirscan_fd(split.dir_fd, 1, single_pass_collect, &split);
+  close(split.dir_fd);
+
+  // Group: dirs first, then files
+  *sink           = split.dirs;
+  const char* cur = split.files.buf;
+  for (int i = 0; i < split.files.count; i++)
+  {
+    size_t len = strlen(cur);
+    sink_push(sink, cur, len);
+    cur += len + 1;
+  }
+  free(split.files.buf);
+  return sink->count;
+}
+
+/* Returns -1 if `root` is too long to put entries in */
+static int make_fixture(const char* root, int entries)
+{
+  char path[PATH_MAX];
+  mkdir(root, 0755);
+  for (int i = 0; i < entries; i++)
+  {
+    if (i % 16 == 0)
+    {
+      if (snprintf(path, sizeof(path), "%s/dir_%07d", root, i) >= (int)sizeof(path))
+        return -1;
+      mkdir(path, 0755);
+    }
+    if (snprintf(path, sizeof(path), "%s/build_artifact_%07d.o", root, i) >= (int)sizeof(path))
+      return -1;
+    int fd = open(path, O_CREAT | O_WRONLY | O_CLOEXEC, 0644);
+    if (fd != -1)
+      close(fd);
+  }
+  return 0;
+}
+
+static void remove_fixture(const char* root)
+{
+  char           path[PATH_MAX];
+  DIR*           dir = opendir(root);
+  struct dirent* entry;
+  while (dir && (entry = readdir(dir)) != NULL)
+  {
+    if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
+      continue;
+    if (snprintf(path, sizeof(path), "%s/%s", root, entry->d_name) >= (int)sizeof(path))
+      continue;
+    if (entry->d_type == DT_DIR)
+      rmdir(path);
+    else
+      unlink(path);
+  }
+  if (dir)
+    closedir(dir);
+  rmdir(root);
+}
+
+static double run(const char* label, int (*scan)(const char*, NameSink*), const char* path,
+                  int iterations)
+{
+  double best = 1e18, total = 0;
+  int    count = 0;
+  for (int i = 0; i < iterations; i++)
+  {
+    NameSink sink = {NULL, 0, 0, 0};
+    double   t0   = now_ms();
+    count         = scan(path, &sink);
+    double dt     = now_ms() - t0;
+    free(sink.buf);
+    total += dt;
+    if (dt < best)
+      best = dt;
+  }
+  printf("  %-24s %8d entries  best %9.3f ms  avg %9.3f ms\n", label, count, best,
+         total / iterations);
+  return best;
+}
+
+int main(int argc, char* argv[])
+{
+  int         entries    = 200000;
+  int         iterations = 10;
+  const char* dir        = NULL;
+  char        scratch[PATH_MAX];
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+      entries = atoi(argv[++i]);
+    else if (strcmp(argv[i], "-i") == 0 && i + 1 < argc)
+      iterations = atoi(argv[++i]);
+    else
+      dir = argv[i];
+  }
+
+  if (dir == NULL)
+  {
+    snprintf(scratch, sizeof(scratch), "/tmp/litefm-dirscan-bench-%d", (int)getpid());
+    printf("Creating %d entries in %s ...\n", entries, scratch);
+    if (make_fixture(scratch, entries) == -1)
+    {
+      fprintf(stderr, "Fixture path too long: %s\n", scratch);
+      remove_fixture(scratch);
+      return 1;
+    }
+    dir = scratch;
+  }
+
+  printf("Scanning %s (%d iterations)\n", dir, iterations);
+  double legacy = run("two pass readdir+lstat", legacy_two_pass, dir, iterations);
+  double fast   = run("single pass getdents64", single_pass, dir, iterations);
+  printf("  speedup: %.2fx\n", legacy / fast);
+
+  if (dir == scratch)
+    remove_fixture(scratch);
+  return 0;
+}
@@ -0,0 +1,153 @@
+// // // // // //
+//             //
+//   LITE FM   //
+//             //
+// // // // // //
+
+/*
+ * ---------------------------------------------------------------------------
+ *  File:        ext_bench.c
+ *  Description: Cost of classifying a file name by its extension, the
+ *               generated perfect hash table against a strcmp chain.
+ *
+ *  Author:      Siddharth Karanam
+ *  Created:     <17/10/26>
+ *
+ *  Copyright:   2024 nots1dd. All rights reserved.
+ *
+ *  License:     <GNU GPL v3>
+ *
+ *  Notes:       Usage: ext_bench [-n names] [-i iterations]
+ *
+ *               The names are built in memory: a third have no or an
+ *               unknown extension, the rest one of the table's, in mixed
+ *               case for some. The strcmp chain is the one rows used to be
+ *               classified with (18 extensions, case sensitive), so it
+ *               knows less and still costs more. Reports ns per name.
+ *
+ *  Revision History:
+ *      <17/10/26> - Initial creation.
+ *
+ * ---------------------------------------------------------------------------
+ */
+
+#define _GNU_SOURCE
+
+#include "../include/exttable.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static double now_ns(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static uint64_t rng_state = 0x9E3779B97F4A7C15ULL;
+
+static uint64_t rng(void)
+{
+  rng_state ^= rng_state << 13;
+  rng_state ^= rng_state >> 7;
+  rng_state ^= rng_state << 17;
+  return rng_state;
+}
+
+/* What print_items did per row before the table */
+static int strcmp_chain(const char* name)
+{
+  const char* extension = strrchr(name, '.');
+  if (extension == NULL)
+    return EXT_CATEGORY_NONE;
+  if (strcmp(extension, ".zip") == 0 || strcmp(extension, ".7z") == 0 ||
+      strcmp(extension, ".tar") == 0 || strcmp(extension, ".xz") == 0 ||
+      strcmp(extension, ".gz") == 0 || strcmp(extension, ".jar") == 0)
+    return EXT_CATEGORY_ARCHIVE;
+  if (strcmp(extension, ".mp3") == 0 || strcmp(extension, ".wav") == 0 ||
+      strcmp(extension, ".flac") == 0 || strcmp(extension, ".opus") == 0)
+    return EXT_CATEGORY_AUDIO;
+  if (strcmp(extension, ".png") == 0 || strcmp(extension, ".jpg") == 0 ||
+      strcmp(extension, ".webp") == 0 || strcmp(extension, ".gif") == 0)
+    return EXT_CATEGORY_IMAGE;
+  if (strcmp(extension, ".mp4") == 0 || strcmp(extension, ".m4v") == 0 ||
+      strcmp(extension, ".mkv") == 0 || strcmp(extension, ".avi") == 0)
+    return EXT_CATEGORY_VIDEO;
+  return EXT_CATEGORY_NONE;
+}
+
+static int table_lookup(const char* name)
+{
+  const ExtInfo* ext = ext_lookup(name);
+  return ext ? ext->category : EXT_CATEGORY_NONE;
+}
+
+static char** build_names(int count)
+{
+  static const char* exts[]    = {"c",   "h",    "txt", "md",  "py",   "png", "JPG", "mp3",
+                                  "mkv", "flac", "zip", "tar", "gz",   "Json", "sh", "webp"};
+  static const char* unknown[] = {"", ".o", ".log", ".bak", ".rs", ".orig"};
+  size_t             n_exts    = sizeof(exts) / sizeof(exts[0]);
+  size_t             n_unknown = sizeof(unknown) / sizeof(unknown[0]);
+
+  char** names = malloc(count * sizeof(char*));
+  for (int i = 0; i < count; i++)
+  {
+    uint64_t r = rng();
+    if (r % 3 == 0)
+      asprintf(&names[i], "build_%06d%s", i, unknown[(r >> 8) % n_unknown]);
+    else
+      asprintf(&names[i], "src_file_%06d.%s", i, exts[(r >> 8) % n_exts]);
+  }
+  return names;
+}
+
+static double best_ns_per_name(int (*classify)(const char*), char** names, int count,
+                               int iterations, long* sink)
+{
+  double best = 1e18;
+  for (int it = 0; it < iterations; it++)
+  {
+    long   sum = 0;
+    double t0  = now_ns();
+    for (int i = 0; i < count; i++)
+      sum += classify(names[i]);
+    double dt = (now_ns() - t0) / count;
+    *sink += sum;
+    if (dt < best)
+      best = dt;
+  }
+  return best;
+}
+
+int main(int argc, char* argv[])
+{
+  int count      = 1000000;
+  int iterations = 5;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+      count = atoi(argv[++i]);
+    else if (strcmp(argv[i], "-i") == 0 && i + 1 < argc)
+      iterations = atoi(argv[++i]);
+  }
+
+  char** names = build_names(count);
+  long   sink  = 0;
+
+  printf("Classifying %d names by extension, best of %d\n", count, iterations);
+  printf("  strcmp chain   %7.2f ns/name\n",
+         best_ns_per_name(strcmp_chain, names, count, iterations, &sink));
+  printf("  perfect hash   %7.2f ns/name\n",
+         best_ns_per_name(table_lookup, names, count, iterations, &sink));
+  printf("  (checksum %ld)\n", sink);
+
+  for (int i = 0; i < count; i++)
+    free(names[i]);
+  free(names);
+  return 0;
+}
@@ -0,0 +1,143 @@
+// // // // // //
+//             //
+//   LITE FM   //
+//             //
+// // // // // //
+
+/*
+ * ---------------------------------------------------------------------------
+ *  File:        sort_bench.c
+ *  Description: Times every listing sort mode on a large synthetic
+ *               directory.
+ *
+ *  Author:      Siddharth Karanam
+ *  Created:     <17/10/26>
+ *
+ *  Copyright:   2024 nots1dd. All rights reserved.
+ *
+ *  License:     <GNU GPL v3>
+ *
+ *  Notes:       Usage: sort_bench [-n entries] [-i iterations]
+ *
+ *               The listing is built in memory (log file style names, 1 dir
+ *               every 32 entries, random sizes and mtimes) so no filesystem
+ *               is involved. Each iteration starts from the same shuffled
+ *               order, and the key build, sort and permutation are all
+ *               inside the timed region.
+ *
+ *  Revision History:
+ *      <17/10/26> - Initial creation.
+ *
+ * ---------------------------------------------------------------------------
+ */
+
+#define _GNU_SOURCE
+
+#include "../include/entrysort.h"
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static double now_ms(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+static uint64_t rng_state = 0x9E3779B97F4A7C15ULL;
+
+static uint64_t rng(void)
+{
+  rng_state ^= rng_state << 13;
+  rng_state ^= rng_state >> 7;
+  rng_state ^= rng_state << 17;
+  return rng_state;
+}
+
+static void build_listing(EntryStore* store, int entries)
+{
+  static const char* stems[] = {"app", "Access", "error", "worker", "Build", "trace"};
+  static const char* exts[]  = {"log", "gz", "txt", "json", "LOG"};
+  char               name[NAME_MAX + 1];
+
+  for (int i = 0; i < entries; i++)
+  {
+    int len;
+    int is_dir = i % 32 == 0;
+    if (is_dir)
+      len = snprintf(name, sizeof(name), "shard-%u", (unsigned)(rng() % 100000));
+    else
+      len = snprintf(name, sizeof(name), "%s-%u.%s", stems[rng() % 6],
+                     (unsigned)(rng() % 10000000), exts[rng() % 5]);
+    entry_store_push(store, name, (size_t)len, is_dir ? ENTRY_DIR : ENTRY_FILE);
+  }
+
+  // Group like the loader does
+  EntryStore grouped;
+  entry_store_init(&grouped);
+  entry_store_append_grouped(&grouped, store);
+  entry_store_copy(store, &grouped);
+  entry_store_free(&grouped);
+
+  for (int i = 0; i < entries; i++)
+  {
+    EntryMeta meta = {0};
+    meta.size      = rng() % (1ULL << 32);
+    meta.mtime     = 1600000000 + (int64_t)(rng() % 100000000);
+    meta.mode      = 0100644;
+    meta.valid     = 1;
+    entry_store_set_meta(store, i, &meta);
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  int entries    = 1000000;
+  int iterations = 5;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+      entries = atoi(argv[++i]);
+    else if (strcmp(argv[i], "-i") == 0 && i + 1 < argc)
+      iterations = atoi(argv[++i]);
+  }
+
+  EntryStore store;
+  entry_store_init(&store);
+  build_listing(&store, entries);
+
+  size_t       bytes    = store.count * sizeof(EntryRecord);
+  EntryRecord* shuffled = malloc(bytes);
+  memcpy(shuffled, store.records, bytes);
+
+  printf("Sorting %zu entries (%zu dirs), best of %d\n", store.count, store.dir_count,
+         iterations);
+  for (int mode = 0; mode < SORT_MODE_COUNT; mode++)
+  {
+    for (int reverse = 0; reverse < 2; reverse++)
+    {
+      double best = 1e18;
+      for (int i = 0; i < iterations; i++)
+      {
+        memcpy(store.records, shuffled, bytes);
+        int    highlight = entries / 2;
+        double t0        = now_ms();
+        entry_sort(&store, -1, (SortMode)mode, reverse, &highlight);
+        double dt = now_ms() - t0;
+        if (dt < best)
+          best = dt;
+      }
+      printf("  %-10s %-9s best %9.3f ms\n", entry_sort_label((SortMode)mode),
+             reverse ? "reversed" : "", best);
+    }
+  }
+
+  free(shuffled);
+  entry_store_free(&store);
+  return 0;
+}
@@ -0,0 +1,180 @@
+// // // // // //
+//             //
+//   LITE FM   //
+//             //
+// // // // // //
+
+/*
+ * ---------------------------------------------------------------------------
+ *  File:        syntax_bench.c
+ *  Description: What it costs to get the syntax definitions ready, and to
+ *               look words up in them, for the tables compiled in from
+ *               keywords/ against the same YAML parsed at runtime.
+ *
+ *  Author:      Siddharth Karanam
+ *  Created:     <17/10/26>
+ *
+ *  Copyright:   2024 nots1dd. All rights reserved.
+ *
+ *  License:     <GNU GPL v3>
+ *
+ *  Notes:       Usage: syntax_bench [-k keywords dir] [-r rounds] [-i iterations]
+ *
+ *               Both sides go through syntax_get: the runtime one points
+ *               $LITEFM_KEYWORDS_DIR at the keywords directory (by default
+ *               keywords/ under the current directory), so every language
+ *               is parsed with libyaml into HashTables as it was before it
+ *               was compiled in. A round is a syntax_free and a syntax_get
+ *               of every built in language, what previewing one file of
+ *               each costs at startup. Reports the best round in us.
+ *
+ *               Lookups run every word of every language, and each one with
+ *               a character appended (a miss), through syntax_has_word for
+ *               every set. Reports ns per lookup.
+ *
+ *  Revision History:
+ *      <17/10/26> - Initial creation.
+ *
+ * ---------------------------------------------------------------------------
+ */
+
+#define _GNU_SOURCE
+
+#include "../include/syntax.h"
+#include "syntax_gen.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static double now_ns(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static const Syntax* languages[SYNTAX_TABLE_COUNT];
+
+/* Best round, in ns, of getting every language from scratch */
+static double best_round_ns(int rounds, int* loaded)
+{
+  double best = 1e18;
+  for (int r = 0; r < rounds; r++)
+  {
+    syntax_free();
+    *loaded   = 0;
+    double t0 = now_ns();
+    for (size_t i = 0; i < SYNTAX_TABLE_COUNT; i++)
+    {
+      languages[i] = syntax_get(syntax_tables[i].language);
+      *loaded += languages[i] != NULL;
+    }
+    double dt = now_ns() - t0;
+    if (dt < best)
+      best = dt;
+  }
+  return best;
+}
+
+static char** build_words(size_t* count)
+{
+  size_t total = 0;
+  for (size_t i = 0; i < SYNTAX_TABLE_COUNT; i++)
+  {
+    for (uint32_t slot = 0; slot < syntax_tables[i].slots; slot++)
+      total += syntax_tables[i].words[slot].word != NULL;
+  }
+
+  char** words = malloc(2 * total * sizeof(char*));
+  *count       = 0;
+  for (size_t i = 0; i < SYNTAX_TABLE_COUNT; i++)
+  {
+    for (uint32_t slot = 0; slot < syntax_tables[i].slots; slot++)
+    {
+      const char* word = syntax_tables[i].words[slot].word;
+      if (word == NULL)
+        continue;
+      words[(*count)++] = strdup(word);
+      asprintf(&words[(*count)++], "%sx", word);
+    }
+  }
+  return words;
+}
+
+/* Best pass, in ns per lookup, over `words` in every set of every language */
+static double best_lookup_ns(char** words, size_t count, int iterations, long* sink)
+{
+  double best = 1e18;
+  for (int it = 0; it < iterations; it++)
+  {
+    long   hits    = 0;
+    long   lookups = 0;
+    double t0      = now_ns();
+    for (size_t l = 0; l < SYNTAX_TABLE_COUNT; l++)
+    {
+      if (languages[l] == NULL)
+        continue;
+      for (size_t i = 0; i < count; i++)
+      {
+        for (int set = 0; set < SYNTAX_SET_COUNT; set++)
+          hits += syntax_has_word(languages[l], (SyntaxSet)set, words[i]);
+      }
+      lookups += (long)count * SYNTAX_SET_COUNT;
+    }
+    double dt = (now_ns() - t0) / (lookups ? lookups : 1);
+    *sink += hits;
+    if (dt < best)
+      best = dt;
+  }
+  return best;
+}
+
+int main(int argc, char* argv[])
+{
+  const char* dir        = "keywords";
+  int         rounds     = 50;
+  int         iterations = 20;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "-k") == 0 && i + 1 < argc)
+      dir = argv[++i];
+    else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+      rounds = atoi(argv[++i]);
+    else if (strcmp(argv[i], "-i") == 0 && i + 1 < argc)
+      iterations = atoi(argv[++i]);
+  }
+
+  size_t count;
+  char** words = build_words(&count);
+  long   sink  = 0;
+  int    loaded;
+
+  printf("Getting the syntax of %d languages ready, best of %d rounds\n", SYNTAX_TABLE_COUNT,
+         rounds);
+
+  setenv(SYNTAX_ENV_DIR, dir, 1);
+  double yaml_ns = best_round_ns(rounds, &loaded);
+  printf("  YAML from %-12s %9.1f us (%d loaded)\n", dir, yaml_ns / 1e3, loaded);
+  if (loaded != SYNTAX_TABLE_COUNT)
+    fprintf(stderr, "  (not every language loaded from %s, see the log)\n", dir);
+  double yaml_lookup_ns = best_lookup_ns(words, count, iterations, &sink);
+
+  setenv(SYNTAX_ENV_DIR, "/nonexistent", 1);
+  double table_ns = best_round_ns(rounds, &loaded);
+  printf("  compiled in           %9.1f us (%d loaded)\n", table_ns / 1e3, loaded);
+  double table_lookup_ns = best_lookup_ns(words, count, iterations, &sink);
+
+  printf("Looking up %zu words in every set, best of %d\n", count, iterations);
+  printf("  HashTable             %9.2f ns/lookup\n", yaml_lookup_ns);
+  printf("  perfect hash          %9.2f ns/lookup\n", table_lookup_ns);
+  printf("  (checksum %ld)\n", sink);
+
+  syntax_free();
+  for (size_t i = 0; i < count; i++)
+    free(words[i]);
+  free(words);
+  return 0;
+}
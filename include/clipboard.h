@@ -32,6 +32,7 @@
 #define CLIPBOARD_H
 
 #include <dirent.h>
+#include <limits.h>
 #include <ncurses.h>
 #include <stdlib.h>
 #include <string.h>
@@ -0,0 +1,51 @@
+// // // // // //
+//             //
+//   LITE FM   //
+//             //
+// // // // // //
+
+/*
+ * ---------------------------------------------------------------------------
+ *  File:        compositor.h
+ *  Description: Collects the windows drawn during one iteration of the main
+ *               loop and puts them on the terminal with a single doupdate.
+ *
+ *  Author:      Siddharth Karanam
+ *  Created:     <17/10/26>
+ *
+ *  Copyright:   2024 nots1dd. All rights reserved.
+ *
+ *  License:     <GNU GPL v3>
+ *
+ *  Notes:       Drawing code calls `compositor_mark` where it used to call
+ *               wrefresh: the window is copied into curses' virtual screen
+ *               (wnoutrefresh) but nothing is written yet. The main loop
+ *               calls `compositor_flush` before it waits for the next key,
+ *               so a frame costs one terminal update no matter how many
+ *               windows it touched. Anything that blocks on input outside
+ *               the main loop (popups, prompts) has to flush first, getch
+ *               only refreshes windows that still have unmarked changes.
+ *
+ *               Every flush also counts the bytes curses wrote to the tty
+ *               (the main thread's wchar in /proc/thread-self/io around the
+ *               doupdate). The totals are logged on exit.
+ *
+ *  Revision History:
+ *      <17/10/26> - Initial creation and function declarations added.
+ *
+ * ---------------------------------------------------------------------------
+ */
+
+#ifndef COMPOSITOR_H
+#define COMPOSITOR_H
+
+#include <ncurses.h>
+
+void compositor_init(void);
+void compositor_free(void);
+void compositor_mark(WINDOW* win);
+void compositor_flush(void);
+void compositor_present(WINDOW* win);
+void compositor_log_stats(void);
+
+#endif
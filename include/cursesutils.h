@@ -36,10 +36,12 @@
 #ifndef CURSESUTILS_H
 #define CURSESUTILS_H
 
+#include <limits.h>
 #include <locale.h>
 #include <ncurses.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/ioctl.h>
 #include <time.h>
 #include <unistd.h>
 
@@ -98,6 +100,7 @@ void    get_user_input(WINDOW* win, char* input, int max_length);
 void    displayHelp(WINDOW* main_win);
 WINDOW* create_centered_window(int height, int width);
 void    check_term_size(WINDOW* win, WINDOW* info_win);
+void    resize_to_term(void);
 void    displayProgressWindow(WINDOW* progress_win, FILE* progress_data);
 
 #endif // CURSESUTILS_H
@@ -0,0 +1,110 @@
+// // // // // //
+//             //
+//   LITE FM   //
+//             //
+// // // // // //
+
+/*
+ * ---------------------------------------------------------------------------
+ *  File:        dircache.h
+ *  Description: LRU cache of finished directory listings so that going back
+ *               and forth between directories does not rescan them.
+ *
+ *  Author:      Siddharth Karanam
+ *  Created:     <17/10/26>
+ *
+ *  Copyright:   2024 nots1dd. All rights reserved.
+ *
+ *  License:     <GNU GPL v3>
+ *
+ *  Notes:       A listing is cached under its path (dot entries included,
+ *               hiding them is a view over the listing) together with the
+ *               directory's identity (dev, ino, mtime) as seen when the scan
+ *               started.
+ *
+ *               Every cached directory gets an inotify watch. Any change to
+ *               it (entries created, removed, renamed, the dir itself
+ *               moved/removed) drops its listings, so a hit needs no stat.
+ *               The inotify queue is drained with one non blocking read
+ *               right before each lookup.
+ *
+ *               If inotify is not available (or we ran out of watches) the
+ *               entry is kept anyway and validated with a `stat` against the
+ *               stored (dev, ino, mtime) on lookup instead.
+ *
+ *               A listing is kept in the order it was last sorted in, with a
+ *               tag the caller picks for that order (DIRCACHE_UNSORTED as it
+ *               was read), so a hit that is already in the wanted order needs
+ *               no sort. An order marked DIRCACHE_BY_META (sizes, mtimes)
+ *               also watches the directory for writes and attribute changes
+ *               to its entries, which only set it back to DIRCACHE_UNSORTED:
+ *               the listing itself is still right. Without a watch such an
+ *               order is never trusted.
+ *
+ *               The memory cap defaults to DIRCACHE_DEFAULT_MB and can be
+ *               changed with the LITEFM_DIRCACHE_MB environment variable
+ *               (0 disables the cache).
+ *
+ *  Revision History:
+ *      <17/10/26> - Initial creation and function declarations added.
+ *
+ * ---------------------------------------------------------------------------
+ */
+
+#ifndef DIR_CACHE_H
+#define DIR_CACHE_H
+
+#include "entrystore.h"
+
+#include <stddef.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#define DIRCACHE_DEFAULT_MB  32
+#define DIRCACHE_MAX_ENTRIES 256 /* also bounds the number of inotify watches we hold */
+#define DIRCACHE_ENV_MB      "LITEFM_DIRCACHE_MB"
+
+/* Order tags of a cached listing, any other value is the caller's */
+#define DIRCACHE_UNSORTED 0
+#define DIRCACHE_BY_META  0x100 /* or'ed in when the order depends on entry metadata */
+
+typedef struct DirCacheEntry
+{
+  struct DirCacheEntry* prev; /* LRU list, most recently used first */
+  struct DirCacheEntry* next;
+  char*                 path;
+  int                   wd; /* inotify watch, -1 if it has to be validated with stat */
+  dev_t                 dev;
+  ino_t                 ino;
+  struct timespec       mtime;
+  size_t                bytes;
+  int                   order; /* tag of the order `items` are in */
+  EntryStore            items;
+} DirCacheEntry;
+
+typedef struct
+{
+  DirCacheEntry* head;
+  DirCacheEntry* tail;
+  int            inotify_fd;
+  size_t         entries;
+  size_t         bytes;
+  size_t         max_bytes;
+  unsigned long  hits;
+  unsigned long  misses;
+  unsigned long  evictions;
+  unsigned long  invalidations;
+} DirCache;
+
+size_t dircache_cap_from_env(void);
+void   dircache_init(DirCache* cache, size_t max_bytes);
+void   dircache_free(DirCache* cache);
+int    dircache_lookup(DirCache* cache, const char* path, EntryStore* out, int* order);
+int    dircache_contains(DirCache* cache, const char* path);
+void   dircache_insert(DirCache* cache, const char* path, const struct stat* scanned,
+                       const EntryStore* items, int order);
+void   dircache_set_order(DirCache* cache, const char* path, const EntryStore* items, int order);
+void   dircache_process_events(DirCache* cache);
+void   dircache_log_stats(const DirCache* cache);
+
+#endif
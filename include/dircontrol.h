@@ -51,17 +51,17 @@
 char* get_current_user();
 char* get_hostname();
 void  get_current_working_directory(char* cwd, size_t size);
-int   create_directory(const char* path, const char* dirname, char* timestamp);
+int   create_directory(int dir_fd, const char* dirname, char* timestamp);
 void  change_directory_with_popen(const char *path);
-int   remove_file(const char* path, const char* filename);
-int   remove_directory(const char* path, const char* dirname);
+int   remove_file(int dir_fd, const char* filename);
+int   remove_directory(int dir_fd, const char* dirname);
 int   remove_directory_recursive(const char* base_path, const char* dirname, int parent_fd);
-int   rename_file_or_dir(const char* old_path, const char* new_name);
-void  move_file_or_dir(WINDOW* win, const char* basepath, const char* current_path,
-                       const char* selected_item);
+int   rename_file_or_dir(int dir_fd, const char* old_name, const char* new_name);
+void  move_file_or_dir(WINDOW* win, int base_fd, const char* basepath, int current_fd,
+                       const char* current_path, const char* selected_item);
 int   is_directory(const char* path);
-void  handle_rename(WINDOW* win, const char* path);
-int   create_file(const char* path, const char* filename, char* timestamp);
+void  handle_rename(WINDOW* win, int dir_fd, const char* path, const char* name);
+int   create_file(int dir_fd, const char* filename, char* timestamp);
 void  resolve_path(const char* base_path, const char* relative_path, char* resolved_path);
 
 #endif
@@ -0,0 +1,91 @@
+// // // // // //
+//             //
+//   LITE FM   //
+//             //
+// // // // // //
+
+/*
+ * ---------------------------------------------------------------------------
+ *  File:        dirloader.h
+ *  Description: Lists a directory on a worker thread and hands the entries
+ *               to the UI thread in batches.
+ *
+ *  Author:      Siddharth Karanam
+ *  Created:     <17/10/26>
+ *
+ *  Copyright:   2024 nots1dd. All rights reserved.
+ *
+ *  License:     <GNU GPL v3>
+ *
+ *  Notes:       The worker never touches the UI's EntryStore. It fills a
+ *               private batch and publishes it into a mutex protected
+ *               pending store; `dirloader_drain` (UI thread only) moves the
+ *               pending entries into the visible store with
+ *               `entry_store_append_grouped`, so the listing is "dirs first"
+ *               at every point while it streams in.
+ *
+ *               Every scan is a heap allocated job shared between the
+ *               worker and the loader. Cancelling just flags the job and
+ *               drops the loader's reference, so leaving a directory that is
+ *               still being read (slow NFS, huge dirs) never blocks the UI.
+ *               Whoever drops the last reference frees the job.
+ *
+ *               With a notify fd set (an eventfd, see eventloop.h) the
+ *               worker also bumps it on every publish and when it is done,
+ *               so the UI can sleep until there is something to drain. A
+ *               cancelled job never touches it again.
+ *
+ *  Revision History:
+ *      <17/10/26> - Initial creation and function declarations added.
+ *
+ * ---------------------------------------------------------------------------
+ */
+
+#ifndef DIR_LOADER_H
+#define DIR_LOADER_H
+
+#include "entrystore.h"
+
+#include <limits.h>
+#include <stddef.h>
+#include <sys/stat.h>
+
+/* The first batch is kept small so the first screenful shows up right away */
+#define DIRLOADER_FIRST_BATCH 128
+#define DIRLOADER_BATCH       4096
+
+/* How long list_dir waits for a scan before it starts drawing partial results */
+#define DIRLOADER_GRACE_MS 15
+
+typedef enum
+{
+  DIRLOADER_IDLE,    /* no scan running */
+  DIRLOADER_LOADING, /* entries are still streaming in */
+  DIRLOADER_DONE,    /* the scan finished with this drain */
+  DIRLOADER_FAILED   /* the directory could not be opened/read */
+} DirLoaderState;
+
+typedef struct DirLoadJob DirLoadJob;
+
+typedef struct
+{
+  DirLoadJob* job;
+  /* What the last scan read. `stat` is taken on the open dir fd before reading,
+   * so a listing that was cut short or raced a change can be told apart */
+  char        path[PATH_MAX];
+  int         complete;  /* the last scan finished without errors */
+  int         notify_fd; /* eventfd bumped when there is something to drain, -1 if none */
+  struct stat stat;
+} DirLoader;
+
+void           dirloader_init(DirLoader* loader);
+void           dirloader_set_notify(DirLoader* loader, int notify_fd);
+int            dirloader_start(DirLoader* loader, int dir_fd, const char* name, const char* path);
+void           dirloader_cancel(DirLoader* loader);
+void           dirloader_wait(DirLoader* loader, int timeout_ms);
+int            dirloader_busy(const DirLoader* loader);
+size_t         dirloader_seen(const DirLoader* loader);
+DirLoaderState dirloader_drain(DirLoader* loader, EntryStore* items, int* highlight,
+                               size_t* added);
+
+#endif
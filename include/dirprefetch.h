@@ -0,0 +1,89 @@
+// // // // // //
+//             //
+//   LITE FM   //
+//             //
+// // // // // //
+
+/*
+ * ---------------------------------------------------------------------------
+ *  File:        dirprefetch.h
+ *  Description: Lists the highlighted subdirectory in the background while
+ *               the UI is idle, so that entering it is a cache hit.
+ *
+ *  Author:      Siddharth Karanam
+ *  Created:     <17/10/26>
+ *
+ *  Copyright:   2024 nots1dd. All rights reserved.
+ *
+ *  License:     <GNU GPL v3>
+ *
+ *  Notes:       The prefetcher owns a second DirLoader. Once the cursor has
+ *               rested on a directory for DIRPREFETCH_IDLE_MS, that
+ *               directory is scanned on the loader's worker thread and the
+ *               finished listing goes into the DirCache like any other.
+ *               `dirprefetch_timeout` tells the main loop when to wake up
+ *               for that, the scan itself wakes it through the loader's
+ *               notify fd.
+ *
+ *               - Rate limited: at most one scan is started every
+ *                 DIRPREFETCH_INTERVAL_MS, a target is only tried once until
+ *                 the cursor moves away from it, and scans that grow past
+ *                 DIRPREFETCH_MAX_ENTRIES are dropped.
+ *               - Cancellable: moving the cursor elsewhere cancels the scan
+ *                 (without waiting for the worker, see dirloader.h). If the
+ *                 user enters the directory while it is still being read,
+ *                 list_dir adopts the running scan instead of starting over.
+ *               - Network and FUSE filesystems (and autofs mount points,
+ *                 which would get mounted) are skipped unless
+ *                 LITEFM_PREFETCH=remote. LITEFM_PREFETCH=0 turns the
+ *                 prefetcher off.
+ *
+ *  Revision History:
+ *      <17/10/26> - Initial creation and function declarations added.
+ *
+ * ---------------------------------------------------------------------------
+ */
+
+#ifndef DIR_PREFETCH_H
+#define DIR_PREFETCH_H
+
+#include "dircache.h"
+#include "dirloader.h"
+#include "entrystore.h"
+
+#include <limits.h>
+#include <time.h>
+
+#define DIRPREFETCH_IDLE_MS     200  /* cursor has to rest this long */
+#define DIRPREFETCH_INTERVAL_MS 250  /* between two prefetch scans */
+#define DIRPREFETCH_MAX_ENTRIES 65536
+#define DIRPREFETCH_ENV         "LITEFM_PREFETCH"
+
+typedef struct
+{
+  DirLoader       loader;
+  EntryStore      items; /* what the running scan has delivered so far */
+  char            target[PATH_MAX]; /* last directory tried, "" if none */
+  int             enabled;
+  int             allow_remote;
+  int             waiting; /* a tick is due once the idle/interval delay has passed */
+  struct timespec idle_since;
+  struct timespec last_start;
+  unsigned long   started;
+  unsigned long   cached;
+  unsigned long   cancelled;
+  unsigned long   adopted;
+  unsigned long   skipped_remote;
+} DirPrefetch;
+
+void dirprefetch_init(DirPrefetch* pf);
+void dirprefetch_free(DirPrefetch* pf);
+void dirprefetch_touch(DirPrefetch* pf);
+int  dirprefetch_timeout(const DirPrefetch* pf);
+void dirprefetch_tick(DirPrefetch* pf, DirCache* cache, int dir_fd, const char* name,
+                      const char* target);
+void dirprefetch_collect(DirPrefetch* pf, DirCache* cache);
+int  dirprefetch_adopt(DirPrefetch* pf, const char* path, DirLoader* loader, EntryStore* items);
+void dirprefetch_log_stats(const DirPrefetch* pf);
+
+#endif
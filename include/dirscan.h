@@ -0,0 +1,53 @@
+// // // // // //
+//             //
+//   LITE FM   //
+//             //
+// // // // // //
+
+/*
+ * ---------------------------------------------------------------------------
+ *  File:        dirscan.h
+ *  Description: Single pass directory scanner built directly on the
+ *               getdents64 syscall.
+ *
+ *  Author:      Siddharth Karanam
+ *  Created:     <17/10/26>
+ *
+ *  Copyright:   2024 nots1dd. All rights reserved.
+ *
+ *  License:     <GNU GPL v3>
+ *
+ *  Notes:       Entries are classified from `d_type` as the kernel hands
+ *               them out. Only filesystems that report DT_UNKNOWN pay for
+ *               an extra `fstatat` per entry. Grouping (dirs first) is left
+ *               to the caller so that it can be done on whatever storage
+ *               the caller fills.
+ *
+ *  Revision History:
+ *      <17/10/26> - Initial creation and function declarations added.
+ *
+ * ---------------------------------------------------------------------------
+ */
+
+#ifndef DIR_SCAN_H
+#define DIR_SCAN_H
+
+#include <dirent.h>
+#include <stddef.h>
+
+/* 256 KiB per getdents64 call, big enough to pull ~8k entries per syscall */
+#define DIRSCAN_BUFFER_SIZE (256 * 1024)
+
+/* @DIRSCAN CALLBACK
+ *
+ * Called once per entry (excluding `.` and `..`) with the resolved DT_* type.
+ *
+ * Return 0 to continue scanning, anything else to stop early.
+ */
+typedef int (*DirScanFn)(void* data, const char* name, size_t name_len, unsigned char d_type);
+
+int           dirscan_fd(int dir_fd, int show_hidden, DirScanFn fn, void* data);
+int           dirscan_path(const char* path, int show_hidden, DirScanFn fn, void* data);
+unsigned char dirscan_mode_to_dtype(unsigned int st_mode);
+
+#endif
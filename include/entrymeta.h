@@ -0,0 +1,53 @@
+// // // // // //
+//             //
+//   LITE FM   //
+//             //
+// // // // // //
+
+/*
+ * ---------------------------------------------------------------------------
+ *  File:        entrymeta.h
+ *  Description: Lazy per entry metadata, fetched with statx only for the
+ *               rows that are (about to be) on screen.
+ *
+ *  Author:      Siddharth Karanam
+ *  Created:     <17/10/26>
+ *
+ *  Copyright:   2024 nots1dd. All rights reserved.
+ *
+ *  License:     <GNU GPL v3>
+ *
+ *  Notes:       Listing a directory only reads names and d_type. Size,
+ *               mode, owner etc. are asked for here, a window of rows at a
+ *               time, and kept in the EntryStore so redraws and the info
+ *               pane do not stat the same entry again. Symlink targets are
+ *               read the same way, only for rows that are about to be drawn.
+ *
+ *               An entry's MIME type is kept with its metadata too, see
+ *               entrymime.h.
+ *
+ *               statx is called relative to the directory's O_PATH fd (see
+ *               navctx.h) with AT_STATX_DONT_SYNC, so network filesystems
+ *               may answer from their attribute cache.
+ *
+ *  Revision History:
+ *      <17/10/26> - Initial creation and function declarations added.
+ *
+ * ---------------------------------------------------------------------------
+ */
+
+#ifndef ENTRY_META_H
+#define ENTRY_META_H
+
+#include "entrystore.h"
+
+#include <sys/stat.h>
+
+/* Rows above and below the viewport that get their metadata ahead of time */
+#define ENTRY_META_MARGIN 32
+
+int         entry_meta_fetch(EntryStore* store, int dir_fd, int first, int last);
+int         entry_meta_fetch_all(EntryStore* store, int dir_fd);
+void        entry_meta_to_stat(const EntryMeta* meta, struct stat* st);
+
+#endif
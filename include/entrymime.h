@@ -0,0 +1,47 @@
+// // // // // //
+//             //
+//   LITE FM   //
+//             //
+// // // // // //
+
+/*
+ * ---------------------------------------------------------------------------
+ *  File:        entrymime.h
+ *  Description: MIME types of listed entries, kept with their metadata.
+ *
+ *  Author:      Siddharth Karanam
+ *  Created:     <17/10/26>
+ *
+ *  Copyright:   2024 nots1dd. All rights reserved.
+ *
+ *  License:     <GNU GPL v3>
+ *
+ *  Notes:       An entry's MIME type is asked for once (entry_mime) by
+ *               whoever needs it first: the preview, the info pane or a key
+ *               handler. Rows on screen and the ones about to scroll in are
+ *               classified ahead of time, off the UI thread (see
+ *               mimepool.h), or as one batch (entry_mime_classify) when
+ *               there are no workers. The type is kept in the entry's
+ *               metadata (see entrymeta.h), so forgetting the metadata (the
+ *               file was edited...) forgets the type as well.
+ *
+ *               Kept apart from entrymeta.c so that listing, sorting and
+ *               their benchmarks do not pull in the classifier.
+ *
+ *  Revision History:
+ *      <17/10/26> - Initial creation and function declarations added.
+ *
+ * ---------------------------------------------------------------------------
+ */
+
+#ifndef ENTRY_MIME_H
+#define ENTRY_MIME_H
+
+#include "entrystore.h"
+
+int         entry_mime_classify(EntryStore* store, int dir_fd, int first, int last);
+const char* entry_mime(EntryStore* store, int dir_fd, int row);
+const char* entry_mime_known(const EntryStore* store, int row);
+int         entry_mime_keep(EntryStore* store, size_t record, const char* type);
+
+#endif
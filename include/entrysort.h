@@ -0,0 +1,72 @@
+// // // // // //
+//             //
+//   LITE FM   //
+//             //
+// // // // // //
+
+/*
+ * ---------------------------------------------------------------------------
+ *  File:        entrysort.h
+ *  Description: Sort modes for directory listings.
+ *
+ *  Author:      Siddharth Karanam
+ *  Created:     <17/10/26>
+ *
+ *  Copyright:   2024 nots1dd. All rights reserved.
+ *
+ *  License:     <GNU GPL v3>
+ *
+ *  Notes:       Sorting keeps the "dirs first" grouping and sorts each group
+ *               on its own. Keys are built once per sort into a flat array
+ *               of { 64 bit key, position } items. Only that array is
+ *               sorted and the records are permuted once at the end.
+ *
+ *               - name/extension: ASCII case folded key strings. The first
+ *                 8 bytes are packed big endian into the 64 bit key so most
+ *                 comparisons never touch the strings.
+ *               - natural: strverscmp on the case folded names
+ *                 ("file2" < "file10").
+ *               - size/mtime/dir order: stable LSD radix sort on the
+ *                 integer key, packed with the item index into 64 bits and
+ *                 sorted 11 bits a pass over only the bits the keys differ
+ *                 in. Dir order uses the name's arena offset, which grows in
+ *                 the order entries were read.
+ *
+ *               Reverse order is folded into the keys (complemented integer
+ *               keys, inverted comparisons), not a flip of the sorted
+ *               array: entries with equal keys keep listing order in both
+ *               directions, and entries without metadata stay on top.
+ *
+ *               Size and mtime need metadata for every entry, so only those
+ *               two modes stat the whole directory (see entrymeta.h). The
+ *               dir cache keeps listings in the order they were last sorted
+ *               in (see dircache.h), so a revisit in the same mode does not
+ *               sort, and does not stat, again.
+ *
+ *  Revision History:
+ *      <17/10/26> - Initial creation and function declarations added.
+ *
+ * ---------------------------------------------------------------------------
+ */
+
+#ifndef ENTRY_SORT_H
+#define ENTRY_SORT_H
+
+#include "entrystore.h"
+
+typedef enum
+{
+  SORT_DIR_ORDER, /* as the directory hands them out */
+  SORT_NAME,
+  SORT_NATURAL,
+  SORT_SIZE,
+  SORT_MTIME,
+  SORT_EXTENSION,
+  SORT_MODE_COUNT
+} SortMode;
+
+const char* entry_sort_label(SortMode mode);
+int         entry_sort_needs_meta(SortMode mode);
+int         entry_sort(EntryStore* store, int dir_fd, SortMode mode, int reverse, int* highlight);
+
+#endif
@@ -0,0 +1,196 @@
+// // // // // //
+//             //
+//   LITE FM   //
+//             //
+// // // // // //
+
+/*
+ * ---------------------------------------------------------------------------
+ *  File:        entrystore.h
+ *  Description: Growable store for directory listings. Fixed size records
+ *               point into a bump allocated string arena.
+ *
+ *  Author:      Siddharth Karanam
+ *  Created:     <17/10/26>
+ *
+ *  Copyright:   2024 nots1dd. All rights reserved.
+ *
+ *  License:     <GNU GPL v3>
+ *
+ *  Notes:       Replaces the old `FileItem items[MAX_ITEMS]` array which
+ *               reserved NAME_MAX bytes per slot on the stack. A listing now
+ *               costs its real name bytes plus one small record per entry
+ *               and has no upper bound on the number of entries.
+ *
+ *               Names are NUL terminated inside the arena, so the pointer
+ *               returned by `entry_store_name` can be handed to any C string
+ *               function. It stays valid until the next push, link or clear
+ *               (the arena may move when it grows).
+ *
+ *               Names are the entries' real names, whatever their type. The
+ *               target of a symlink is read lazily (see entrymeta.h) into the
+ *               same arena and the "name -> target" label only exists when a
+ *               row is drawn.
+ *
+ *               The store always holds the full listing, dot entries
+ *               included. What the UI sees is a view over it: "rows" are
+ *               the positions in that view, "records" the positions in the
+ *               listing. Without a filter the two are the same. With one
+ *               (entry_store_set_filter), `rows` maps each row to its record
+ *               in listing order, so switching a filter is one pass over the
+ *               records and needs no I/O.
+ *
+ *               Per entry metadata is NOT part of a listing. It is fetched
+ *               lazily (see entrymeta.h) into a side slab and each record
+ *               remembers its slot, so metadata follows the record when
+ *               entries get reordered. Copies and appends start without it.
+ *
+ *               What a row looks like is worked out once and kept in its
+ *               record: the kind (icon and color) when the entry is pushed,
+ *               the number of label bytes that fit on screen the first time
+ *               the row is drawn (entry_store_fit_labels). Fitted labels are
+ *               only thrown away when the available width changes, i.e. on
+ *               a terminal resize, or when a symlink's target comes in.
+ *
+ *               Once a regular file's MIME type is known its kind comes
+ *               from that instead (ENTRY_CLASSIFIED). With `mime_kinds` set
+ *               (types are being worked out in the background, see
+ *               mimepool.h) files that have none yet are drawn as plain
+ *               files rather than by an extension that may be wrong.
+ *
+ *  Revision History:
+ *      <17/10/26> - Initial creation and function declarations added.
+ *
+ * ---------------------------------------------------------------------------
+ */
+
+#ifndef ENTRY_STORE_H
+#define ENTRY_STORE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define ENTRY_STORE_INITIAL_RECORDS 256
+#define ENTRY_STORE_INITIAL_ARENA   (16 * 1024)
+
+typedef enum
+{
+  ENTRY_UNKNOWN = 0,
+  ENTRY_FILE,
+  ENTRY_DIR,
+  ENTRY_SYMLINK,
+  ENTRY_FIFO,
+  ENTRY_SOCKET,
+  ENTRY_CHARDEV,
+  ENTRY_BLOCKDEV
+} EntryType;
+
+/* What a row is drawn as (icon and color), see entry_kind_of */
+typedef enum
+{
+  ENTRY_KIND_FILE = 0,
+  ENTRY_KIND_DIR,
+  ENTRY_KIND_SYMLINK,
+  ENTRY_KIND_ARCHIVE,
+  ENTRY_KIND_AUDIO,
+  ENTRY_KIND_IMAGE,
+  ENTRY_KIND_VIDEO,
+  ENTRY_KIND_COUNT
+} EntryKind;
+
+#define ENTRY_LINK_READ  0x01 /* link_off/link_len hold the symlink's target */
+#define ENTRY_HIDDEN     0x02 /* dot entry */
+#define ENTRY_LABEL_FIT  0x04 /* label_len is fit to the store's label_cap */
+#define ENTRY_LABEL_CUT  0x08 /* the label is cut after label_len bytes and ends in "..." */
+#define ENTRY_CLASSIFIED 0x10 /* kind comes from the file's MIME type, not its extension */
+
+/* Label of a symlink whose target could not be read */
+#define ENTRY_UNKNOWN_TARGET "[unknown target]"
+
+/* Record flags a filter can leave out of the view */
+#define ENTRY_FILTERABLE ENTRY_HIDDEN
+
+typedef struct
+{
+  uint32_t name_off; /* offset of the name inside the string arena */
+  uint32_t name_len; /* length without the terminating NUL */
+  uint32_t meta;     /* 1 based slot in the metadata slab, 0 = not fetched yet */
+  uint32_t link_off; /* symlink target inside the arena, once ENTRY_LINK_READ is set */
+  uint32_t link_len; /* 0 if the target could not be read */
+  uint8_t  type;      /* EntryType as reported by the scanner */
+  uint8_t  flags;     /* ENTRY_* */
+  uint8_t  kind;      /* EntryKind, picked when the entry is pushed */
+  uint8_t  label_len; /* bytes of the label that fit, once ENTRY_LABEL_FIT is set */
+} EntryRecord;
+
+/* The subset of statx the UI shows, see entrymeta.h */
+typedef struct
+{
+  uint64_t size;
+  uint64_t ino;
+  int64_t  mtime;
+  uint32_t mode;
+  uint32_t uid;
+  uint32_t gid;
+  uint16_t valid; /* 0 if statx failed (entry gone, no permission...) */
+  uint16_t mime;  /* MIME type, a mimetype_intern id, 0 = not classified yet */
+} EntryMeta;
+
+typedef struct
+{
+  EntryRecord* records;
+  size_t       count;
+  size_t       capacity;
+  size_t       dir_count; /* records [0, dir_count) are the dirs/symlinks group */
+  char*        arena;     /* bump allocated, NUL separated names */
+  size_t       arena_len;
+  size_t       arena_cap;
+  EntryMeta*   meta;      /* lazily fetched, only grows with the rows that were shown */
+  size_t       meta_count;
+  size_t       meta_cap;
+  uint32_t*    rows;      /* record of each row, only used while `filter` is set */
+  size_t       row_count;
+  size_t       row_cap;
+  uint8_t      filter;    /* ENTRY_* flags of records left out of the view, 0 = show all */
+  int          label_cap; /* columns the labels were fit to, 0 = none yet */
+  uint8_t      mime_kinds; /* regular files show as plain files until ENTRY_CLASSIFIED */
+} EntryStore;
+
+void             entry_store_init(EntryStore* store);
+void             entry_store_free(EntryStore* store);
+void             entry_store_clear(EntryStore* store);
+int              entry_store_push(EntryStore* store, const char* name, size_t name_len,
+                                  EntryType type);
+int              entry_store_append_grouped(EntryStore* dst, const EntryStore* src);
+int              entry_store_copy(EntryStore* dst, const EntryStore* src);
+size_t           entry_store_footprint(const EntryStore* store);
+EntryType        entry_type_from_dtype(unsigned char d_type);
+EntryKind        entry_kind_of(const char* name, EntryType type);
+EntryKind        entry_kind_of_mime(const char* mime);
+
+/* By row, what the UI works with */
+int              entry_store_rows(const EntryStore* store);
+const char*      entry_store_name(const EntryStore* store, int row);
+int              entry_store_is_dir(const EntryStore* store, int row);
+EntryType        entry_store_type(const EntryStore* store, int row);
+const char*      entry_store_link(const EntryStore* store, int row);
+EntryKind        entry_store_kind(const EntryStore* store, int row);
+int              entry_store_label_len(const EntryStore* store, int row, int cap, int* cut);
+void             entry_store_fit_labels(EntryStore* store, int cap, int from_row, int to_row);
+const EntryMeta* entry_store_meta(const EntryStore* store, int row);
+void             entry_store_forget_meta(EntryStore* store, int row);
+
+/* By record, for code that works on the whole listing */
+size_t           entry_store_record(const EntryStore* store, int row);
+int              entry_store_row(const EntryStore* store, size_t record);
+const EntryMeta* entry_store_record_meta(const EntryStore* store, size_t record);
+int              entry_store_set_meta(EntryStore* store, size_t record, const EntryMeta* meta);
+int              entry_store_set_link(EntryStore* store, size_t record, const char* target,
+                                      size_t target_len);
+int              entry_store_set_mime(EntryStore* store, size_t record, uint16_t mime,
+                                      EntryKind kind);
+
+int              entry_store_set_filter(EntryStore* store, uint8_t filter);
+int              entry_store_update_view(EntryStore* store);
+
+#endif
@@ -0,0 +1,74 @@
+// // // // // //
+//             //
+//   LITE FM   //
+//             //
+// // // // // //
+
+/*
+ * ---------------------------------------------------------------------------
+ *  File:        eventloop.h
+ *  Description: Puts the UI thread to sleep until something happens: a key,
+ *               a signal, a background scan publishing entries, a change in
+ *               a watched directory or the periodic status tick.
+ *
+ *  Author:      Siddharth Karanam
+ *  Created:     <17/10/26>
+ *
+ *  Copyright:   2024 nots1dd. All rights reserved.
+ *
+ *  License:     <GNU GPL v3>
+ *
+ *  Notes:       One epoll instance over
+ *
+ *               - stdin, the keyboard.
+ *               - a signalfd for SIGWINCH and SIGCHLD. Both are blocked in
+ *                 every thread (the mask is set up before any worker is
+ *                 started and inherited by them), so they are only ever
+ *                 seen here. Children started with fork() get the old mask
+ *                 back. SIGCHLD is only a wake up, children are reaped by
+ *                 whoever started them.
+ *               - `wake_fd`, an eventfd the background workers write to
+ *                 whenever they have something for the UI (see
+ *                 dirloader_set_notify).
+ *               - an inotify fd added with `eventloop_watch` (the dir
+ *                 cache's). The caller drains it, the loop only reports it.
+ *               - a timerfd firing every `status_ms` for the status line.
+ *
+ *               `eventloop_wait` blocks until one of them is ready (or the
+ *               timeout passes) and returns the EVENT_* bits of what was.
+ *               With nothing going on the process does not wake up at all
+ *               in between two status ticks.
+ *
+ *  Revision History:
+ *      <17/10/26> - Initial creation and function declarations added.
+ *
+ * ---------------------------------------------------------------------------
+ */
+
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+
+#include <signal.h>
+
+#define EVENT_KEY    0x01 /* stdin is readable */
+#define EVENT_WAKE   0x02 /* a background worker has news */
+#define EVENT_RESIZE 0x04 /* SIGWINCH */
+#define EVENT_CHILD  0x08 /* SIGCHLD */
+#define EVENT_FS     0x10 /* the watched inotify fd is readable */
+#define EVENT_TIMER  0x20 /* status tick */
+
+typedef struct
+{
+  int epoll_fd;
+  int signal_fd;
+  int wake_fd;
+  int timer_fd;
+  int watch_fd; /* inotify fd added with eventloop_watch, -1 if none */
+} EventLoop;
+
+int      eventloop_init(EventLoop* loop, int status_ms);
+void     eventloop_free(EventLoop* loop);
+void     eventloop_watch(EventLoop* loop, int fd);
+unsigned eventloop_wait(EventLoop* loop, int timeout_ms);
+
+#endif
@@ -0,0 +1,103 @@
+// // // // // //
+//             //
+//   LITE FM   //
+//             //
+// // // // // //
+
+/*
+ * ---------------------------------------------------------------------------
+ *  File:        exttable.h
+ *  Description: What LiteFM knows about a file from its extension: the
+ *               category it is drawn as, the archive format, a MIME hint
+ *               and the syntax highlighting language.
+ *
+ *  Author:      Siddharth Karanam
+ *  Created:     <17/10/26>
+ *
+ *  Copyright:   2024 nots1dd. All rights reserved.
+ *
+ *  License:     <GNU GPL v3>
+ *
+ *  Notes:       The extensions are listed once, in exttable.def. The
+ *               generator in tools/exttable_gen.c turns that list into a
+ *               perfect hash table (exttable_gen.h): it searches for a seed
+ *               under which `ext_hash` gives every extension its own slot,
+ *               so a lookup is one hash of the extension, one slot and one
+ *               compare. The header is generated as part of the build, into
+ *               the build directory (include/ for the Makefile), whenever
+ *               exttable.def changes.
+ *
+ *               Only the last extension counts ("foo.zip.txt" is text,
+ *               "foo.tar.gz" a gzip archive) and ASCII case is ignored.
+ *
+ *  Revision History:
+ *      <17/10/26> - Initial creation and function declarations added.
+ *
+ * ---------------------------------------------------------------------------
+ */
+
+#ifndef EXT_TABLE_H
+#define EXT_TABLE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define EXT_MAX_LEN 8 /* longer extensions are never in the table */
+
+typedef enum
+{
+  EXT_CATEGORY_NONE = 0,
+  EXT_CATEGORY_TEXT,
+  EXT_CATEGORY_ARCHIVE,
+  EXT_CATEGORY_AUDIO,
+  EXT_CATEGORY_IMAGE,
+  EXT_CATEGORY_VIDEO
+} ExtCategory;
+
+typedef enum
+{
+  EXT_ARCHIVE_NONE = 0,
+  EXT_ARCHIVE_ZIP,
+  EXT_ARCHIVE_TAR,
+  EXT_ARCHIVE_GZIP,
+  EXT_ARCHIVE_XZ,
+  EXT_ARCHIVE_BZIP2,
+  EXT_ARCHIVE_SEVENZIP
+} ExtArchive;
+
+typedef struct
+{
+  const char* ext;      /* lower case, without the dot */
+  uint8_t     len;
+  uint8_t     category; /* ExtCategory */
+  uint8_t     archive;  /* ExtArchive */
+  const char* mime;     /* MIME hint, NULL if none */
+  const char* syntax;   /* keywords/<syntax>-keywords.yaml, NULL if none */
+} ExtInfo;
+
+/*
+ * FNV-1a over the ASCII lower cased extension, shared with the generator.
+ * The final mix makes the low bits (the slot) depend on all of the seed.
+ */
+static inline uint32_t ext_hash(const char* ext, size_t len, uint32_t seed)
+{
+  uint32_t h = 2166136261u ^ seed;
+  for (size_t i = 0; i < len; i++)
+  {
+    unsigned char c = (unsigned char)ext[i];
+    if (c >= 'A' && c <= 'Z')
+      c += 'a' - 'A';
+    h = (h ^ c) * 16777619u;
+  }
+  h ^= h >> 16;
+  h *= 0x7feb352du;
+  h ^= h >> 15;
+  return h;
+}
+
+const ExtInfo* ext_lookup(const char* filename);
+const ExtInfo* ext_lookup_ext(const char* ext, size_t len);
+const char*    ext_syntax_for_mime(const char* mime);
+ExtCategory    ext_category_for_mime(const char* mime);
+
+#endif
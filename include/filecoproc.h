@@ -0,0 +1,91 @@
+// // // // // //
+//             //
+//   LITE FM   //
+//             //
+// // // // // //
+
+/*
+ * ---------------------------------------------------------------------------
+ *  File:        filecoproc.h
+ *  Description: One long lived `file` process that MIME types are asked
+ *               from, for builds (or hosts) without libmagic.
+ *
+ *  Author:      Siddharth Karanam
+ *  Created:     <17/10/26>
+ *
+ *  Copyright:   2024 nots1dd. All rights reserved.
+ *
+ *  License:     <GNU GPL v3>
+ *
+ *  Notes:       `file --brief --mime-type --dereference -n -f -` is started
+ *               on first use and reads one path per line from its stdin,
+ *               answering one line each (-n flushes every answer).
+ *
+ *               The paths we send are /proc/<our pid>/fd/<fd> for files we
+ *               already opened, so no file name ever goes down the pipe
+ *               (names with newlines would break the protocol) and the
+ *               answer is about the very file we opened. --dereference
+ *               makes `file` follow that magic link.
+ *
+ *               Requests are pipelined: a batch of up to FILECOPROC_BATCH
+ *               paths is written at once and then the answers are read, one
+ *               round trip per batch however many files are in it.
+ *
+ *               The process is restarted when it dies (or stops answering
+ *               within FILECOPROC_TIMEOUT_MS, it is killed then).
+ *               `filecoproc_classify` returns how many answers it got, the
+ *               caller decides what to do about the rest. An answer that
+ *               is not a `type/subtype` token is `file` saying it could not
+ *               open the path (a restricted /proc, hidepid...): it is not
+ *               counted and its entry is left empty for the caller to
+ *               classify another way. After FILECOPROC_MAX_FAILS round
+ *               trips in a row without a single MIME type (no `file`, no
+ *               /proc...) it gives up for the session.
+ *
+ *               Its stdin is a socket written with MSG_NOSIGNAL, a dead
+ *               coprocess never gets us a SIGPIPE.
+ *
+ *               A FileCoproc is one such process and belongs to one thread
+ *               (each classification worker has its own, see mimepool.h).
+ *
+ *  Revision History:
+ *      <17/10/26> - Initial creation and function declarations added.
+ *
+ * ---------------------------------------------------------------------------
+ */
+
+#ifndef FILE_COPROC_H
+#define FILE_COPROC_H
+
+#include <stddef.h>
+
+#define FILECOPROC_BATCH      32
+#define FILECOPROC_TIMEOUT_MS 5000
+#define FILECOPROC_MAX_FAILS  3
+#define FILECOPROC_ANSWER_MAX 256
+
+#include <sys/types.h>
+
+typedef struct
+{
+  pid_t         pid;  /* -1 while not running */
+  int           to;   /* its stdin, a socket */
+  int           from; /* its stdout */
+  char          buf[FILECOPROC_BATCH * FILECOPROC_ANSWER_MAX];
+  size_t        len;  /* answers read but not handed out yet */
+  int           fails; /* round trips in a row that did not get a single MIME type */
+  int           disabled;
+  unsigned long starts;
+  unsigned long round_trips;
+  unsigned long answers;
+  unsigned long rejected; /* answers that were not MIME types */
+} FileCoproc;
+
+void   filecoproc_init(FileCoproc* coproc);
+int    filecoproc_is_mime_type(const char* answer);
+size_t filecoproc_classify(FileCoproc* coproc, const int* fds, size_t count,
+                           char (*types)[FILECOPROC_ANSWER_MAX]);
+void   filecoproc_stop(FileCoproc* coproc);
+void   filecoproc_log_stats(const FileCoproc* coproc, const char* who);
+
+#endif
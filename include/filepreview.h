@@ -47,13 +47,13 @@
 #include <sys/wait.h>
 #include <unistd.h>
 
+#include "exttable.h"
 #include "highlight.h"
 
 // Constants
 
 #define MAX_LINES            60  // Define the maximum number of lines to display
 #define MAX_LINE_LENGTH      256 // Define the maximum line length
-#define MAX_FILE_HEADER_SIZE 18  // Maximum size needed for the longest signature
 #define BUFFER_SIZE          1024
 #define MAX_FILE_TYPE_LENGTH 256
 
@@ -112,14 +112,14 @@
 
 // Function Prototypes
 const char* get_file_extension(const char* filename);
-void        display_file(WINDOW* info_win, const char* filename);
+void        display_file(WINDOW* info_win, const char* filename, const char* mime);
 const char* determine_file_type(const char* filename);
-const char* is_readable_extension(const char* filename, const char* current_path);
+const char* preview_class(const char* mime);
 const char* format_file_size(off_t size);
 int         is_image(const char* filename);
 int         is_audio(const char* filename);
 void launch_env_var(WINDOW* win, const char* current_path, const char* filename, const char* type);
 void print_permissions(WINDOW* info_win, struct stat* file_stat);
-void display_archive_contents(WINDOW* info_win, const char* full_path, const char* file_ext);
+void display_archive_contents(WINDOW* info_win, const char* full_path, ExtArchive format);
 
 #endif // FILEPREVIEW_H
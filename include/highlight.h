@@ -10,15 +10,14 @@
 #include <yaml.h>
 
 #include "hashtable.h"
+#include "syntax.h"
 
 // Function prototypes
 bool load_syntax(const char* path, HashTable* keywords, HashTable* singlecomments,
                  HashTable* multicomments1, HashTable* multicomments2, HashTable* strings,
                  HashTable* functions, HashTable* symbols, HashTable* operators,
                  int* singlecommentslen);
-void highlight_code(WINDOW* win, int start_y, int start_x, const char* code, HashTable* keywords,
-                    HashTable* singlecomments, HashTable* multicomments1, HashTable* multicomments2,
-                    HashTable* strings, HashTable* functions, HashTable* symbols,
-                    HashTable* operators, int* singlecommentslen);
+void highlight_code(WINDOW* win, int start_y, int start_x, const char* code,
+                    const Syntax* syntax);
 
 #endif
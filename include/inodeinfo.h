@@ -17,9 +17,8 @@
  *
  *  License:     <GNU GPL v3>
  *
- *  Notes:       inodeinfo also has the function `truncate_symlink_name`.
- *               It made sense as the function is only required in two areas;
- *               in string search, and for proper file info retreival
+ *  Notes:       Functions here take the entry's real name, symlinks are
+ *               not "name -> target" labels anymore (see entrystore.h).
  *
  *  Revision History:
  *      <29/08/24> - Initial creation and function declarations added.
@@ -31,16 +30,19 @@
 #define INODE_INFO_H
 
 #include <dirent.h>
+#include <fcntl.h>
 #include <grp.h>
 #include <ncurses.h>
 #include <stdio.h>
+#include <sys/stat.h>
 
 #define MAX_ITEM_NAME_LENGTH 80
 
 int cap_label_length(unsigned int len, unsigned int quarter, unsigned int margin);
-void get_file_info_popup(WINDOW* main_win, const char* path, const char* filename);
-void get_file_info(WINDOW* info_win, const char* path, const char* filename);
-void truncate_symlink_name(char* name);
-int  is_symlink(const char* path);
+void get_file_info_popup(WINDOW* main_win, int dir_fd, const char* path, const char* filename,
+                         const char* mime);
+void get_file_info(WINDOW* info_win, int dir_fd, const char* path, const char* filename,
+                   const struct stat* cached, const char* mime);
+int  is_symlink(int dir_fd, const char* name);
 
 #endif
@@ -28,6 +28,8 @@
 #ifndef KB_INPUT_H
 #define KB_INPUT_H
 
+#include "entrystore.h"
+#include "navctx.h"
 #include "structs.h"
 #include <libgen.h>
 #include <ncurses.h>
@@ -38,28 +40,28 @@
 
 void handleInputScrollUp(int* highlight, int* scroll_position);
 void handleInputScrollDown(int* highlight, int* scroll_position, int* item_count, int* height);
-void handleInputToggleHidden(int* show_hidden, int* scroll_position, int* highlight);
+void handleInputToggleHidden(int* show_hidden, EntryStore* items, int* item_count, int* highlight,
+                             int* scroll_position);
 void handleInputMovCursBtm(int* highlight, int* item_count, int* scroll_position, int* max_y);
 void handleInputMovCursTop(int* highlight, int* scroll_position);
-void handleInputGoToDir(const char* current_path, const char* path, int* highlight,
-                        int* scroll_position);
+int  handleInputGoToDir(NavContext* nav, const char* path, int* highlight, int* scroll_position);
 void handleInputRename(int* item_count, int* highlight, int* scroll_position,
-                       const char* current_path, FileItem items[]);
-int  find_item(const char* query, FileItem items[], int* item_count, int* start_index,
+                       const NavContext* nav, const EntryStore* items);
+int  find_item(const char* query, const EntryStore* items, int* item_count, int* start_index,
                int direction);
-void handleInputStringSearch(WINDOW* win, FileItem items[], int* item_count, int* highlight,
-                             int* scroll_position, int* height, char* last_query,
+void handleInputStringSearch(WINDOW* win, const EntryStore* items, int* item_count,
+                             int* highlight, int* scroll_position, int* height, char* last_query,
                              const char* current_path);
-void handleInputStringOccurance(int direction, const char* last_query, FileItem items[],
+void handleInputStringOccurance(int direction, const char* last_query, const EntryStore* items,
                                 int* item_count, int* highlight, int* scroll_position, int* height);
-void handleInputExtractArchive(WINDOW* win, FileItem items[], const char* current_path,
+void handleInputExtractArchive(WINDOW* win, const EntryStore* items, const char* current_path,
                                const char* last_query, int* scroll_position, int* highlight);
-void handleInputCompressInode(WINDOW* win, FileItem items[], const char* current_path,
+void handleInputCompressInode(WINDOW* win, const EntryStore* items, const char* current_path,
                               int* highlight, int* scroll_position);
 /* ------------------------------
  * void handleInputScopeBack(int* history_count, int* highlight, int* scroll_position, const char*
  * current_path, DirHistory history[]); void handleInputScopeForward(WINDOW *win, WINDOW *info_win,
- * int *history_count, int *highlight, int *scroll_position, bool *firstKeyPress, FileItem items[],
+ * int *history_count, int *highlight, int *scroll_position, bool *firstKeyPress, EntryStore* items,
  * DirHistory history[], const char* cur_user, const char* current_path);
  * ----------------------------- */
 
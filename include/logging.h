@@ -31,6 +31,9 @@
  *               system permissions allow the creation and modification of
  *               files in the specified log directory.
  *
+ *               log_message is safe to call from any thread: each record
+ *               is one write() on an O_APPEND descriptor.
+ *
  *  Revision History:
  *      <31/07/24> - Initial creation and function declarations added.
  *
@@ -55,6 +58,9 @@
 #define LOG_DIR_RELATIVE_PATH  ".cache/litefm/log"
 #define LOG_FILE_RELATIVE_PATH ".cache/litefm/log/litefm.log"
 
+// Longest record written in one go, longer messages are cut
+#define LOG_LINE_MAX 4096
+
 // Logging levels
 typedef enum
 {
@@ -65,7 +71,7 @@ typedef enum
 } LogLevel;
 
 // Function declarations
-const char* current_time_str();
+const char* current_time_str(char* buffer, size_t buffer_size);
 const char* get_home_directory();
 void        get_log_directory_path(char* buffer, size_t buffer_size);
 void        get_log_file_path(char* buffer, size_t buffer_size);
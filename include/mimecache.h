@@ -0,0 +1,75 @@
+// // // // // //
+//             //
+//   LITE FM   //
+//             //
+// // // // // //
+
+/*
+ * ---------------------------------------------------------------------------
+ *  File:        mimecache.h
+ *  Description: MIME types that were already worked out, kept on disk so
+ *               that rescrolling a directory (or the next LiteFM session)
+ *               does not identify every file again.
+ *
+ *  Author:      Siddharth Karanam
+ *  Created:     <17/10/26>
+ *
+ *  Copyright:   2024 nots1dd. All rights reserved.
+ *
+ *  License:     <GNU GPL v3>
+ *
+ *  Notes:       One file, MIMECACHE_RELATIVE_PATH under $HOME, mapped
+ *               MAP_SHARED: a small header and MIMECACHE_SLOTS fixed size
+ *               slots, open addressed by (dev, ino) with a probe window of
+ *               MIMECACHE_PROBE. A slot holds the file's (dev, ino, size,
+ *               mtime in ns) and its MIME type. A hit needs all four to
+ *               match, so a rewritten file is simply a miss and its slot is
+ *               reused on the next insert.
+ *
+ *               Every LiteFM instance maps the same file. Each slot has a
+ *               sequence counter (a seqlock): a writer claims the slot by
+ *               making it odd with a compare-and-swap and makes it even
+ *               again when done, readers never block and count a slot
+ *               that changed under them as a miss. Two writers never touch
+ *               the same slot at once, the loser simply does not cache.
+ *               Threads of one instance go through the same protocol, so
+ *               lookups and inserts are safe from any thread once
+ *               `mimecache_init` returned.
+ *
+ *               Entries carry the time they were stored or last hit (the
+ *               latter refreshed at most daily, so reads hardly dirty
+ *               pages). Entries older than MIMECACHE_MAX_AGE_DAYS are
+ *               misses, and an insert into a full probe window replaces
+ *               the oldest entry in it.
+ *
+ *               If the file cannot be created or mapped (no $HOME, read
+ *               only home...) the cache is off and every lookup misses.
+ *               A file with another layout (version, slot count) is
+ *               replaced: a new one is renamed over it, so an instance that
+ *               still maps the old one (an older build) keeps using it.
+ *
+ *  Revision History:
+ *      <17/10/26> - Initial creation and function declarations added.
+ *
+ * ---------------------------------------------------------------------------
+ */
+
+#ifndef MIME_CACHE_H
+#define MIME_CACHE_H
+
+#include <stddef.h>
+#include <sys/stat.h>
+
+#define MIMECACHE_RELATIVE_PATH ".cache/litefm/mimetypes.cache"
+#define MIMECACHE_SLOTS         16384 /* 2 MiB of 128 byte slots */
+#define MIMECACHE_PROBE         8
+#define MIMECACHE_MIME_MAX      88 /* longer MIME types are not cached */
+#define MIMECACHE_MAX_AGE_DAYS  30
+
+int  mimecache_init(void);
+void mimecache_free(void);
+int  mimecache_lookup(const struct stat* st, char* mime, size_t mime_size);
+void mimecache_insert(const struct stat* st, const char* mime);
+void mimecache_log_stats(void);
+
+#endif
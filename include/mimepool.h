@@ -0,0 +1,124 @@
+// // // // // //
+//             //
+//   LITE FM   //
+//             //
+// // // // // //
+
+/*
+ * ---------------------------------------------------------------------------
+ *  File:        mimepool.h
+ *  Description: A few worker threads that work out the MIME types of the
+ *               rows on screen, and of the ones about to scroll in, off the
+ *               UI thread.
+ *
+ *  Author:      Siddharth Karanam
+ *  Created:     <17/10/26>
+ *
+ *  Copyright:   2024 nots1dd. All rights reserved.
+ *
+ *  License:     <GNU GPL v3>
+ *
+ *  Notes:       Each worker has a MimeClassifier of its own (its own magic
+ *               cookie, or its own `file` coprocess, see mimetype.h) and
+ *               takes up to MIMETYPE_BATCH queued entries at a time, so a
+ *               batch is one coprocess round trip.
+ *
+ *               `mimepool_request` (UI thread) replaces the entries nobody
+ *               took yet with the ones that matter now: the highlighted
+ *               row, the rest of the viewport, then MIMEPOOL_LOOKAHEAD rows
+ *               in the direction the list last scrolled. Rows that already
+ *               have a type, or are being worked on, are left out. Only
+ *               rows with metadata are asked for (see entrymeta.h), the
+ *               type is kept with it.
+ *
+ *               An entry is known by its metadata slot, which stays with it
+ *               when the listing gets sorted or dirs stream in above it.
+ *               Workers post what they found and bump `notify_fd` (see
+ *               eventloop.h), `mimepool_collect` (UI thread) puts the types
+ *               into the EntryStore, the only place it is ever touched.
+ *
+ *               `mimepool_cancel` is for when the listing is thrown away
+ *               (another directory, a re-list): queued entries are dropped
+ *               and whatever a worker is still busy with is thrown away
+ *               when it comes back. The directory is held through a dup of
+ *               its fd, until the last worker using it is done.
+ *
+ *               Workers are only waited for MIMEPOOL_STOP_MS in
+ *               `mimepool_free`: one may be stuck reading a file on a dead
+ *               mount. A MimePool has to be static, and if `mimepool_free`
+ *               reports a worker left behind, the MIME type state it uses
+ *               (mimetype_free) must be left alone too.
+ *
+ *  Revision History:
+ *      <17/10/26> - Initial creation and function declarations added.
+ *
+ * ---------------------------------------------------------------------------
+ */
+
+#ifndef MIME_POOL_H
+#define MIME_POOL_H
+
+#include "entrymeta.h"
+#include "entrystore.h"
+#include "mimetype.h"
+
+#include <limits.h>
+#include <pthread.h>
+#include <stdint.h>
+
+#define MIMEPOOL_WORKERS   2
+#define MIMEPOOL_QUEUE     256               /* entries waiting for a worker, at most */
+#define MIMEPOOL_LOOKAHEAD ENTRY_META_MARGIN /* rows past the viewport, those have metadata */
+#define MIMEPOOL_STOP_MS   200
+
+typedef struct MimePoolDir MimePoolDir;
+
+typedef struct
+{
+  uint32_t slot;   /* metadata slot of the entry (EntryRecord.meta) */
+  uint32_t record; /* where the entry was when it was asked for, tried first */
+  char     name[NAME_MAX + 1];
+} MimePoolJob;
+
+typedef struct
+{
+  uint32_t slot;
+  uint32_t record;
+  char     type[MIMETYPE_MAX];
+} MimePoolResult;
+
+typedef struct
+{
+  pthread_mutex_t lock;
+  pthread_cond_t  work;      /* jobs were queued, or the workers should stop */
+  pthread_cond_t  gone;      /* a worker left */
+  int             notify_fd; /* bumped when there are results, -1 if none */
+  int             workers;   /* running */
+  int             stopping;
+  unsigned        generation; /* bumped by every cancel */
+  MimePoolDir*    dir;        /* what the queued names are relative to, NULL if none yet */
+  MimePoolJob     queue[MIMEPOOL_QUEUE];
+  size_t          queued;
+  /* Slots each worker is busy with, and the generation they belong to */
+  uint32_t        busy[MIMEPOOL_WORKERS][MIMETYPE_BATCH];
+  size_t          busy_count[MIMEPOOL_WORKERS];
+  unsigned        busy_generation[MIMEPOOL_WORKERS];
+  MimePoolResult  results[MIMEPOOL_QUEUE];
+  size_t          result_count;
+  int             direction; /* of the last scroll, 1 down, -1 up */
+  int             last_first;
+  unsigned long   requested; /* entries queued */
+  unsigned long   collected; /* types that made it into the store */
+  unsigned long   discarded; /* came back for a listing that was gone */
+} MimePool;
+
+int  mimepool_init(MimePool* pool, int notify_fd);
+int  mimepool_running(const MimePool* pool);
+void mimepool_request(MimePool* pool, const EntryStore* store, int dir_fd, int highlight,
+                      int first, int last);
+int  mimepool_collect(MimePool* pool, EntryStore* store);
+void mimepool_cancel(MimePool* pool);
+void mimepool_log_stats(MimePool* pool);
+int  mimepool_free(MimePool* pool);
+
+#endif
@@ -0,0 +1,103 @@
+// // // // // //
+//             //
+//   LITE FM   //
+//             //
+// // // // // //
+
+/*
+ * ---------------------------------------------------------------------------
+ *  File:        mimetype.h
+ *  Description: MIME type of a file from its content, what
+ *               `file --brief --mime-type` would say.
+ *
+ *  Author:      Siddharth Karanam
+ *  Created:     <17/10/26>
+ *
+ *  Copyright:   2024 nots1dd. All rights reserved.
+ *
+ *  License:     <GNU GPL v3>
+ *
+ *  Notes:       Built with LITEFM_HAVE_LIBMAGIC (the build systems define it
+ *               when pkg-config finds libmagic), the magic database is
+ *               loaded once in `mimetype_init` and files are identified in
+ *               process with magic_descriptor on an fd we opened. Without
+ *               libmagic, or if the database cannot be loaded, they go to
+ *               one long lived `file` process instead (see filecoproc.h),
+ *               and only if that cannot be run is `file` run once per file
+ *               on the fd (as its stdin). `file` is exec'd directly, no
+ *               shell ever sees a file name.
+ *
+ *               `mimetype_classify_at` takes a batch of entries, the
+ *               leftovers among them go to the coprocess together: one
+ *               round trip for all the visible rows of a directory.
+ *
+ *               Either is only asked about the leftovers: the first
+ *               SNIFF_BYTES of the file go through the signature table in
+ *               sniff.h first, which settles images, audio, video, archives,
+ *               ELF files, scripts and text with a known extension on its own.
+ *
+ *               Answers for regular files are kept in the persistent cache
+ *               (mimecache.h) keyed by inode, size and mtime, a file seen
+ *               before is not even opened again.
+ *
+ *               Like `file`, symlinks are not followed ("inode/symlink") and
+ *               directories, devices, fifos, sockets and empty files are
+ *               told apart by their stat alone, nothing is opened for them.
+ *
+ *               `mimetype_at` returns a static buffer that the next call
+ *               overwrites. `mimetype_intern` turns a type into a small id
+ *               that lasts the session, for keeping it per entry. Both are
+ *               for the UI thread only.
+ *
+ *               A magic cookie and a coprocess are not thread safe, they
+ *               make up a MimeClassifier and a thread that classifies files
+ *               (see mimepool.h) sets up one of its own and calls
+ *               `mimetype_classify_into`, which only writes to the caller's
+ *               buffers. The functions above share the UI thread's.
+ *
+ *  Revision History:
+ *      <17/10/26> - Initial creation and function declarations added.
+ *
+ * ---------------------------------------------------------------------------
+ */
+
+#ifndef MIME_TYPE_H
+#define MIME_TYPE_H
+
+#include "filecoproc.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define MIMETYPE_MAX        256
+#define MIMETYPE_INTERN_MAX 1024 /* distinct types per session that get an id */
+#define MIMETYPE_BATCH      32   /* leftovers kept open at once, one coprocess round trip */
+#define MIMETYPE_PENDING    "Pending" /* shown while a worker is still on it (see mimepool.h) */
+
+typedef struct
+{
+  void*         magic;      /* magic_t, NULL without libmagic (or a usable database) */
+  FileCoproc    coproc;     /* used when there is no cookie */
+  unsigned long classified; /* every question asked, answered from the cache or not */
+  unsigned long sniffed;    /* settled by the signature table */
+  unsigned long leftovers;  /* left to libmagic or `file` */
+} MimeClassifier;
+
+int         mimetype_classifier_init(MimeClassifier* classifier);
+void        mimetype_classifier_free(MimeClassifier* classifier);
+void        mimetype_classifier_log_stats(const MimeClassifier* classifier, const char* who);
+void        mimetype_classify_into(MimeClassifier* classifier, int dir_fd,
+                                   const char* const* names, size_t count,
+                                   char (*types)[MIMETYPE_MAX]);
+
+int         mimetype_init(void);
+void        mimetype_free(void);
+void        mimetype_log_stats(unsigned long keys);
+const char* mimetype_of_fd(int fd);
+const char* mimetype_at(int dir_fd, const char* name);
+void        mimetype_classify_at(int dir_fd, const char* const* names, size_t count,
+                                 const char** types);
+uint16_t    mimetype_intern(const char* type);
+const char* mimetype_name(uint16_t id);
+
+#endif
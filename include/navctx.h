@@ -0,0 +1,67 @@
+// // // // // //
+//             //
+//   LITE FM   //
+//             //
+// // // // // //
+
+/*
+ * ---------------------------------------------------------------------------
+ *  File:        navctx.h
+ *  Description: Navigation context, the current directory and its ancestors
+ *               held open as O_PATH fds.
+ *
+ *  Author:      Siddharth Karanam
+ *  Created:     <17/10/26>
+ *
+ *  Copyright:   2024 nots1dd. All rights reserved.
+ *
+ *  License:     <GNU GPL v3>
+ *
+ *  Notes:       fds[0] is "/" and fds[depth - 1] the current directory.
+ *               Everything that works on an entry of the current directory
+ *               (listing, stat, unlink, rename, mkdir, ...) goes through the
+ *               *at() syscalls relative to `navctx_fd`, so the kernel never
+ *               walks the full path again and the length of the path does
+ *               not matter.
+ *
+ *               Entering a directory opens one component, going to the
+ *               parent just closes the top fd. `navctx_open` (goto, home,
+ *               history) keeps the fds the old and the new path have in
+ *               common and only opens the rest.
+ *
+ *               `path` is kept next to the fds for display, logging and as
+ *               the directory cache key. It is the logical path (like the
+ *               shell's $PWD): ".." removes the last component, so leaving
+ *               a directory entered through a symlink goes back to where the
+ *               symlink is.
+ *
+ *  Revision History:
+ *      <17/10/26> - Initial creation and function declarations added.
+ *
+ * ---------------------------------------------------------------------------
+ */
+
+#ifndef NAV_CTX_H
+#define NAV_CTX_H
+
+#include <limits.h>
+#include <stddef.h>
+
+typedef struct
+{
+  int*   fds;
+  size_t depth;
+  size_t capacity;
+  char   path[PATH_MAX];
+} NavContext;
+
+void        navctx_init(NavContext* nav);
+void        navctx_free(NavContext* nav);
+int         navctx_open(NavContext* nav, const char* path);
+int         navctx_enter(NavContext* nav, const char* name);
+int         navctx_leave(NavContext* nav);
+int         navctx_fd(const NavContext* nav);
+int         navctx_dup(const NavContext* nav);
+const char* navctx_path(const NavContext* nav);
+
+#endif
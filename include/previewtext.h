@@ -0,0 +1,66 @@
+// // // // // //
+//             //
+//   LITE FM   //
+//             //
+// // // // // //
+
+/*
+ * ---------------------------------------------------------------------------
+ *  File:        previewtext.h
+ *  Description: Reads just enough of a file to fill the preview pane, for
+ *               the highlighter and the plain text preview.
+ *
+ *  Author:      Siddharth Karanam
+ *  Created:     <17/10/26>
+ *
+ *  Copyright:   2024 nots1dd. All rights reserved.
+ *
+ *  License:     <GNU GPL v3>
+ *
+ *  Notes:       `previewtext_read` preads the file PREVIEWTEXT_CHUNK bytes
+ *               at a time into one buffer kept for the session and finds
+ *               the line ends of every chunk with memchr as it comes in. It
+ *               stops at the first of: `max_lines` lines (what the pane can
+ *               show), `max_bytes` (what the pane can show of long lines, at
+ *               most PREVIEWTEXT_MAX_BYTES), end of file. Nothing past that
+ *               is read, so previewing a huge file or one long minified line
+ *               costs the same as a small one.
+ *
+ *               The text is handed out where it was read to, NUL terminated
+ *               right after the last line, and stays valid until the next
+ *               read. A NUL in the file ends the text for the highlighter
+ *               as it always did.
+ *
+ *               The file is not mmap'ed: one that shrinks while mapped
+ *               (a log rotated with copytruncate) would take the whole file
+ *               manager down with SIGBUS, and the few KiB a pane needs are
+ *               cheaper to pread than to map and unmap.
+ *
+ *               UI thread only.
+ *
+ *  Revision History:
+ *      <17/10/26> - Initial creation and function declarations added.
+ *
+ * ---------------------------------------------------------------------------
+ */
+
+#ifndef PREVIEW_TEXT_H
+#define PREVIEW_TEXT_H
+
+#include <stddef.h>
+
+#define PREVIEWTEXT_CHUNK     4096        /* bytes per pread */
+#define PREVIEWTEXT_MAX_BYTES (64 * 1024) /* of a file read for one preview, at most */
+
+typedef struct
+{
+  const char* text;  /* NUL terminated at `len`, never NULL */
+  size_t      len;
+  size_t      lines; /* in `text`, the last one may have no '\n' */
+} PreviewText;
+
+int  previewtext_read(PreviewText* view, int fd, size_t max_lines, size_t max_bytes);
+void previewtext_free(void);
+void previewtext_log_stats(void);
+
+#endif
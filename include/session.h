@@ -0,0 +1,76 @@
+// // // // // //
+//             //
+//   LITE FM   //
+//             //
+// // // // // //
+
+/*
+ * ---------------------------------------------------------------------------
+ *  File:        session.h
+ *  Description: What the status bar shows that does not depend on the
+ *               listing: user, hostname and the disk usage of the
+ *               filesystem we are browsing.
+ *
+ *  Author:      Siddharth Karanam
+ *  Created:     <17/10/26>
+ *
+ *  Copyright:   2024 nots1dd. All rights reserved.
+ *
+ *  License:     <GNU GPL v3>
+ *
+ *  Notes:       User and hostname are looked up once in `session_init`.
+ *
+ *               Disk usage is read with fstatvfs on a worker thread, never
+ *               on the UI thread: on a hung NFS mount statvfs blocks for as
+ *               long as the server is gone. `session_refresh_disk` hands the
+ *               worker (a dup of) the current directory's fd, to be done on
+ *               entering a directory and on the status tick. If the worker
+ *               is still stuck on an older request, the new one replaces
+ *               the pending one instead of queueing up. The UI keeps
+ *               drawing the last numbers it got.
+ *
+ *               When the numbers change (as drawn, to 0.01 GiB) the worker
+ *               bumps `notify_fd` (see eventloop.h) and
+ *               `session_disk_changed` reports it once.
+ *
+ *               The worker is never joined, it may be blocked in the
+ *               kernel. `session_free` only tells it to stop, so a Session
+ *               has to be static.
+ *
+ *  Revision History:
+ *      <17/10/26> - Initial creation and function declarations added.
+ *
+ * ---------------------------------------------------------------------------
+ */
+
+#ifndef SESSION_H
+#define SESSION_H
+
+#include <pthread.h>
+
+#define SESSION_NAME_MAX 256
+
+typedef struct
+{
+  char            user[SESSION_NAME_MAX];
+  char            hostname[SESSION_NAME_MAX];
+  int             notify_fd;
+
+  pthread_mutex_t lock;
+  pthread_cond_t  wake;
+  int             worker_started;
+  int             stopping;
+  int             request_fd; /* directory to fstatvfs next, -1 if none */
+  int             disk_valid;
+  int             disk_changed;
+  double          free_gib;
+  double          total_gib;
+} Session;
+
+void session_init(Session* session, int notify_fd);
+void session_free(Session* session);
+void session_refresh_disk(Session* session, int dir_fd);
+int  session_disk(Session* session, double* free_gib, double* total_gib);
+int  session_disk_changed(Session* session);
+
+#endif
@@ -0,0 +1,58 @@
+// // // // // //
+//             //
+//   LITE FM   //
+//             //
+// // // // // //
+
+/*
+ * ---------------------------------------------------------------------------
+ *  File:        sniff.h
+ *  Description: Tells common file formats apart by their first bytes,
+ *               without libmagic or `file`.
+ *
+ *  Author:      Siddharth Karanam
+ *  Created:     <17/10/26>
+ *
+ *  Copyright:   2024 nots1dd. All rights reserved.
+ *
+ *  License:     <GNU GPL v3>
+ *
+ *  Notes:       The caller reads the head of the file (SNIFF_BYTES, one
+ *               pread) and `sniff_mime` looks it up in a table of magic
+ *               byte signatures: ELF, PNG, JPEG, GIF, WebP, PDF, zip/jar,
+ *               gzip, xz, zstd, 7z, tar, FLAC, Ogg, MP3/ID3, WAV, AVI,
+ *               MP4 and Matroska/WebM. Answers are the MIME types `file`
+ *               gives for them.
+ *
+ *               A head without a signature is checked for text (SSE2 where
+ *               available): no control bytes other than whitespace and
+ *               escapes, and valid UTF-8. Text only gets a MIME type when
+ *               something vouches for it, a "#!" line or an extension from
+ *               exttable.def with a text MIME hint. Everything else (text
+ *               without either, unknown binary formats, zip based office
+ *               documents...) gets NULL and is left to libmagic/`file`.
+ *
+ *  Revision History:
+ *      <17/10/26> - Initial creation and function declarations added.
+ *
+ * ---------------------------------------------------------------------------
+ */
+
+#ifndef SNIFF_H
+#define SNIFF_H
+
+#include <stddef.h>
+
+#define SNIFF_BYTES 512 /* tar's "ustar" sits at 257, nothing looks further */
+
+typedef enum
+{
+  SNIFF_BINARY = 0,
+  SNIFF_ASCII,
+  SNIFF_UTF8
+} SniffText;
+
+SniffText   sniff_text(const unsigned char* buf, size_t len);
+const char* sniff_mime(const unsigned char* buf, size_t len, const char* name);
+
+#endif
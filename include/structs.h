@@ -3,12 +3,6 @@
 
 #include <limits.h>
 
-typedef struct
-{
-  char name[NAME_MAX];
-  int  is_dir;
-} FileItem;
-
 typedef struct
 {
   char path[PATH_MAX];
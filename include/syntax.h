@@ -0,0 +1,131 @@
+// // // // // //
+//             //
+//   LITE FM   //
+//             //
+// // // // // //
+
+/*
+ * ---------------------------------------------------------------------------
+ *  File:        syntax.h
+ *  Description: Syntax definitions for the preview highlighter: the ones in
+ *               keywords/ compiled in at build time, a user's own loaded
+ *               from YAML once per session and kept by language.
+ *
+ *  Author:      Siddharth Karanam
+ *  Created:     <17/10/26>
+ *
+ *  Copyright:   2024 nots1dd. All rights reserved.
+ *
+ *  License:     <GNU GPL v3>
+ *
+ *  Notes:       tools/syntax_gen.c turns every keywords/<language>-keywords.yaml
+ *               into a SyntaxTable in the generated syntax_gen.h (a build
+ *               step of the Makefile, CMake and meson): a perfect hash of
+ *               all the words of the language, each with the sets it is in,
+ *               plus the sets of every single character. A word is hashed
+ *               once with the table's seed (`syntax_hash`), which picks its
+ *               bucket, and `syntax_slot` with the bucket's displacement
+ *               picks its slot. Nothing is parsed at runtime and the
+ *               binary does not need the source tree any more.
+ *
+ *               <language>-keywords.yaml in $LITEFM_KEYWORDS_DIR, or else
+ *               in ~/.config/litefm/keywords, takes the place of the built
+ *               in table (or adds a language that has none). It is parsed
+ *               with load_syntax (see highlight.h) into HashTables.
+ *
+ *               `syntax_get` looks a language up the first time it is asked
+ *               for and hands out the same Syntax after that: previewing
+ *               another file costs a lookup among the few languages seen so
+ *               far. A language with neither a table nor a file that loads
+ *               is remembered as such and not tried again, its files are
+ *               previewed as plain text. `syntax_has_word` and
+ *               `syntax_has_char` answer for either kind.
+ *
+ *               A Syntax is never changed once loaded and lives until
+ *               `syntax_free`, callers only get const pointers.
+ *
+ *  Revision History:
+ *      <17/10/26> - Initial creation and function declarations added.
+ *
+ * ---------------------------------------------------------------------------
+ */
+
+#ifndef SYNTAX_H
+#define SYNTAX_H
+
+#include "hashtable.h"
+
+#include <stdint.h>
+
+#define SYNTAX_NAME_MAX      16 /* longer than any `syntax` in exttable.def */
+#define SYNTAX_MAX_LANGUAGES 32 /* kept per session, more are previewed without highlighting */
+#define SYNTAX_ENV_DIR       "LITEFM_KEYWORDS_DIR"
+#define SYNTAX_RELATIVE_DIR  ".config/litefm/keywords" /* under $HOME, if the above is not set */
+
+typedef enum
+{
+  SYNTAX_KEYWORDS = 0,
+  SYNTAX_SINGLECOMMENTS,
+  SYNTAX_MULTICOMMENTS1,
+  SYNTAX_MULTICOMMENTS2,
+  SYNTAX_STRINGS,
+  SYNTAX_FUNCTIONS,
+  SYNTAX_SYMBOLS,
+  SYNTAX_OPERATORS,
+  SYNTAX_SET_COUNT
+} SyntaxSet;
+
+typedef struct
+{
+  const char* word; /* NULL for an empty slot */
+  uint8_t     sets; /* bit `1 << SyntaxSet` for every set the word is in */
+} SyntaxWord;
+
+/* A language from keywords/, as generated into syntax_gen.h */
+typedef struct
+{
+  const char*       language;
+  uint32_t          seed;     /* picks a word's bucket */
+  uint32_t          buckets;  /* a power of two */
+  const uint32_t*   displace; /* per bucket, see syntax_slot */
+  uint32_t          slots;    /* a power of two */
+  const SyntaxWord* words;
+  int               singlecommentslen;
+  uint8_t           chars[256]; /* sets of the one character words, by character */
+} SyntaxTable;
+
+typedef struct
+{
+  char               language[SYNTAX_NAME_MAX];
+  const SyntaxTable* table; /* built in, NULL if loaded from the override directory */
+  HashTable*         sets[SYNTAX_SET_COUNT];
+  int                singlecommentslen;
+  int                loaded; /* 0 if there is no definition, nothing is looked up then */
+} Syntax;
+
+/* FNV-1a of `word` with `seed` folded in, and a final mix. Shared with tools/syntax_gen.c. */
+static inline uint32_t syntax_hash(const char* word, uint32_t seed)
+{
+  uint32_t h = 2166136261u ^ seed;
+  for (; *word != '\0'; word++)
+    h = (h ^ (unsigned char)*word) * 16777619u;
+  h ^= h >> 16;
+  h *= 0x7feb352du;
+  h ^= h >> 15;
+  return h;
+}
+
+/* Slot of a word with `hash` in a bucket displaced by `displace`, before the slot mask */
+static inline uint32_t syntax_slot(uint32_t hash, uint32_t displace)
+{
+  uint32_t h = (hash ^ displace) * 0x846ca68bu;
+  return h ^ (h >> 16);
+}
+
+const Syntax* syntax_get(const char* language);
+int           syntax_has_word(const Syntax* syntax, SyntaxSet set, const char* word);
+int           syntax_has_char(const Syntax* syntax, SyntaxSet set, const char* c);
+void          syntax_free(void);
+void          syntax_log_stats(void);
+
+#endif
@@ -27,38 +27,20 @@
 #ifndef SYSTEM_INFO_H
 #define SYSTEM_INFO_H
 
-#include <stdio.h>
-#include <stdlib.h>
 #include <sys/statvfs.h>
 
-static double system_free_space(const char* path)
+/* Free and total space (GiB) of the filesystem `fd` is on. Returns -1 if it cannot be read. */
+static int system_space_fd(int fd, double* free_gib, double* total_gib)
 {
   struct statvfs stat;
 
-  if (statvfs(path, &stat) != 0)
-  {
-    perror("statvfs");
-    exit(EXIT_FAILURE);
-  }
+  if (fstatvfs(fd, &stat) != 0)
+    return -1;
 
-  unsigned long free_space     = stat.f_bsize * stat.f_bavail;
-  double        free_space_gib = (double)free_space / (1 << 30); // Convert to GiB
-  return free_space_gib;
-}
-
-static double system_total_space(const char* path)
-{
-  struct statvfs stat;
-
-  if (statvfs(path, &stat) != 0)
-  {
-    perror("statvfs");
-    exit(EXIT_FAILURE);
-  }
-
-  unsigned long total_space     = stat.f_bsize * stat.f_blocks;
-  double        total_space_gib = (double)total_space / (1 << 30); // Convert to GiB
-  return total_space_gib;
+  // Block counts are in fragment size units
+  *free_gib  = (double)stat.f_frsize * stat.f_bavail / (1 << 30); // Convert to GiB
+  *total_gib = (double)stat.f_frsize * stat.f_blocks / (1 << 30);
+  return 0;
 }
 
 #endif
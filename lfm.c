@@ -36,22 +36,37 @@
 #include "include/archivecontrol.h"
 #include "include/arg_helpers.h"
 #include "include/clipboard.h"
+#include "include/compositor.h"
 #include "include/cursesutils.h"
+#include "include/dircache.h"
 #include "include/dircontrol.h"
+#include "include/dirloader.h"
+#include "include/dirprefetch.h"
+#include "include/entrymeta.h"
+#include "include/entrymime.h"
+#include "include/entrysort.h"
+#include "include/entrystore.h"
+#include "include/eventloop.h"
 #include "include/filepreview.h"
 #include "include/hashtable.h"
 #include "include/highlight.h"
 #include "include/inodeinfo.h"
 #include "include/kbinput.h"
 #include "include/logging.h"
+#include "include/mimepool.h"
+#include "include/mimetype.h"
 #include "include/musicpreview.h"
+#include "include/navctx.h"
+#include "include/previewtext.h"
+#include "include/session.h"
 #include "include/signalhandling.h"
 #include "include/structs.h"
-#include "include/systeminfo.h"
+#include "include/syntax.h"
 
-#define MAX_ITEMS            1024
 #define MAX_HISTORY          256
-#define MAX_ITEM_NAME_LENGTH 80 // Define a maximum length for item names
+#define MAX_ITEM_NAME_LENGTH 80   // Define a maximum length for item names
+#define STATUS_INTERVAL_MS   5000 // Disk usage in the status line is re-read this often
+#define LOADING_REDRAW_MS    100  // Redraw interval of the "Loading" counter
 
 /* UNICODES DEF */
 
@@ -74,112 +89,349 @@ const char* err_message[] = {
   " "};
 
 
-void list_dir(WINDOW* win, const char* path, FileItem items[], int* count, int show_hidden) {
-    DIR* dir;
-    struct dirent* entry;
-    char full_path[PATH_MAX];
-    struct stat entry_stat;
-    char symlink_target[PATH_MAX];
-    *count = 0;
+/*
+ * @LIST_DIR
+ *
+ * The directory is read on a worker thread (see dirloader) which streams the
+ * entries back in batches. list_dir only waits a few milliseconds for it, so
+ * small directories still show up complete on the first frame while big or
+ * slow ones are drawn progressively by `poll_dir_loader` in the main loop.
+ *
+ * Finished listings go into the directory cache, so going back to a recently
+ * visited (and unchanged) directory does not touch the directory at all. While
+ * the UI is idle, the highlighted subdirectory is listed into the cache ahead
+ * of time (see dirprefetch).
+ *
+ * `nav` holds the current directory open (see navctx), the listing, stats and
+ * file operations all work relative to its fd instead of on full paths.
+ *
+ * Between two keys the main loop sleeps in `event_loop` (see eventloop.h),
+ * the scans above wake it through their notify fd.
+ */
+static NavContext  nav;
+static DirLoader   dir_loader;
+static DirCache    dir_cache;
+static DirPrefetch dir_prefetch;
+static EventLoop   event_loop;
+static Session     session;
+static MimePool    mime_pool;
+static int         status_due; /* the status bar changed, repaint once idle */
+static size_t      keys_pressed; /* for the per key stats logged on exit */
+static SortMode    sort_mode    = SORT_NAME;
+static int         sort_reverse = 0;
 
-    // Clear the window
-    werase(win);
+/*
+ * What the last refreshMainWin put on screen. When only the cursor moved
+ * (same listing, same scroll position) just the old and the new highlighted
+ * rows are repainted, and the info pane is only rebuilt when the selected
+ * entry changed. Everything else (a key other than plain cursor movement, a
+ * new listing, a popup drawn over the windows...) calls `frame_invalidate`
+ * and gets a full repaint.
+ */
+typedef struct
+{
+  int  valid;
+  int  highlight;
+  int  scroll_position;
+  int  item_count;
+  int  show_hidden;
+  int  preview_valid;
+  int  preview_pending;   /* drawn before the entry's MIME type came in */
+  char preview[PATH_MAX]; /* entry the info pane shows */
+} Frame;
+
+static Frame frame;
+
+static void frame_invalidate(void)
+{
+  frame.valid         = 0;
+  frame.preview_valid = 0;
+}
 
-    // Try to open the directory
-    if (!(dir = opendir(path))) {
-        wprintw(win, "Error: Unable to open directory %s\n", path);
-        wrefresh(win);
-        return;
-    }
+/* After a sort moved the highlighted entry, scroll so that it stays on screen */
+static void keep_highlight_visible(int highlight, int* scroll_position, int height)
+{
+  int rows = height - 7; // as many rows as print_items draws
+  if (highlight < *scroll_position)
+    *scroll_position = highlight;
+  else if (rows > 0 && highlight >= *scroll_position + rows)
+    *scroll_position = highlight - rows + 1;
+  if (*scroll_position < 0)
+    *scroll_position = 0;
+}
 
-    // First pass: List directories and symlinks
-    while ((entry = readdir(dir)) != NULL) {
-        // Skip hidden files unless show_hidden is set
-        if ((!show_hidden && entry->d_name[0] == '.') || strcmp(entry->d_name, ".") == 0 ||
-            strcmp(entry->d_name, "..") == 0)
-            continue;
-
-        // Build the full path for the current entry
-        snprintf(full_path, sizeof(full_path), "%s/%s", path, entry->d_name);
-
-        // Get file information using lstat to handle symlinks correctly
-        if (lstat(full_path, &entry_stat) == -1) {
-            // Log the error but continue with other entries
-            wprintw(win, "Warning: Unable to stat %s\n", full_path);
-            continue;
-        }
+/* Tag of the current sort order in the dir cache */
+static int listing_order(void)
+{
+  int order = 1 + (int)sort_mode * 2 + sort_reverse;
+  return entry_sort_needs_meta(sort_mode) ? order | DIRCACHE_BY_META : order;
+}
 
-        // Handle symlinks
-        if (S_ISLNK(entry_stat.st_mode)) {
-            // Read the symlink target
-            ssize_t len = readlink(full_path, symlink_target, sizeof(symlink_target) - 1);
-            if (len != -1) {
-                symlink_target[len] = '\0';  // Null-terminate the symlink target string
-                snprintf(items[*count].name, sizeof(items[*count].name), "%s -> %s", entry->d_name,
-                         symlink_target);
-            } else {
-                snprintf(items[*count].name, sizeof(items[*count].name), "%s -> [unknown target]", entry->d_name);
-            }
-            items[*count].is_dir = (entry_stat.st_mode & S_IFDIR) ? 1 : 0;
-            (*count)++;
-        }
-        // Handle directories
-        else if (S_ISDIR(entry_stat.st_mode)) {
-            snprintf(items[*count].name, sizeof(items[*count].name), "%s", entry->d_name);
-            items[*count].is_dir = 1;
-            (*count)++;
-        }
+/*
+ * Sorts a complete listing of `path` in the current order, unless `order` (its
+ * tag in the dir cache) says it already is, and keeps the cached copy in that
+ * order so that the next visit needs no sort (no stat for size and mtime).
+ */
+static void sort_listing(EntryStore* items, int dir_fd, const char* path, int order,
+                         int* highlight)
+{
+  int wanted = listing_order();
+  if (order != wanted && entry_sort(items, dir_fd, sort_mode, sort_reverse, highlight) == 0)
+    dircache_set_order(&dir_cache, path, items, wanted);
+}
 
-        // Check for buffer overflow (avoid adding too many items)
-        if (*count >= PATH_MAX - 1) {
-            wprintw(win, "Warning: Too many items to display.\n");
-            break;
-        }
-    }
+/* Sorts the listing the loader just finished and caches it */
+static void sort_finished_listing(EntryStore* items, int dir_fd, int* highlight)
+{
+  int sorted = entry_sort(items, dir_fd, sort_mode, sort_reverse, highlight);
+  if (dir_loader.complete)
+    dircache_insert(&dir_cache, dir_loader.path, &dir_loader.stat, items,
+                    sorted == 0 ? listing_order() : DIRCACHE_UNSORTED);
+}
 
-    // Rewind the directory stream for the second pass (non-directory files)
-    rewinddir(dir);
+void list_dir(WINDOW* win, const NavContext* dir, EntryStore* items, int* count, int show_hidden)
+{
+  const char* path = navctx_path(dir);
+  frame_invalidate();
+  // Possibly another filesystem, the status bar keeps the old numbers until then
+  session_refresh_disk(&session, navctx_fd(dir));
+  // Metadata slots start over with the new listing
+  mimepool_cancel(&mime_pool);
+  entry_store_clear(items);
+  // Listings always include dot entries, the view leaves them out
+  entry_store_set_filter(items, show_hidden ? 0 : ENTRY_HIDDEN);
+  *count = 0;
+
+  // Clear the window
+  werase(win);
 
-    // Second pass: List non-directory files
-    while ((entry = readdir(dir)) != NULL) {
-        // Skip hidden files if not showing hidden files
-        if ((!show_hidden && entry->d_name[0] == '.') || strcmp(entry->d_name, ".") == 0 ||
-            strcmp(entry->d_name, "..") == 0)
-            continue;
+  // A prefetch of this directory may have finished since the last idle tick
+  dirprefetch_collect(&dir_prefetch, &dir_cache);
+  int order;
+  if (dircache_lookup(&dir_cache, path, items, &order))
+  {
+    dirloader_cancel(&dir_loader);
+    sort_listing(items, navctx_fd(dir), path, order, NULL);
+    *count = entry_store_rows(items);
+    compositor_mark(win);
+    return;
+  }
 
-        // Build the full path for the current entry
-        snprintf(full_path, sizeof(full_path), "%s/%s", path, entry->d_name);
+  // Drops the scan of the directory we are leaving, if it is still running
+  if (!dirprefetch_adopt(&dir_prefetch, path, &dir_loader, items) &&
+      dirloader_start(&dir_loader, navctx_fd(dir), ".", path) == -1)
+  {
+    wprintw(win, "Error: Unable to open directory %s\n", path);
+    compositor_mark(win);
+    return;
+  }
 
-        // Get file information
-        if (lstat(full_path, &entry_stat) == -1) {
-            // Log the error but continue with other entries
-            wprintw(win, "Warning: Unable to stat %s\n", full_path);
-            continue;
-        }
+  dirloader_wait(&dir_loader, DIRLOADER_GRACE_MS);
+  DirLoaderState state = dirloader_drain(&dir_loader, items, NULL, NULL);
+  if (state == DIRLOADER_FAILED)
+  {
+    wprintw(win, "Error: Unable to open directory %s\n", path);
+  }
+  else if (state == DIRLOADER_DONE)
+  {
+    sort_finished_listing(items, navctx_fd(dir), NULL);
+  }
+  *count = entry_store_rows(items);
 
-        // Handle regular files (non-symlinks and non-directories)
-        if (!S_ISLNK(entry_stat.st_mode) && !S_ISDIR(entry_stat.st_mode)) {
-            strncpy(items[*count].name, entry->d_name, sizeof(items[*count].name) - 1);
-            items[*count].is_dir = 0;
-            (*count)++;
-        }
+  // Refresh the ncurses window
+  compositor_mark(win);
+}
 
-        // Check for buffer overflow (avoid adding too many items)
-        if (*count >= PATH_MAX - 1) {
-            wprintw(win, "Warning: Too many items to display.\n");
-            break;
-        }
+/*
+ * Pulls in whatever the directory loader published since the last call.
+ *
+ * Returns 1 if the listing changed in a way that should be redrawn: the scan
+ * finished, entries landed inside the visible rows, or the "loading" counter
+ * has not been updated for a while.
+ */
+static int poll_dir_loader(EntryStore* items, int* item_count, int* highlight,
+                           int* scroll_position, int height)
+{
+  static struct timespec last_redraw;
+
+  if (!dirloader_busy(&dir_loader))
+    return 0;
+
+  int            old_count     = *item_count;
+  int            old_highlight = *highlight;
+  size_t         added;
+  DirLoaderState state = dirloader_drain(&dir_loader, items, highlight, &added);
+
+  *item_count = entry_store_rows(items);
+  // Keep the rows under the cursor where they were when dirs get slotted in above it
+  *scroll_position += *highlight - old_highlight;
+
+  if (state == DIRLOADER_FAILED)
+  {
+    show_term_message("Unable to read this directory. Check log more details..", 1);
+    return 1;
+  }
+  if (state == DIRLOADER_DONE)
+  {
+    // Entries streamed in unsorted, the cursor stays on whatever it was on
+    sort_finished_listing(items, navctx_fd(&nav), highlight);
+    keep_highlight_visible(*highlight, scroll_position, height);
+    return 1;
+  }
+
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  long since_ms = (now.tv_sec - last_redraw.tv_sec) * 1000 +
+                  (now.tv_nsec - last_redraw.tv_nsec) / 1000000;
+
+  if ((added > 0 && old_count < *scroll_position + height) || since_ms >= LOADING_REDRAW_MS)
+  {
+    last_redraw = now;
+    return 1;
+  }
+  return 0;
+}
+
+/* Keeps what the MIME type workers found. Returns 1 if the screen needs a redraw. */
+static int collect_mime_types(EntryStore* items, int highlight)
+{
+  if (mimepool_collect(&mime_pool, items) == 0)
+    return 0;
+  frame.valid = 0; // Icons of files that were drawn as plain ones
+  if (frame.preview_pending && entry_mime_known(items, highlight) != NULL)
+    frame.preview_valid = 0;
+  return 1;
+}
+
+/* Idle tick of the prefetcher: only real directories, and only once the listing is complete */
+static void prefetch_highlighted(const EntryStore* items, int highlight)
+{
+  char target[PATH_MAX];
+  if (dirloader_busy(&dir_loader) || highlight < 0 || highlight >= entry_store_rows(items) ||
+      entry_store_type(items, highlight) != ENTRY_DIR ||
+      snprintf(target, sizeof(target), "%s/%s", navctx_path(&nav),
+               entry_store_name(items, highlight)) >= (int)sizeof(target))
+  {
+    dirprefetch_tick(&dir_prefetch, &dir_cache, -1, NULL, NULL);
+    return;
+  }
+  dirprefetch_tick(&dir_prefetch, &dir_cache, navctx_fd(&nav), entry_store_name(items, highlight),
+                   target);
+}
+
+/* Goes back in `history`, or to the parent directory if there is none */
+static void navigate_back(DirHistory* history, int* history_count, int* highlight)
+{
+  *highlight = 0;
+  if (*history_count > 0)
+  {
+    (*history_count)--;
+    log_message(LOG_LEVEL_DEBUG, " [PARENT] Navigating back to %s",
+                history[*history_count].path);
+    // The common prefix with the current path stays open, going up costs no syscalls
+    if (navctx_open(&nav, history[*history_count].path) == 0)
+    {
+      *highlight = history[*history_count].highlight;
+      return;
     }
+    log_message(LOG_LEVEL_ERROR, " [PARENT] Unable to go back to %s: %s",
+                history[*history_count].path, strerror(errno));
+    show_term_message("Unable to go back there. Check log more details..", 1);
+    return;
+  }
+
+  log_message(LOG_LEVEL_DEBUG, " Checking out parent of %s", navctx_path(&nav));
+  if (navctx_leave(&nav) == 0)
+    log_message(LOG_LEVEL_DEBUG, " [PARENT] Navigating back to %s", navctx_path(&nav));
+}
+
+/*
+ * Enters the highlighted directory and remembers where we came from.
+ * Returns -1 (after telling the user) if it cannot be entered.
+ */
+static int navigate_into(const EntryStore* items, int highlight, DirHistory* history,
+                         int* history_count)
+{
+  const char* name = entry_store_name(items, highlight);
+
+  char from[PATH_MAX];
+  snprintf(from, sizeof(from), "%s", navctx_path(&nav));
+  log_message(LOG_LEVEL_DEBUG, " [CHILD] Checking into %s", name);
+  if (navctx_enter(&nav, name) == -1)
+  {
+    log_message(LOG_LEVEL_ERROR, " [CHILD] Unable to enter %s/%s: %s", from, name,
+                strerror(errno));
+    show_term_message("Unable to enter this directory. Check log more details..", 1);
+    return -1;
+  }
+  log_message(LOG_LEVEL_DEBUG, " [CHILD] Navigating into to %s", navctx_path(&nav));
+
+  if (*history_count < MAX_HISTORY)
+  {
+    strcpy(history[*history_count].path, from);
+    history[*history_count].highlight = highlight;
+    (*history_count)++;
+  }
+  return 0;
+}
 
-    // Close the directory stream
-    closedir(dir);
+/* How each EntryKind is drawn */
+static const struct
+{
+  short       pair;
+  const char* icon;
+} row_styles[ENTRY_KIND_COUNT] = {
+  [ENTRY_KIND_FILE]    = {FILE_COLOR_PAIR, UNICODE_FILE},
+  [ENTRY_KIND_DIR]     = {DIR_COLOR_PAIR, UNICODE_FOLDER},
+  [ENTRY_KIND_SYMLINK] = {SYMLINK_COLOR_PAIR, UNICODE_SYMLINK},
+  [ENTRY_KIND_ARCHIVE] = {ARCHIVE_COLOR_PAIR, UNICODE_ARCHIVE},
+  [ENTRY_KIND_AUDIO]   = {AUDIO_COLOR_PAIR, UNICODE_AUDIO},
+  [ENTRY_KIND_IMAGE]   = {IMAGE_COLOR_PAIR, UNICODE_IMAGE},
+  [ENTRY_KIND_VIDEO]   = {AUDIO_COLOR_PAIR, UNICODE_VIDEO},
+};
+
+/* Columns an entry's label may take up, changes only with the terminal's width */
+static int row_label_cap(void) { return cap_label_length(MAX_ITEM_NAME_LENGTH + 4, 0, 10); }
 
-    // Refresh the ncurses window
-    wrefresh(win);
+/*
+ * Draws entry `index` on line `y` of the listing window. Icon, color and how
+ * much of the label fits were worked out beforehand (see
+ * entry_store_fit_labels), this only puts them on screen.
+ */
+static void print_item_row(WINDOW* win, const EntryStore* items, int index, int highlight, int y)
+{
+  EntryKind kind  = entry_store_kind(items, index);
+  attr_t    attrs = COLOR_PAIR(row_styles[kind].pair);
+  if (index == highlight)
+    attrs |= A_REVERSE;
+
+  int cut;
+  int len = entry_store_label_len(items, index, row_label_cap(), &cut);
+
+  // Symlinks are shown as "name -> target" once their target has been read
+  const char* label = entry_store_name(items, index);
+  const char* link  = entry_store_link(items, index);
+  char        link_label[NAME_MAX + PATH_MAX + 5];
+  if (link != NULL)
+  {
+    snprintf(link_label, sizeof(link_label), "%s -> %s", label,
+             *link ? link : ENTRY_UNKNOWN_TARGET);
+    label = link_label;
+  }
+
+  wattrset(win, attrs);
+  mvwaddstr(win, y, 5, row_styles[kind].icon);
+  wattrset(win, attrs | A_BOLD);
+  mvwaddch(win, y, 7, ' ');
+  waddnstr(win, label, len);
+  if (cut)
+    waddstr(win, "...");
+  waddch(win, ' ');
+  wattrset(win, A_NORMAL);
 }
 
-void print_items(WINDOW* win, FileItem items[], int count, int highlight, const char* current_path,
-                 int show_hidden, int scroll_position, int height)
+void print_items(WINDOW* win, const EntryStore* items, int count, int highlight,
+                 const char* current_path, int show_hidden, int scroll_position, int height)
 {
   char* hidden_dir;
   if (show_hidden)
@@ -191,16 +443,12 @@ void print_items(WINDOW* win, FileItem items[], int count, int highlight, const
     hidden_dir = "OFF\u25C7";
   }
 
-  // Getting system free space from / dir
-  double systemFreeSpace  = system_free_space("/");
-  double totalSystemSpace = system_total_space("/");
-
-  color_pair_init();
+  // Free space of the filesystem we are in, as last read by the session's worker
+  double systemFreeSpace, totalSystemSpace;
+  int    haveDiskUsage = session_disk(&session, &systemFreeSpace, &totalSystemSpace);
 
   // Print title
   wattron(win, COLOR_PAIR(DARK_BG_COLOR_PAIR));
-  char* cur_user     = get_current_user();
-  char* cur_hostname = get_hostname();
   wattron(win, A_BOLD | COLOR_PAIR(TITLE_COLOR_PAIR));
   mvwprintw(win, 0, 2, " 🗄️ LITE FM: ");
   wattroff(win, A_BOLD | COLOR_PAIR(TITLE_COLOR_PAIR));
@@ -218,20 +466,34 @@ void print_items(WINDOW* win, FileItem items[], int count, int highlight, const
   // Print current path and hidden directories status
   wattron(win, A_BOLD);
   wattron(win, COLOR_PAIR(VIOLET_COLOR_PAIR));
-  mvwprintw(win, 2, 2, " %s@%s ", cur_hostname, cur_user);
+  mvwprintw(win, 2, 2, " %s@%s ", session.hostname, session.user);
   wattroff(win, COLOR_PAIR(VIOLET_COLOR_PAIR));
   wattron(win, COLOR_PAIR(DARK_BG_COLOR_PAIR));
   print_limited(win, 2, 20, sanitizedCurPath);
   wattroff(win, COLOR_PAIR(DARK_BG_COLOR_PAIR));
   wattron(win, COLOR_PAIR(DARK_BG_COLOR_PAIR));
   mvwprintw(win, LINES - 3, (COLS / 2) - 55, " Hidden Dirs: %s ", hidden_dir);
-  mvwprintw(win, LINES - 3, (COLS / 2) - 30, " %s %.2f / %.2f GiB ", UNICODE_DISK, systemFreeSpace,
-            totalSystemSpace);
+  if (haveDiskUsage)
+    mvwprintw(win, LINES - 3, (COLS / 2) - 30, " %s %.2f / %.2f GiB ", UNICODE_DISK,
+              systemFreeSpace, totalSystemSpace);
+  else
+    mvwprintw(win, LINES - 3, (COLS / 2) - 30, " %s -- / -- GiB ", UNICODE_DISK);
   wattroff(win, COLOR_PAIR(DARK_BG_COLOR_PAIR));
   wattroff(win, A_BOLD);
 
+  if (dirloader_busy(&dir_loader))
+  {
+    wattron(win, A_BOLD | COLOR_PAIR(IMAGE_COLOR_PAIR));
+    mvwprintw(win, 0, 18, " Loading %zu\u2026 ", dirloader_seen(&dir_loader));
+    wattroff(win, A_BOLD | COLOR_PAIR(IMAGE_COLOR_PAIR));
+  }
+
   // Print items
-  if (count == 0)
+  if (count == 0 && dirloader_busy(&dir_loader))
+  {
+    // Still reading, the first batch has not come in yet
+  }
+  else if (count == 0)
   {
     wattron(win, COLOR_PAIR(ARCHIVE_COLOR_PAIR));
     int err_msg_size = sizeof(err_message) / sizeof(err_message[0]);
@@ -247,108 +509,100 @@ void print_items(WINDOW* win, FileItem items[], int count, int highlight, const
   else
   {
     for (int i = 0; i < height - 7 && i + scroll_position < count; i++)
-    {
-      int index = i + scroll_position;
-      if (index == highlight)
-      {
-        wattron(win, A_REVERSE);
-      }
-      char full_path[MAX_PATH_LENGTH];
-      snprintf(full_path, sizeof(full_path), "%s/%s", current_path, items[index].name);
+      print_item_row(win, items, i + scroll_position, highlight, i + 4);
+  }
+}
 
-      // Apply color based on file type
-      if (items[index].is_dir)
-      {
-        wattron(win, COLOR_PAIR(DIR_COLOR_PAIR));
-        mvwprintw(win, i + 4, 5, "%s", UNICODE_FOLDER);
-      }
-      else if (is_symlink(full_path))
-      {
-        wattron(win, COLOR_PAIR(SYMLINK_COLOR_PAIR));
-        mvwprintw(win, i + 4, 5, "%s", UNICODE_SYMLINK);
-      }
-      else
-      {
-        // Determine file type by extension
-        char* extension = strrchr(items[index].name, '.');
-        if (extension)
-        {
-          if (strcmp(extension, ".zip") == 0 || strcmp(extension, ".7z") == 0 ||
-              strcmp(extension, ".tar") == 0 || strcmp(extension, ".xz") == 0 ||
-              strcmp(extension, ".gz") == 0 || strcmp(extension, ".jar") == 0)
-          {
-            wattron(win, COLOR_PAIR(ARCHIVE_COLOR_PAIR));
-            mvwprintw(win, i + 4, 5, "%s", UNICODE_ARCHIVE);
-          }
-          else if (strcmp(extension, ".mp3") == 0 || strcmp(extension, ".wav") == 0 ||
-                   strcmp(extension, ".flac") == 0 || strcmp(extension, ".opus") == 0)
-          {
-            wattron(win, COLOR_PAIR(AUDIO_COLOR_PAIR));
-            mvwprintw(win, i + 4, 5, "%s", UNICODE_AUDIO);
-          }
-          else if (strcmp(extension, ".png") == 0 || strcmp(extension, ".jpg") == 0 ||
-                   strcmp(extension, ".webp") == 0 || strcmp(extension, ".gif") == 0)
-          {
-            wattron(win, COLOR_PAIR(IMAGE_COLOR_PAIR));
-            mvwprintw(win, i + 4, 5, "%s", UNICODE_IMAGE);
-          }
-          else if (strcmp(extension, ".mp4") == 0 || strcmp(extension, ".m4v") == 0 ||
-                   strcmp(extension, ".mkv") == 0 || strcmp(extension, ".avi") == 0)
-          {
-            wattron(win, COLOR_PAIR(AUDIO_COLOR_PAIR));
-            mvwprintw(win, i + 4, 5, "%s", UNICODE_VIDEO);
-          }
-          else
-          {
-            wattron(win, COLOR_PAIR(FILE_COLOR_PAIR));
-            mvwprintw(win, i + 4, 5, "%s", UNICODE_FILE);
-          }
-        }
-        else
-        {
-          wattron(win, COLOR_PAIR(FILE_COLOR_PAIR));
-          mvwprintw(win, i + 4, 5, "%s", UNICODE_FILE);
-        }
-      }
+static int is_cursor_key(int key)
+{
+  return key == 'j' || key == 'k' || key == KEY_DOWN || key == KEY_UP;
+}
 
-      // Truncate the item name if it exceeds MAX_ITEM_NAME_LENGTH
-      char truncated_name[MAX_ITEM_NAME_LENGTH + 4]; // +4 for ellipsis and space
-      int printable_length = cap_label_length(sizeof(truncated_name), 0, 10);
-
-      if (strlen(items[index].name) > printable_length - 3) {
-        snprintf(truncated_name, printable_length - 3, "%s", items[index].name);
-        // why does the param need 6 subtracted from it? found by trial and error,
-        // but do not really understand how the "math is mathing".
-        snprintf(truncated_name + (printable_length - 6), 4, "...");
-      } else {
-        snprintf(truncated_name, printable_length, "%s", items[index].name);
-      }
+/*
+ * Sleeps until there is a key to return, or ERR once something else needs
+ * the loop: a scan published entries, `timeout_ms` (-1 for none) passed, the
+ * status tick fired. A terminal resize is returned as KEY_RESIZE, like curses
+ * does.
+ */
+static int wait_for_key(int timeout_ms)
+{
+  // Keys that came in with an escape sequence are already in curses' buffer
+  int key = getch();
+  if (key != ERR)
+    return key;
+
+  unsigned events = eventloop_wait(&event_loop, timeout_ms);
+  if (events & EVENT_FS)
+    dircache_process_events(&dir_cache);
+  if (events & EVENT_TIMER)
+    session_refresh_disk(&session, navctx_fd(&nav));
+  if ((events & EVENT_WAKE) && session_disk_changed(&session))
+  {
+    frame.valid = 0; // The info pane is still up to date
+    status_due  = 1;
+  }
+  if (events & EVENT_RESIZE)
+  {
+    resize_to_term();
+    return KEY_RESIZE;
+  }
+  return (events & EVENT_KEY) ? getch() : ERR;
+}
 
-      wattron(win, A_BOLD);
-      mvwprintw(win, i + 4, 7, " %s ", truncated_name);
-
-      // Turn off color attributes
-      wattroff(win, A_BOLD);
-      wattroff(win, COLOR_PAIR(FILE_COLOR_PAIR));
-      wattroff(win, COLOR_PAIR(DIR_COLOR_PAIR));
-      wattroff(win, COLOR_PAIR(ARCHIVE_COLOR_PAIR));
-      wattroff(win, COLOR_PAIR(AUDIO_COLOR_PAIR));
-      wattroff(win, COLOR_PAIR(IMAGE_COLOR_PAIR));
-      wattroff(win, COLOR_PAIR(SYMLINK_COLOR_PAIR)); // Turn off the color pair for symlinks
-      wattroff(win, COLOR_PAIR(DARK_BG_COLOR_PAIR));
-
-      if (index == highlight)
-        wattroff(win, A_REVERSE);
-    }
+/* Repaints the rows of the old and the new highlight, nothing else changed */
+static void repaint_cursor_rows(WINDOW* win, const EntryStore* items, int highlight,
+                                int scroll_position)
+{
+  int rows[2] = {frame.highlight, highlight};
+  for (int r = 0; r < 2; r++)
+  {
+    int y = rows[r] - scroll_position + 4;
+    if (rows[r] < 0 || rows[r] >= frame.item_count)
+      continue;
+    mvwhline(win, y, 1, ' ', getmaxx(win) - 2);
+    print_item_row(win, items, rows[r], highlight, y);
   }
 }
 
-void refreshMainWin(WINDOW* win, WINDOW* info_win, FileItem items[], int item_count, int highlight,
-                    const char* current_path, int show_hidden, int scroll_position, int height,
-                    int info_height, int info_width, int info_starty, int info_startx)
+void refreshMainWin(WINDOW* win, WINDOW* info_win, EntryStore* items, int item_count,
+                    int highlight, const char* current_path, int show_hidden, int scroll_position,
+                    int height, int info_height, int info_width, int info_starty, int info_startx)
 {
+  status_due = 0;
   check_term_size(win, info_win);
-  werase(win);
+  // Only rows in (or close to) the viewport ever get stat'ed
+  entry_meta_fetch(items, navctx_fd(&nav), scroll_position - ENTRY_META_MARGIN,
+                   scroll_position + height + ENTRY_META_MARGIN);
+  // After the fetch, which may have read symlink targets into the labels
+  entry_store_fit_labels(items, row_label_cap(), scroll_position, scroll_position + height);
+  // Rows on screen (and the next ones) get their MIME types on the workers
+  mimepool_request(&mime_pool, items, navctx_fd(&nav), highlight, scroll_position,
+                   scroll_position + height - 8);
+
+  if (frame.valid && frame.scroll_position == scroll_position &&
+      frame.item_count == item_count && frame.show_hidden == show_hidden)
+  {
+    if (frame.highlight != highlight)
+    {
+      repaint_cursor_rows(win, items, highlight, scroll_position);
+      compositor_mark(win);
+    }
+  }
+  else
+  {
+    werase(win);
+    draw_colored_border(win, 2);
+    print_items(win, items, item_count, highlight, current_path, show_hidden, scroll_position,
+                height);
+    compositor_mark(win);
+  }
+  // A frame drawn while the listing is still streaming in is repainted in full next time
+  frame.valid           = !dirloader_busy(&dir_loader);
+  frame.highlight       = highlight;
+  frame.scroll_position = scroll_position;
+  frame.item_count      = item_count;
+  frame.show_hidden     = show_hidden;
+
   if (info_win == NULL)
   {
     // Create info_win if it does not exist
@@ -358,61 +612,100 @@ void refreshMainWin(WINDOW* win, WINDOW* info_win, FileItem items[], int item_co
       perror("Failed to create info_win");
       exit(EXIT_FAILURE);
     }
-    box(info_win, 0, 0);
+    frame.preview_valid = 0;
   }
-  else
-  {
-    box(info_win, 0, 0);
-  }
-  draw_colored_border(win, 2);
-  print_items(win, items, item_count, highlight, current_path, show_hidden, scroll_position,
-              height);
-  wrefresh(win);
   if (item_count > 0)
   {
+    // The info pane stays as it is while the same entry is selected
+    char selected[PATH_MAX];
+    snprintf(selected, sizeof(selected), "%s/%s", current_path,
+             entry_store_name(items, highlight));
+    if (frame.preview_valid && strcmp(frame.preview, selected) == 0)
+      return;
+    memcpy(frame.preview, selected, sizeof(selected));
+    frame.preview_valid = 1;
+
     werase(info_win);
     box(info_win, 0, 0);
-    const char* file_type = is_readable_extension(items[highlight].name, current_path);
-    if (file_type != NULL && strcmp(file_type, "READ") == 0 && !items[highlight].is_dir)
+    // With workers the pane is drawn again once they have the type
+    const char* mime = mimepool_running(&mime_pool)
+                         ? entry_mime_known(items, highlight)
+                         : entry_mime(items, navctx_fd(&nav), highlight);
+    frame.preview_pending = mime == NULL;
+    if (mime == NULL)
+      mime = MIMETYPE_PENDING;
+    const char* file_type = preview_class(mime);
+    if (file_type != NULL && strcmp(file_type, "READ") == 0 &&
+        !entry_store_is_dir(items, highlight))
     {
-      char full_path_info[PATH_MAX];
-      snprintf(full_path_info, sizeof(full_path_info), "%s/%s", current_path,
-               items[highlight].name);
       // Load syntax elements from YAML file
-      display_file(info_win, full_path_info);
+      display_file(info_win, selected, mime);
     }
     else
     {
-      get_file_info(info_win, current_path, items[highlight].name);
+      const EntryMeta* meta = entry_store_meta(items, highlight);
+      struct stat      cached;
+      if (meta && meta->valid)
+        entry_meta_to_stat(meta, &cached);
+      get_file_info(info_win, navctx_fd(&nav), current_path, entry_store_name(items, highlight),
+                    meta && meta->valid ? &cached : NULL, mime);
     }
   }
+  else
+  {
+    frame.preview_valid = 0;
+  }
 }
 
 int main(int argc, char* argv[])
 {
   init_curses();
-
-  int        highlight = 0;
-  FileItem   items[MAX_ITEMS];
-  int        item_count = 0;
-  char       current_path[PATH_MAX];
-  DirHistory history[MAX_HISTORY];
-  int        history_count   = 0;
-  int        show_hidden     = 0; // Flag to toggle showing hidden files
-  int        scroll_position = 0; // Position of the first visible item
-  char*      cur_user        = get_current_user();
-  char*      home_dir        = getenv("HOME");
-
-  if (handle_arguments(argc, argv, current_path) == 0)
+  compositor_init();
+  color_pair_init();
+  mimetype_init();
+  // Before any worker thread exists, they inherit its signal mask
+  eventloop_init(&event_loop, STATUS_INTERVAL_MS);
+  session_init(&session, event_loop.wake_fd);
+  mimepool_init(&mime_pool, event_loop.wake_fd);
+
+  int         highlight = 0;
+  EntryStore  items;
+  int         item_count = 0;
+  char        start_path[PATH_MAX];
+  DirHistory  history[MAX_HISTORY];
+  int         history_count   = 0;
+  int         show_hidden     = 0; // Flag to toggle showing hidden files
+  int         scroll_position = 0; // Position of the first visible item
+  const char* cur_user        = session.user;
+  char*       home_dir        = getenv("HOME");
+  entry_store_init(&items);
+  items.mime_kinds = (uint8_t)mimepool_running(&mime_pool);
+  dirloader_init(&dir_loader);
+  dircache_init(&dir_cache, dircache_cap_from_env());
+  dirprefetch_init(&dir_prefetch);
+  navctx_init(&nav);
+  eventloop_watch(&event_loop, dir_cache.inotify_fd);
+  dirloader_set_notify(&dir_loader, event_loop.wake_fd);
+  dirloader_set_notify(&dir_prefetch.loader, event_loop.wake_fd);
+
+  if (handle_arguments(argc, argv, start_path) == 0)
   {
     return 0;
   }
+  if (navctx_open(&nav, start_path) == -1)
+  {
+    endwin();
+    fprintf(stderr, "Unable to open %s: %s\n", start_path, strerror(errno));
+    return 1;
+  }
+  // Always the directory `nav` is in, it is only ever changed through navctx_*
+  const char* current_path = navctx_path(&nav);
   // Create a new window with a border
   int     startx = 0, starty = 0;
   int     width = COLS / 2, height = LINES - 1;
   WINDOW* win = newwin(height, width, starty, startx);
   draw_colored_border(win, 2);
-  list_dir(win, current_path, items, &item_count, show_hidden);
+  list_dir(win, &nav, &items, &item_count, show_hidden);
 
   int     info_startx = COLS / 2, info_starty = 0;
   int     info_width = COLS / 2, info_height = LINES - 1;
@@ -420,12 +713,13 @@ int main(int argc, char* argv[])
   box(info_win, 0, 0);
 
   // Initial display
-  print_items(win, items, item_count, highlight, current_path, show_hidden, scroll_position,
+  print_items(win, &items, item_count, highlight, current_path, show_hidden, scroll_position,
               height);
-  wrefresh(win);
-  wrefresh(info_win);
+  compositor_mark(win);
+  compositor_mark(info_win);
 
-  timeout(1);
+  // Keys are only read once the event loop saw some, getch must never block
+  nodelay(stdscr, TRUE);
   nodelay(win, TRUE);
 
   int  find_index           = 0;
@@ -436,16 +730,41 @@ int main(int argc, char* argv[])
 
   while (true)
   {
-    int choice = getch();
     if (firstKeyPress)
     {
-      refreshMainWin(win, info_win, items, item_count, highlight, current_path, show_hidden,
+      refreshMainWin(win, info_win, &items, item_count, highlight, current_path, show_hidden,
                      scroll_position, height, info_height, info_width, info_starty, info_startx);
       show_term_message("", -1);
+      firstKeyPress = false;
+    }
+    // Everything drawn since the last key goes out in one terminal update
+    compositor_flush();
+    // Only the main loop ticks the prefetcher, it decides how long we may sleep
+    int choice = wait_for_key(dirprefetch_timeout(&dir_prefetch));
+    int typed  = choice == ERR && collect_mime_types(&items, highlight);
+    if ((poll_dir_loader(&items, &item_count, &highlight, &scroll_position, height) ||
+         status_due || typed) &&
+        choice == ERR)
+    {
+      refreshMainWin(win, info_win, &items, item_count, highlight, current_path, show_hidden,
+                     scroll_position, height, info_height, info_width, info_starty, info_startx);
+    }
+    if (choice == ERR)
+    {
+      prefetch_highlighted(&items, highlight);
+      // Without workers, visible rows get their MIME types while idle, in one batch
+      if (!mimepool_running(&mime_pool))
+        entry_mime_classify(&items, navctx_fd(&nav), scroll_position,
+                            scroll_position + height - 8);
     }
-    firstKeyPress = false;
+    else
+      dirprefetch_touch(&dir_prefetch);
     if (choice != ERR)
     {
+      keys_pressed++;
+      // Plain cursor movement is drawn as a partial update, anything else repaints everything
+      if (!is_cursor_key(choice))
+        frame_invalidate();
       switch (choice)
       {
         case KEY_UP:
@@ -461,58 +780,26 @@ int main(int argc, char* argv[])
         {
           show_term_message("", -1);
 
-          if (history_count > 0)
-          {
-            // Navigate using history
-            history_count--;
-            log_message(LOG_LEVEL_DEBUG, " [PARENT] Navigating back to %s", current_path);
-            strcpy(current_path, history[history_count].path);
-            highlight = history[history_count].highlight;
-          }
-          else
-          {
-            // Navigate to parent directory
-            char parent_dir[1024];
-            // Ensure parent_dir is initialized
-            snprintf(parent_dir, sizeof(parent_dir), "%s", current_path);
-
-            // Use dirname safely
-            char* parent_path = dirname(parent_dir);
-            log_message(LOG_LEVEL_DEBUG, " Checking out parent %s", parent_path);
-
-            // Handle edge cases, such as navigating from the root directory
-            if (strcmp(parent_path, "/") == 0 && strlen(current_path) > 1)
-            {
-              // Special handling for root directory
-              strcpy(current_path, "/");
-            }
-            else
-            {
-              snprintf(current_path, sizeof(current_path), "%s", parent_path);
-              log_message(LOG_LEVEL_DEBUG, " [PARENT] Navigating back to %s", current_path);
-            }
-
-            highlight = 0;
-          }
+          // Navigate using history, or to the parent directory
+          navigate_back(history, &history_count, &highlight);
 
           // List the contents of the new directory
           scroll_position = 0;
-          list_dir(win, current_path, items, &item_count, show_hidden);
+          list_dir(win, &nav, &items, &item_count, show_hidden);
           break;
         }
         case KEY_RIGHT:
         case 'l':
           show_term_message("", -1);
-          char fullPath[MAX_PATH_LENGTH];
-          snprintf(fullPath, MAX_PATH_LENGTH, "%s/%s", current_path, items[highlight].name);
+          const char* selected = entry_store_name(&items, highlight);
 
           // Check access to the directory or file
 
-          if (access(fullPath, R_OK) != 0)
+          if (faccessat(navctx_fd(&nav), selected, R_OK, 0) != 0)
           {
             // Log the message safely
-            log_message(LOG_LEVEL_ERROR, "[%s] Access denied for inode path %s: %s\n", cur_user,
-                        fullPath, strerror(errno));
+            log_message(LOG_LEVEL_ERROR, "[%s] Access denied for inode path %s/%s: %s\n",
+                        cur_user, current_path, selected, strerror(errno));
 
             // Show the message to the user
             show_term_message("Access denied for this inode. Check log more details..", 1);
@@ -520,50 +807,44 @@ int main(int argc, char* argv[])
           }
 
           // Check access to the realPath
-          if (items[highlight].is_dir)
+          if (entry_store_is_dir(&items, highlight))
           {
-            if (history_count < MAX_HISTORY)
-            {
-              strcpy(history[history_count].path, current_path);
-              history[history_count].highlight = highlight;
-              history_count++;
-            }
-            strcat(current_path, "/");
-            log_message(LOG_LEVEL_DEBUG, " [CHILD] Checking into %s", items[highlight].name);
-            strcat(current_path, items[highlight].name);
-            log_message(LOG_LEVEL_DEBUG, " [CHILD] Navigating into to %s", current_path);
-            list_dir(win, current_path, items, &item_count, show_hidden);
+            if (navigate_into(&items, highlight, history, &history_count) == -1)
+              break;
+            list_dir(win, &nav, &items, &item_count, show_hidden);
             highlight       = 0;
             scroll_position = 0;
           }
           else
           {
-            if (strcmp(is_readable_extension(items[highlight].name, current_path), "NULL") == 0)
+            const char* file_type =
+              preview_class(entry_mime(&items, navctx_fd(&nav), highlight));
+            selected = entry_store_name(&items, highlight); // A fetch may have moved the arena
+            if (strcmp(file_type, "NULL") == 0)
             {
               show_term_message("Cannot do anything here.", 1);
             }
             else
             {
-              if (strcmp(is_readable_extension(items[highlight].name, current_path), "READ") == 0)
+              if (strcmp(file_type, "READ") == 0)
               {
                 firstKeyPress = true;
-                launch_env_var(win, current_path, items[highlight].name, "EDITOR");
+                launch_env_var(win, current_path, selected, "EDITOR");
+                entry_store_forget_meta(&items, highlight); // Size/mtime likely changed
                 /* Since we have set firstKeyPress to true, it will not wgetch(), rather it will
                  * just refresh everything back to how it was */
               }
-              else if ((strcmp(is_readable_extension(items[highlight].name, current_path),
-                               "IMAGE") == 0) &&
-                       !items[highlight].is_dir)
+              else if ((strcmp(file_type, "IMAGE") == 0) &&
+                       !entry_store_is_dir(&items, highlight))
               {
                 firstKeyPress = true;
-                launch_env_var(win, current_path, items[highlight].name, "VISUAL");
+                launch_env_var(win, current_path, selected, "VISUAL");
               }
-              else if ((strcmp(is_readable_extension(items[highlight].name, current_path),
-                               "AUDIO") == 0) &&
-                       !items[highlight].is_dir)
+              else if ((strcmp(file_type, "AUDIO") == 0) &&
+                       !entry_store_is_dir(&items, highlight))
               {
-                char file_path[MAX_PATH_LENGTH];
-                snprintf(file_path, MAX_PATH_LENGTH, "%s/%s", current_path, items[highlight].name);
+                char file_path[PATH_MAX];
+                snprintf(file_path, PATH_MAX, "%s/%s", current_path, selected);
                 show_term_message(" [PREVIEW] Previewing audio file. Press q to quit.", 0);
                 preview_audio(file_path);
                 show_term_message("", -1);
@@ -584,7 +865,9 @@ int main(int argc, char* argv[])
         case 'g':
           show_term_message(" [!] g", -1);
           halfdelay(100);
+          compositor_flush();
           char nextch = getch();
+          cbreak(); // Half-delay would override nodelay, and getch must not block in the loop
           if (nextch == 'g')
           {
             handleInputMovCursTop(&highlight, &scroll_position);
@@ -593,25 +876,16 @@ int main(int argc, char* argv[])
           { // GO TO func
             char destination_path[PATH_MAX];
             get_user_input_from_bottom(stdscr, destination_path, PATH_MAX, "goto", current_path);
-            if (is_directory(destination_path))
-            {
-              strcpy(current_path, destination_path);
-              list_dir(win, current_path, items, &item_count, show_hidden);
-              highlight       = 0;
-              scroll_position = 0;
-            }
-            else
+            if (handleInputGoToDir(&nav, destination_path, &highlight, &scroll_position) == 0)
             {
-              log_message(LOG_LEVEL_ERROR, "The input `%s` is an invalid directory",
-                          destination_path);
-              show_term_message("Invalid destination!", 1);
+              list_dir(win, &nav, &items, &item_count, show_hidden);
             }
             break;
           }
           else if (nextch == 'h')
           {
-            handleInputGoToDir(current_path, home_dir, &highlight, &scroll_position);
-            list_dir(win, current_path, items, &item_count, show_hidden);
+            if (handleInputGoToDir(&nav, home_dir, &highlight, &scroll_position) == 0)
+              list_dir(win, &nav, &items, &item_count, show_hidden);
             break;
           }
           else
@@ -620,12 +894,11 @@ int main(int argc, char* argv[])
           }
           break;
         case '.':
-          handleInputToggleHidden(&show_hidden, &scroll_position, &highlight);
-          list_dir(win, current_path, items, &item_count, show_hidden);
+          handleInputToggleHidden(&show_hidden, &items, &item_count, &highlight, &scroll_position);
           break;
         case 'H':
-          handleInputGoToDir(current_path, "/", &highlight, &scroll_position);
-          list_dir(win, current_path, items, &item_count, show_hidden);
+          if (handleInputGoToDir(&nav, "/", &highlight, &scroll_position) == 0)
+            list_dir(win, &nav, &items, &item_count, show_hidden);
           break;
         case 'a': // Add file or directory
         {
@@ -639,7 +912,7 @@ int main(int argc, char* argv[])
             {
               // Create directory
               name_input[strlen(name_input) - 1] = '\0'; // Remove trailing slash
-              int result = create_directory(current_path, name_input, timestamp);
+              int result = create_directory(navctx_fd(&nav), name_input, timestamp);
               if (result == 0)
               {
                 log_message(LOG_LEVEL_INFO, "Directory created successfully for `%s`", name_input);
@@ -662,7 +935,7 @@ int main(int argc, char* argv[])
             else
             {
               // Create file
-              int result = create_file(current_path, name_input, timestamp);
+              int result = create_file(navctx_fd(&nav), name_input, timestamp);
               if (result == 0)
               {
                 char msg[256];
@@ -682,7 +955,7 @@ int main(int argc, char* argv[])
                 show_term_message("Error creating file.", 1);
               }
             }
-            list_dir(win, current_path, items, &item_count, show_hidden);
+            list_dir(win, &nav, &items, &item_count, show_hidden);
             scroll_position = 0;
           }
           else
@@ -699,27 +972,27 @@ int main(int argc, char* argv[])
           if (item_count > 0)
           {
             char confirm_msg[256];
-            if (items[highlight].is_dir)
+            if (entry_store_is_dir(&items, highlight))
             {
               snprintf(confirm_msg, sizeof(confirm_msg), "Remove Directory '%s'? (y/n)",
-                       items[highlight].name);
+                       entry_store_name(&items, highlight));
             }
             else
             {
               snprintf(confirm_msg, sizeof(confirm_msg), "Remove file '%s'? (y/n)",
-                       items[highlight].name);
+                       entry_store_name(&items, highlight));
             }
 
             if (confirm_action(win, confirm_msg))
             {
-              char* deldir = items[highlight].name;
-              if (items[highlight].is_dir)
+              const char* deldir = entry_store_name(&items, highlight);
+              if (entry_store_is_dir(&items, highlight))
               {
-                int result = remove_directory(current_path, items[highlight].name);
+                int result = remove_directory(navctx_fd(&nav), entry_store_name(&items, highlight));
                 if (result != 0)
                 {
                   log_message(LOG_LEVEL_ERROR, "Error deleting directory for `%s`",
-                              items[highlight].name);
+                              entry_store_name(&items, highlight));
                   show_term_message("Error removing directory. Dir might be recursive.", 1);
                 }
                 else
@@ -733,12 +1006,12 @@ int main(int argc, char* argv[])
               }
               else
               {
-                char* delfile = items[highlight].name;
-                int   result  = remove_file(current_path, items[highlight].name);
+                const char* delfile = entry_store_name(&items, highlight);
+                int result = remove_file(navctx_fd(&nav), entry_store_name(&items, highlight));
                 if (result != 0)
                 {
                   log_message(LOG_LEVEL_ERROR, "Error removing file for `%s`",
-                              items[highlight].name);
+                              entry_store_name(&items, highlight));
                   show_term_message("Error removing file.", 1);
                 }
                 else
@@ -750,7 +1023,7 @@ int main(int argc, char* argv[])
                   show_term_message(msg, 0);
                 }
               }
-              list_dir(win, current_path, items, &item_count, show_hidden);
+              list_dir(win, &nav, &items, &item_count, show_hidden);
             }
           }
         }
@@ -761,31 +1034,30 @@ int main(int argc, char* argv[])
           if (item_count > 0)
           {
             char confirm_msg[256];
-            if (items[highlight].is_dir)
+            if (entry_store_is_dir(&items, highlight))
             {
               snprintf(confirm_msg, sizeof(confirm_msg),
-                       "[DANGER] Remove Directory recursively '%s'? (y/n)", items[highlight].name);
+                       "[DANGER] Remove Directory recursively '%s'? (y/n)",
+                       entry_store_name(&items, highlight));
             }
             else
             {
               log_message(LOG_LEVEL_WARN, "Attempted to remove file `%s` recursively.",
-                          items[highlight].name);
+                          entry_store_name(&items, highlight));
               show_term_message("This command is for deleting recursive directories ONLY!", 1);
               break;
             }
 
             if (confirm_action(win, confirm_msg))
             {
-              char* deldir = items[highlight].name;
-              if (items[highlight].is_dir)
+              const char* deldir = entry_store_name(&items, highlight);
+              if (entry_store_is_dir(&items, highlight))
               {
-                int parent_fd = open(current_path, O_RDONLY | O_DIRECTORY);
-                int result =
-                  remove_directory_recursive(current_path, items[highlight].name, parent_fd);
+                int result = remove_directory_recursive(current_path, deldir, navctx_fd(&nav));
                 if (result != 0)
                 {
                   log_message(LOG_LEVEL_ERROR, "Error removing directory `%s`",
-                              items[highlight].name);
+                              entry_store_name(&items, highlight));
                   show_term_message("Error removing directory.", 1);
                 }
                 else
@@ -796,14 +1068,14 @@ int main(int argc, char* argv[])
                   show_term_message(delmsg, 0);
                 }
               }
-              list_dir(win, current_path, items, &item_count, show_hidden);
+              list_dir(win, &nav, &items, &item_count, show_hidden);
             }
           }
         }
         break;
         case '/': // Find file or directory
         {
-          handleInputStringSearch(win, items, &item_count, &highlight, &scroll_position, &height,
+          handleInputStringSearch(win, &items, &item_count, &highlight, &scroll_position, &height,
                                   last_query, current_path);
           break;
         }
@@ -818,36 +1090,37 @@ int main(int argc, char* argv[])
            * -1 => Backward Search
            *
            */
-          handleInputStringOccurance(1, last_query, items, &item_count, &highlight,
+          handleInputStringOccurance(1, last_query, &items, &item_count, &highlight,
                                      &scroll_position, &height);
           break;
         case 'N':
-          handleInputStringOccurance(-1, last_query, items, &item_count, &highlight,
+          handleInputStringOccurance(-1, last_query, &items, &item_count, &highlight,
                                      &scroll_position, &height);
           break;
         case 'E':
-          handleInputExtractArchive(win, items, current_path, last_query, &scroll_position,
+          handleInputExtractArchive(win, &items, current_path, last_query, &scroll_position,
                                     &highlight);
-          list_dir(win, current_path, items, &item_count, show_hidden);
+          list_dir(win, &nav, &items, &item_count, show_hidden);
           break;
         case 'Z':
-          handleInputCompressInode(win, items, current_path, &highlight, &scroll_position);
-          list_dir(win, current_path, items, &item_count, show_hidden);
+          handleInputCompressInode(win, &items, current_path, &highlight, &scroll_position);
+          list_dir(win, &nav, &items, &item_count, show_hidden);
           break;
 
         case 'R':
         {
-          handleInputRename(&item_count, &highlight, &scroll_position, current_path, items);
-          list_dir(win, current_path, items, &item_count, show_hidden);
+          handleInputRename(&item_count, &highlight, &scroll_position, &nav, &items);
+          list_dir(win, &nav, &items, &item_count, show_hidden);
           break;
         }
         case 'M':
         {
-          halfdelay(100);
-          char basefile[MAX_PATH_LENGTH];
-          strcpy(basefile, items[highlight].name);
-          char basepath[MAX_PATH_LENGTH];
+          char basefile[PATH_MAX];
+          snprintf(basefile, sizeof(basefile), "%s", entry_store_name(&items, highlight));
+          char basepath[PATH_MAX];
           strcpy(basepath, current_path);
+          // Keeps the source directory open while the user walks to the destination
+          int  base_fd = navctx_dup(&nav);
           char termMSG[256];
           snprintf(termMSG, 256, " [VISUAL]    Moving  %s   %s %s", basefile,
                    UNICODE_INODE, basepath);
@@ -855,40 +1128,23 @@ int main(int argc, char* argv[])
           show_term_message(termMSG, 0);
           do
           {
-            int nextch = getch();
+            compositor_flush();
+            int nextch = wait_for_key(-1);
+            if (nextch != ERR && !is_cursor_key(nextch))
+              frame_invalidate();
             if (nextch == 'h' || nextch == KEY_LEFT)
             {
-              if (history_count > 0)
-              {
-                history_count--;
-                strcpy(current_path, history[history_count].path);
-                highlight = history[history_count].highlight;
-                list_dir(win, current_path, items, &item_count, show_hidden);
-                scroll_position = 0;
-              }
-              else
-              { // will allow for traversal to parents of get_current_working_directory (getcwd)
-                char parent_dir[1024];
-                strcpy(parent_dir, current_path);
-                strcpy(current_path, dirname(parent_dir));
-                list_dir(win, current_path, items, &item_count, show_hidden);
-                highlight       = 0;
-                scroll_position = 0;
-              }
+              // will allow for traversal to parents of get_current_working_directory (getcwd)
+              navigate_back(history, &history_count, &highlight);
+              list_dir(win, &nav, &items, &item_count, show_hidden);
+              scroll_position = 0;
             }
             else if (nextch == 'l' || nextch == KEY_RIGHT)
             {
-              if (items[highlight].is_dir)
+              if (entry_store_is_dir(&items, highlight) &&
+                  navigate_into(&items, highlight, history, &history_count) == 0)
               {
-                if (history_count < MAX_HISTORY)
-                {
-                  strcpy(history[history_count].path, current_path);
-                  history[history_count].highlight = highlight;
-                  history_count++;
-                }
-                strcat(current_path, "/");
-                strcat(current_path, items[highlight].name);
-                list_dir(win, current_path, items, &item_count, show_hidden);
+                list_dir(win, &nav, &items, &item_count, show_hidden);
                 highlight       = 0;
                 scroll_position = 0;
               }
@@ -903,11 +1159,12 @@ int main(int argc, char* argv[])
             }
             else if (nextch == '.')
             {
-              handleInputToggleHidden(&show_hidden, &scroll_position, &highlight);
+              handleInputToggleHidden(&show_hidden, &items, &item_count, &highlight,
+                                      &scroll_position);
             }
             else if (nextch == '/')
             {
-              handleInputStringSearch(win, items, &item_count, &highlight, &scroll_position,
+              handleInputStringSearch(win, &items, &item_count, &highlight, &scroll_position,
                                       &height, last_query, current_path);
             }
             else if (nextch == 10)
@@ -915,38 +1172,37 @@ int main(int argc, char* argv[])
               break;
             }
             show_term_message(termMSG, 0);
-            refreshMainWin(win, info_win, items, item_count, highlight, current_path, show_hidden,
+            poll_dir_loader(&items, &item_count, &highlight, &scroll_position, height);
+            refreshMainWin(win, info_win, &items, item_count, highlight, current_path, show_hidden,
                            scroll_position, height, info_height, info_width, info_starty,
                            info_startx);
 
           } while (nextch != 10);
-          move_file_or_dir(win, basepath, current_path, basefile);
-          list_dir(win, current_path, items, &item_count, show_hidden);
+          move_file_or_dir(win, base_fd, basepath, navctx_fd(&nav), current_path, basefile);
+          if (base_fd != -1)
+            close(base_fd);
+          list_dir(win, &nav, &items, &item_count, show_hidden);
           break;
         }
         case 10:
         {
           show_term_message("", -1);
-          if (items[highlight].is_dir)
+          if (entry_store_is_dir(&items, highlight))
           {
-            if (history_count < MAX_HISTORY)
-            {
-              strcpy(history[history_count].path, current_path);
-              history[history_count].highlight = highlight;
-              history_count++;
-            }
-            strcat(current_path, "/");
-            strcat(current_path, items[highlight].name);
-            list_dir(win, current_path, items, &item_count, show_hidden);
+            if (navigate_into(&items, highlight, history, &history_count) == -1)
+              break;
+            list_dir(win, &nav, &items, &item_count, show_hidden);
             highlight       = 0;
             scroll_position = 0;
             break;
           }
           else
           {
-            if (strcmp(is_readable_extension(items[highlight].name, current_path), "READ") == 0)
+            const char* mime = entry_mime(&items, navctx_fd(&nav), highlight);
+            if (strcmp(preview_class(mime), "READ") == 0)
             {
-              get_file_info_popup(win, current_path, items[highlight].name);
+              get_file_info_popup(win, navctx_fd(&nav), current_path,
+                                  entry_store_name(&items, highlight), mime);
             }
             else
             {
@@ -959,57 +1215,39 @@ int main(int argc, char* argv[])
         case 'y':
         {
           char full_path[PATH_MAX];
-          snprintf(full_path, PATH_MAX, "%s/%s", current_path, items[highlight].name);
+          snprintf(full_path, PATH_MAX, "%s/%s", current_path, entry_store_name(&items, highlight));
           yank_selected_item(full_path);
           break;
         }
         case 'Y':
         {
-          halfdelay(100);
           int  createFile = 0;
-          char basefile[MAX_PATH_LENGTH];
-          strcpy(basefile, items[highlight].name);
-          char basepath[MAX_PATH_LENGTH];
-          snprintf(basepath, MAX_PATH_LENGTH, "%s/%s", current_path, basefile);
+          char basefile[PATH_MAX];
+          snprintf(basefile, sizeof(basefile), "%s", entry_store_name(&items, highlight));
+          char basepath[PATH_MAX];
+          snprintf(basepath, PATH_MAX, "%s/%s", current_path, basefile);
           char termMSG[256];
           snprintf(termMSG, 256, " [VISUAL]    Copying  %s to .... ", basepath);
           show_term_message(termMSG, 0);
           do
           {
-            int nextch = getch();
+            compositor_flush();
+            int nextch = wait_for_key(-1);
+            if (nextch != ERR && !is_cursor_key(nextch))
+              frame_invalidate();
             if (nextch == 'h' || nextch == KEY_LEFT)
             {
-              if (history_count > 0)
-              {
-                history_count--;
-                strcpy(current_path, history[history_count].path);
-                highlight = history[history_count].highlight;
-                list_dir(win, current_path, items, &item_count, show_hidden);
-                scroll_position = 0;
-              }
-              else
-              { // will allow for traversal to parents of get_current_working_directory (getcwd)
-                char parent_dir[1024];
-                strcpy(parent_dir, current_path);
-                strcpy(current_path, dirname(parent_dir));
-                list_dir(win, current_path, items, &item_count, show_hidden);
-                highlight       = 0;
-                scroll_position = 0;
-              }
+              // will allow for traversal to parents of get_current_working_directory (getcwd)
+              navigate_back(history, &history_count, &highlight);
+              list_dir(win, &nav, &items, &item_count, show_hidden);
+              scroll_position = 0;
             }
             else if (nextch == 'l' || nextch == KEY_RIGHT)
             {
-              if (items[highlight].is_dir)
+              if (entry_store_is_dir(&items, highlight) &&
+                  navigate_into(&items, highlight, history, &history_count) == 0)
               {
-                if (history_count < MAX_HISTORY)
-                {
-                  strcpy(history[history_count].path, current_path);
-                  history[history_count].highlight = highlight;
-                  history_count++;
-                }
-                strcat(current_path, "/");
-                strcat(current_path, items[highlight].name);
-                list_dir(win, current_path, items, &item_count, show_hidden);
+                list_dir(win, &nav, &items, &item_count, show_hidden);
                 highlight       = 0;
                 scroll_position = 0;
               }
@@ -1024,45 +1262,68 @@ int main(int argc, char* argv[])
             }
             else if (nextch == '.')
             {
-              handleInputToggleHidden(&show_hidden, &scroll_position, &highlight);
-              list_dir(win, current_path, items, &item_count, show_hidden);
+              handleInputToggleHidden(&show_hidden, &items, &item_count, &highlight,
+                                      &scroll_position);
             }
             else if (nextch == '/')
             {
-              handleInputStringSearch(win, items, &item_count, &highlight, &scroll_position,
+              handleInputStringSearch(win, &items, &item_count, &highlight, &scroll_position,
                                       &height, last_query, current_path);
             }
             else if ((nextch == 10 || nextch == 'p'))
             {
-              if (nextch == 'p' && !items[highlight].is_dir)
+              if (nextch == 'p' && !entry_store_is_dir(&items, highlight))
               {
                 createFile = 1;
               }
               break;
             }
             show_term_message(termMSG, 0); /* CONTINOUSLY SHOW THIS MSG */
-            refreshMainWin(win, info_win, items, item_count, highlight, current_path, show_hidden,
+            poll_dir_loader(&items, &item_count, &highlight, &scroll_position, height);
+            refreshMainWin(win, info_win, &items, item_count, highlight, current_path, show_hidden,
                            scroll_position, height, info_height, info_width, info_starty,
                            info_startx);
 
           } while (nextch != 10);
 
-          char destination_path[MAX_PATH_LENGTH];
+          char destination_path[PATH_MAX];
           if (createFile != 1)
           {
-            snprintf(destination_path, MAX_PATH_LENGTH, "%s/%s", current_path, basefile);
+            snprintf(destination_path, PATH_MAX, "%s/%s", current_path, basefile);
           }
           else
           {
-            snprintf(destination_path, MAX_PATH_LENGTH, "%s/%s", current_path,
-                     items[highlight].name);
+            snprintf(destination_path, PATH_MAX, "%s/%s", current_path,
+                     entry_store_name(&items, highlight));
           }
           copyFileContents(basepath, destination_path);
           werase(win);
-          wrefresh(win);
+          compositor_mark(win);
           werase(info_win);
-          wrefresh(info_win);
-          list_dir(win, current_path, items, &item_count, show_hidden);
+          compositor_mark(info_win);
+          list_dir(win, &nav, &items, &item_count, show_hidden);
+          break;
+        }
+        case 's':
+        case 'S':
+        {
+          if (choice == 's')
+            sort_mode = (sort_mode + 1) % SORT_MODE_COUNT;
+          else
+            sort_reverse = !sort_reverse;
+
+          // A listing that is still loading gets sorted once it is complete
+          if (!dirloader_busy(&dir_loader))
+          {
+            sort_listing(&items, navctx_fd(&nav), navctx_path(&nav), DIRCACHE_UNSORTED,
+                         &highlight);
+            keep_highlight_visible(highlight, &scroll_position, height);
+          }
+
+          char msg[64];
+          snprintf(msg, sizeof(msg), " [SORT] %s%s", entry_sort_label(sort_mode),
+                   sort_reverse ? " (reversed)" : "");
+          show_term_message(msg, 0);
           break;
         }
         case '?':
@@ -1070,11 +1331,32 @@ int main(int argc, char* argv[])
           break;
         case 'q':
           log_message(LOG_LEVEL_DEBUG, "================ LITEFM INSTANCE OVER =================");
+          dirloader_cancel(&dir_loader);
+          dirprefetch_log_stats(&dir_prefetch);
+          dirprefetch_free(&dir_prefetch);
+          dircache_log_stats(&dir_cache);
+          dircache_free(&dir_cache);
+          session_free(&session);
+          mimepool_log_stats(&mime_pool);
+          // Before the wake fd goes away, workers bump it
+          int pool_gone = mimepool_free(&mime_pool) == 0;
+          eventloop_free(&event_loop);
+          compositor_log_stats();
+          mimetype_log_stats(keys_pressed);
+          syntax_log_stats();
+          previewtext_log_stats();
+          compositor_free();
+          syntax_free();
+          previewtext_free();
+          if (pool_gone)
+            mimetype_free();
+          entry_store_free(&items);
+          navctx_free(&nav);
           endwin();
           return 0;
       }
       // Update display after each key press
-      refreshMainWin(win, info_win, items, item_count, highlight, current_path, show_hidden,
+      refreshMainWin(win, info_win, &items, item_count, highlight, current_path, show_hidden,
                      scroll_position, height, info_height, info_width, info_starty, info_startx);
     }
   }
@@ -167,6 +167,7 @@ int add_directory_to_archive(struct archive* a, const char* dir_path, const char
     return -1;
   }
 
+  // From here on dir_fd belongs to `dir`, closedir closes it
   dir = fdopendir(dir_fd);
   if (dir == NULL)
   {
@@ -188,7 +189,6 @@ int add_directory_to_archive(struct archive* a, const char* dir_path, const char
     {
       log_message(LOG_LEVEL_ERROR, "fstatat");
       closedir(dir);
-      close(dir_fd);
       return -1;
     }
 
@@ -203,7 +203,6 @@ int add_directory_to_archive(struct archive* a, const char* dir_path, const char
       log_message(LOG_LEVEL_ERROR, "archive_write_header: %s", archive_error_string(a));
       archive_entry_free(entry);
       closedir(dir);
-      close(dir_fd);
       return -1;
     }
 
@@ -215,10 +214,10 @@ int add_directory_to_archive(struct archive* a, const char* dir_path, const char
         log_message(LOG_LEVEL_ERROR, "openat");
         archive_entry_free(entry);
         closedir(dir);
-        close(dir_fd);
         return -1;
       }
 
+      // Same for file_fd and `file`
       FILE* file = fdopen(file_fd, "rb");
       if (file == NULL)
       {
@@ -226,7 +225,6 @@ int add_directory_to_archive(struct archive* a, const char* dir_path, const char
         close(file_fd);
         archive_entry_free(entry);
         closedir(dir);
-        close(dir_fd);
         return -1;
       }
 
@@ -238,22 +236,18 @@ int add_directory_to_archive(struct archive* a, const char* dir_path, const char
         {
           log_message(LOG_LEVEL_ERROR, "archive_write_data: %s", archive_error_string(a));
           fclose(file);
-          close(file_fd);
           archive_entry_free(entry);
           closedir(dir);
-          close(dir_fd);
           return -1;
         }
       }
       fclose(file);
-      close(file_fd);
     }
 
     archive_entry_free(entry);
   }
 
   closedir(dir);
-  close(dir_fd);
   return 0;
 }
 
@@ -21,6 +21,13 @@ void show_help()
   printf("\nArguments:\n");
   printf("  lfm [DIR]       Open litefm in that directory\n");
 
+  // Print environment
+  printf("\nEnvironment:\n");
+  printf("  LITEFM_DIRCACHE_MB   Memory cap of the directory listing cache in MiB "
+         "(default 32, 0 disables it)\n");
+  printf("  LITEFM_PREFETCH      Idle prefetch of the highlighted directory: 0 disables it, "
+         "remote also prefetches on network/FUSE mounts\n");
+
   // Print help
   printf("\nHelp:\n");
   printf("  Visit https://github.com/nots1dd/litefm for more information.\n");
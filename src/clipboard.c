@@ -7,17 +7,18 @@
 /* BY nots1dd */
 
 #include "../include/clipboard.h"
+#include "../include/compositor.h"
 #include "../include/cursesutils.h"
 #include "../include/logging.h"
 
 // Function to copy the selected item name
 void yank_selected_item(char* selected_item)
 {
-  static char copied_item[MAX_PATH_LENGTH];
+  static char copied_item[PATH_MAX];
 
   // Copy the selected item's name to the internal storage
-  strncpy(copied_item, selected_item, MAX_PATH_LENGTH - 1);
-  copied_item[MAX_PATH_LENGTH - 1] = '\0'; // Ensure null-termination
+  strncpy(copied_item, selected_item, PATH_MAX - 1);
+  copied_item[PATH_MAX - 1] = '\0'; // Ensure null-termination
 
   // Prepare the copy message
   char copy_msg[256];
@@ -25,7 +26,7 @@ void yank_selected_item(char* selected_item)
 
   // Show the message in the terminal
   show_term_message(copy_msg, 0);
-  refresh();
+  compositor_flush(); // Before the clipboard tool runs
 
   // Determine the display server and use the appropriate clipboard tool
   const char* display_server = getenv("WAYLAND_DISPLAY");
@@ -0,0 +1,107 @@
+// // // // // //
+//             //
+//   LITE FM   //
+//             //
+// // // // // //
+
+/* BY nots1dd */
+
+#define _GNU_SOURCE
+
+#include "../include/compositor.h"
+#include "../include/logging.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#define COMPOSITOR_IO_PATH "/proc/thread-self/io"
+
+static struct
+{
+  int                dirty;
+  int                io_fd; /* the main thread's io counters, -1 if not available */
+  unsigned long      frames;
+  unsigned long long bytes;
+  unsigned long long max_bytes;
+} compositor = {.io_fd = -1};
+
+/* Bytes this thread has passed to write() so far, -1 if unknown */
+static long long written_bytes(void)
+{
+  char    buf[256];
+  ssize_t n = pread(compositor.io_fd, buf, sizeof(buf) - 1, 0);
+  if (n <= 0)
+    return -1;
+  buf[n] = '\0';
+
+  long long   wchar;
+  const char* line = strstr(buf, "wchar:");
+  if (line == NULL || sscanf(line, "wchar: %lld", &wchar) != 1)
+    return -1;
+  return wchar;
+}
+
+/* Has to be called from the thread that draws */
+void compositor_init(void)
+{
+  compositor.io_fd = open(COMPOSITOR_IO_PATH, O_RDONLY | O_CLOEXEC);
+  if (compositor.io_fd == -1)
+    log_message(LOG_LEVEL_DEBUG, " [COMPOSITOR] %s unavailable, not counting tty bytes",
+                COMPOSITOR_IO_PATH);
+}
+
+void compositor_free(void)
+{
+  if (compositor.io_fd != -1)
+    close(compositor.io_fd);
+  compositor.io_fd = -1;
+}
+
+/* `win` goes out with the next flush. Windows marked later are drawn on top. */
+void compositor_mark(WINDOW* win)
+{
+  wnoutrefresh(win);
+  compositor.dirty = 1;
+}
+
+/*
+ * @COMPOSITOR_FLUSH
+ *
+ * Writes everything marked since the last flush to the terminal, one
+ * doupdate for the whole frame. Does nothing if nothing was marked.
+ */
+void compositor_flush(void)
+{
+  if (!compositor.dirty)
+    return;
+  compositor.dirty = 0;
+
+  long long before = compositor.io_fd != -1 ? written_bytes() : -1;
+  doupdate();
+  long long after = before != -1 ? written_bytes() : -1;
+
+  compositor.frames++;
+  if (after < before)
+    return;
+  unsigned long long frame_bytes = (unsigned long long)(after - before);
+  compositor.bytes += frame_bytes;
+  if (frame_bytes > compositor.max_bytes)
+    compositor.max_bytes = frame_bytes;
+}
+
+/* Mark and flush, for windows about to block on input */
+void compositor_present(WINDOW* win)
+{
+  compositor_mark(win);
+  compositor_flush();
+}
+
+void compositor_log_stats(void)
+{
+  log_message(LOG_LEVEL_DEBUG,
+              " [COMPOSITOR] frames: %lu, tty bytes: %llu (avg %llu, max %llu per frame)",
+              compositor.frames, compositor.bytes,
+              compositor.frames ? compositor.bytes / compositor.frames : 0, compositor.max_bytes);
+}
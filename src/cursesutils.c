@@ -7,6 +7,7 @@
 /* BY nots1dd */
 
 #include "../include/cursesutils.h"
+#include "../include/compositor.h"
 
 void draw_3d_info_win(WINDOW* win, int y, int x, int height, int width, int color_pair,
                       int shadow_color_pair);
@@ -16,7 +17,7 @@ void show_message(WINDOW* win, const char* message)
   int maxy, maxx;
   getmaxyx(win, maxy, maxx);
   mvwprintw(win, maxy - 2, 2, message);
-  wrefresh(win);
+  compositor_mark(win);
 }
 
 void clearLine(WINDOW* win, int x, int y) { mvwprintw(win, x, y, "\n"); }
@@ -142,7 +143,7 @@ int show_compression_options(WINDOW* parent_win)
       wattroff(options_win, COLOR_PAIR(COMP_COLOR_NORMAL));
 
       // Refresh and wait for user input
-      wrefresh(options_win);
+      compositor_present(options_win);
       c = wgetch(options_win);
 
       switch (c)
@@ -167,7 +168,7 @@ int show_compression_options(WINDOW* parent_win)
           break;
         case 27: // ESC key
           delwin(options_win);
-          refresh(); // Refresh the main window to ensure no artifacts remain
+          compositor_mark(stdscr); // Refresh the main window to ensure no artifacts remain
           return -1;
       }
     }
@@ -227,7 +228,7 @@ int show_compression_options(WINDOW* parent_win)
                COLOR_PAIR(COMP_COLOR_HIGHLIGHT) | COLOR_PAIR(COMP_COLOR_NORMAL) | A_BOLD);
 
       // Refresh and wait for user input
-      wrefresh(options_win);
+      compositor_present(options_win);
       c = wgetch(options_win);
 
       switch (c)
@@ -249,7 +250,7 @@ int show_compression_options(WINDOW* parent_win)
           {
             // Handle compression logic
             delwin(options_win);
-            refresh(); // Refresh the main window to ensure no artifacts remain
+            compositor_mark(stdscr); // Refresh the main window to ensure no artifacts remain
             if (choice == OPTION_TAR)
             {
               return OPTION_TAR; // return 1 (compression type: tar)
@@ -262,20 +263,20 @@ int show_compression_options(WINDOW* parent_win)
           else if (highlight == num_top_options + 1)
           {
             delwin(options_win);
-            refresh();          // Refresh the main window to ensure no artifacts remain
+            compositor_mark(stdscr); // Refresh the main window to ensure no artifacts remain
             return OPTION_EXIT; // Indicate "EXIT" was chosen
           }
           break;
         case 27: // ESC key
           delwin(options_win);
-          refresh(); // Refresh the main window to ensure no artifacts remain
+          compositor_mark(stdscr); // Refresh the main window to ensure no artifacts remain
           return -1;
       }
     }
   }
 
   delwin(options_win);
-  wrefresh(parent_win);
+  compositor_mark(parent_win);
 }
 
 void show_term_message(const char* message, int err)
@@ -287,10 +288,6 @@ void show_term_message(const char* message, int err)
   move(message_y, 0);
   clrtoeol();
 
-  move(message_y, 0);
-  clrtoeol();
-  refresh();
-
   if (err == 1)
   {
     attron(COLOR_PAIR(12));
@@ -311,7 +308,7 @@ void show_term_message(const char* message, int err)
     mvprintw(message_y, 0, " %s", message);
     attroff(COLOR_PAIR(4));
   }
-  refresh();
+  compositor_mark(stdscr);
 }
 
 void init_curses()
@@ -330,7 +327,7 @@ void draw_colored_border(WINDOW* win, int color_pair)
   wattron(win, COLOR_PAIR(color_pair));
   box(win, 0, 0); // Draw the border using box function
   wattroff(win, COLOR_PAIR(color_pair));
-  wrefresh(win);
+  compositor_mark(win);
 }
 
 void init_custom_color(short color_index, int r, int g, int b)
@@ -391,7 +388,7 @@ int confirm_action(WINDOW* win, const char* message)
   wattroff(confirm_win, A_BOLD | COLOR_PAIR(3));
   mvwprintw(confirm_win, 4, 2, "Press 'y' to confirm, 'n' to cancel.");
   mvwprintw(confirm_win, 6, 2, "Confirming the actions of this window CANNOT be reverted!");
-  wrefresh(confirm_win);
+  compositor_present(confirm_win);
 
   int ch = wgetch(confirm_win);
   delwin(confirm_win);
@@ -407,7 +404,6 @@ void draw_3d_info_win(WINDOW* win, int y, int x, int height, int width, int colo
   wattron(shadow_win, COLOR_PAIR(shadow_color_pair));
   wattroff(shadow_win, COLOR_PAIR(shadow_color_pair));
   draw_colored_border(shadow_win, 4);
-  wrefresh(shadow_win);
 }
 
 void truncate_path(char* path)
@@ -483,19 +479,15 @@ void get_user_input_from_bottom(WINDOW* win, char* buffer, int max_length, const
     wmove(win, getmaxy(win) - 1, 1);
   }
   attron(COLOR_PAIR(3));
+  // The prompt is on stdscr, the input is echoed into `win`
+  compositor_mark(stdscr);
+  compositor_present(win);
   if (strcmp(type, "goto") == 0)
   {
-    char tmp_buf[256];
-    wgetnstr(win, tmp_buf, max_length);
-    if (strcmp(tmp_buf, "..") == 0)
-    {
-      truncate_path(current_path);
-      snprintf(buffer, max_length, "%s", current_path);
-    }
-    else
-    {
-      snprintf(buffer, max_length, "%s/%s", current_path, tmp_buf);
-    }
+    // ".." and friends are resolved by navctx_open
+    char tmp_buf[PATH_MAX];
+    wgetnstr(win, tmp_buf, sizeof(tmp_buf) - 1);
+    snprintf(buffer, max_length, "%s/%s", current_path, tmp_buf);
   }
   else
   {
@@ -507,7 +499,7 @@ void get_user_input_from_bottom(WINDOW* win, char* buffer, int max_length, const
   mvprintw(y - 1, 0, " "); // Clear the prompt after getting input
   clrtoeol();                    // Clear the rest of the line to handle previous content
   attroff(COLOR_PAIR(3));
-  refresh();
+  compositor_mark(stdscr);
 }
 
 void get_user_input(WINDOW* win, char* input, int max_length)
@@ -559,6 +551,8 @@ void displayHelp(WINDOW* main_win)
     " Extract archive      - [E] {Works for .zip, {.tar.}, .7z}",
     " Compress directory   - [Z] {Works for .zip and .tar ONLY!}",
     " Move a file/dir      - [M]",
+    " Cycle sort mode      - [s] {dir order, name, natural, size, mtime, ext}",
+    " Reverse sort order   - [S]",
     " Show help win        - [?]",
     " Go to / directory    - [H]",
     " Go to ~ (home) dir   - [gh]",
@@ -632,7 +626,7 @@ void displayHelp(WINDOW* main_win)
     wattroff(help_win, A_BOLD | COLOR_PAIR(3));
 
     // Refresh and wait for user input
-    wrefresh(help_win);
+    compositor_present(help_win);
     c = wgetch(help_win);
 
     switch (c)
@@ -659,7 +653,7 @@ void displayHelp(WINDOW* main_win)
         break;
       case 'q':
         delwin(help_win);
-        refresh(); // Refresh the main window to ensure no artifacts remain
+        compositor_mark(stdscr); // Refresh the main window to ensure no artifacts remain
         return;
       default:
         break;
@@ -684,7 +678,7 @@ WINDOW* create_centered_window(int height, int width)
 
   // Initialize the window
   box(popup_win, 0, 0);
-  wrefresh(popup_win);
+  compositor_mark(popup_win);
 
   return popup_win;
 }
@@ -720,14 +714,21 @@ void check_term_size(WINDOW* win, WINDOW* info_win)
     // Redraw the borders and items
     werase(win);
     draw_colored_border(win, 2);
-    wrefresh(win);
 
     werase(info_win);
     box(info_win, 0, 0);
-    wrefresh(info_win);
+    compositor_mark(info_win);
   }
 }
 
+/* SIGWINCH is read from a signalfd (see eventloop.h), so curses has to be told the new size */
+void resize_to_term(void)
+{
+  struct winsize ws;
+  if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0 && ws.ws_row > 0 && ws.ws_col > 0)
+    resizeterm(ws.ws_row, ws.ws_col);
+}
+
 void displayProgressWindow(WINDOW* progress_win, FILE* progress_data)
 { /* IT IS VERY SLOW ATM (TAKES LIKE 0.5-0.75s for this to work half-decently)
    */
@@ -757,7 +758,7 @@ void displayProgressWindow(WINDOW* progress_win, FILE* progress_data)
 
     // Add border around the window
     box(progress_win, 0, 0);
-    wrefresh(progress_win);
+    compositor_present(progress_win);
 
     // Sleep briefly to avoid high CPU usage (adjust as necessary)
     usleep(100000); // 100 ms
@@ -772,11 +773,11 @@ void displayProgressWindow(WINDOW* progress_win, FILE* progress_data)
 
   // Add border around the window
   box(progress_win, 0, 0);
-  wrefresh(progress_win);
+  compositor_present(progress_win);
 
   // Clean up
   sleep(1); // Optional: Show final state for 1 second
   delwin(progress_win);
   clear();
-  refresh();
+  compositor_mark(stdscr);
 }
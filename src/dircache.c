@@ -0,0 +1,392 @@
+// // // // // //
+//             //
+//   LITE FM   //
+//             //
+// // // // // //
+
+/* BY nots1dd */
+
+#define _GNU_SOURCE
+
+#include "../include/dircache.h"
+#include "../include/logging.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+/* Everything that changes what a listing of the directory looks like */
+#define DIRCACHE_WATCH_MASK                                                                 \
+  (IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF | \
+   IN_ONLYDIR)
+
+/* Writes and attribute changes to its entries, what an order by metadata depends on */
+#define DIRCACHE_META_MASK (IN_MODIFY | IN_ATTRIB)
+
+size_t dircache_cap_from_env(void)
+{
+  const char* value = getenv(DIRCACHE_ENV_MB);
+  if (value == NULL || *value == '\0')
+    return (size_t)DIRCACHE_DEFAULT_MB << 20;
+
+  char*         end;
+  unsigned long mb = strtoul(value, &end, 10);
+  if (*end != '\0')
+  {
+    log_message(LOG_LEVEL_WARN, " [DIRCACHE] Ignoring invalid %s=%s", DIRCACHE_ENV_MB, value);
+    return (size_t)DIRCACHE_DEFAULT_MB << 20;
+  }
+  return (size_t)mb << 20;
+}
+
+void dircache_init(DirCache* cache, size_t max_bytes)
+{
+  memset(cache, 0, sizeof(*cache));
+  cache->max_bytes  = max_bytes;
+  cache->inotify_fd = -1;
+  if (max_bytes == 0)
+    return;
+
+  cache->inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (cache->inotify_fd == -1)
+    log_message(LOG_LEVEL_WARN, " [DIRCACHE] inotify unavailable (%s), validating with stat",
+                strerror(errno));
+}
+
+static int same_identity(const struct stat* st, const DirCacheEntry* entry)
+{
+  return st->st_dev == entry->dev && st->st_ino == entry->ino &&
+         st->st_mtim.tv_sec == entry->mtime.tv_sec && st->st_mtim.tv_nsec == entry->mtime.tv_nsec;
+}
+
+static void dircache_unlink(DirCache* cache, DirCacheEntry* entry)
+{
+  if (entry->prev)
+    entry->prev->next = entry->next;
+  else
+    cache->head = entry->next;
+  if (entry->next)
+    entry->next->prev = entry->prev;
+  else
+    cache->tail = entry->prev;
+  entry->prev = entry->next = NULL;
+}
+
+static void dircache_push_front(DirCache* cache, DirCacheEntry* entry)
+{
+  entry->prev = NULL;
+  entry->next = cache->head;
+  if (cache->head)
+    cache->head->prev = entry;
+  cache->head = entry;
+  if (cache->tail == NULL)
+    cache->tail = entry;
+}
+
+/* Watches are per inode, two paths to the same dir (through a symlink) share one */
+static int dircache_wd_in_use(const DirCache* cache, int wd)
+{
+  for (const DirCacheEntry* e = cache->head; e; e = e->next)
+  {
+    if (e->wd == wd)
+      return 1;
+  }
+  return 0;
+}
+
+static void dircache_remove(DirCache* cache, DirCacheEntry* entry)
+{
+  dircache_unlink(cache, entry);
+  cache->entries--;
+  cache->bytes -= entry->bytes;
+
+  if (entry->wd != -1 && !dircache_wd_in_use(cache, entry->wd))
+    inotify_rm_watch(cache->inotify_fd, entry->wd);
+
+  entry_store_free(&entry->items);
+  free(entry->path);
+  free(entry);
+}
+
+void dircache_free(DirCache* cache)
+{
+  while (cache->head)
+    dircache_remove(cache, cache->head);
+  if (cache->inotify_fd != -1)
+    close(cache->inotify_fd);
+  cache->inotify_fd = -1;
+}
+
+static void dircache_invalidate_wd(DirCache* cache, int wd)
+{
+  DirCacheEntry* e = cache->head;
+  while (e)
+  {
+    DirCacheEntry* next = e->next;
+    if (e->wd == wd)
+    {
+      log_message(LOG_LEVEL_DEBUG, " [DIRCACHE] %s changed, dropping its listing", e->path);
+      dircache_remove(cache, e);
+      cache->invalidations++;
+    }
+    e = next;
+  }
+}
+
+/* Entries were written to or touched, the listings hold but an order by metadata does not */
+static void dircache_unorder_wd(DirCache* cache, int wd)
+{
+  for (DirCacheEntry* e = cache->head; e; e = e->next)
+  {
+    if (e->wd == wd && (e->order & DIRCACHE_BY_META))
+      e->order = DIRCACHE_UNSORTED;
+  }
+}
+
+/*
+ * Watches `path` for what a listing in `order` depends on. The mask is added
+ * to the one the inode is watched with already, another path to the same dir
+ * may need more. Returns the watch or -1.
+ */
+static int dircache_watch(DirCache* cache, const char* path, int order)
+{
+  uint32_t mask = DIRCACHE_WATCH_MASK | IN_MASK_ADD;
+  if (order & DIRCACHE_BY_META)
+    mask |= DIRCACHE_META_MASK;
+  return inotify_add_watch(cache->inotify_fd, path, mask);
+}
+
+/*
+ * @DIRCACHE_PROCESS_EVENTS
+ *
+ * Drops every listing whose directory changed since it was cached.
+ * Non blocking, costs a single read when nothing happened.
+ */
+void dircache_process_events(DirCache* cache)
+{
+  if (cache->inotify_fd == -1)
+    return;
+
+  char buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+  for (;;)
+  {
+    ssize_t len = read(cache->inotify_fd, buf, sizeof(buf));
+    if (len <= 0)
+      break; // EAGAIN: queue is empty
+
+    for (char* ptr = buf; ptr < buf + len;)
+    {
+      const struct inotify_event* event = (const struct inotify_event*)ptr;
+      ptr += sizeof(struct inotify_event) + event->len;
+
+      if (event->mask & IN_Q_OVERFLOW)
+      {
+        // We lost track of what changed, nothing cached can be trusted
+        log_message(LOG_LEVEL_WARN, " [DIRCACHE] inotify queue overflow, flushing cache");
+        while (cache->head)
+        {
+          dircache_remove(cache, cache->head);
+          cache->invalidations++;
+        }
+        continue;
+      }
+      if (event->mask & DIRCACHE_WATCH_MASK)
+        dircache_invalidate_wd(cache, event->wd);
+      else
+        dircache_unorder_wd(cache, event->wd);
+    }
+  }
+}
+
+static DirCacheEntry* dircache_find(const DirCache* cache, const char* path)
+{
+  for (DirCacheEntry* e = cache->head; e; e = e->next)
+  {
+    if (strcmp(e->path, path) == 0)
+      return e;
+  }
+  return NULL;
+}
+
+/*
+ * @DIRCACHE_LOOKUP
+ *
+ * Copies the cached listing of `path` into `out` and the tag of the order it
+ * is in into `order`. Returns 1 on a hit, 0 on a miss (in which case `out`
+ * and `order` are left untouched).
+ */
+int dircache_lookup(DirCache* cache, const char* path, EntryStore* out, int* order)
+{
+  if (cache->max_bytes == 0)
+    return 0;
+
+  dircache_process_events(cache);
+
+  DirCacheEntry* entry = dircache_find(cache, path);
+  if (entry && entry->wd == -1)
+  {
+    // Not watched, fall back to comparing the directory's identity
+    struct stat st;
+    if (stat(path, &st) == -1 || !same_identity(&st, entry))
+    {
+      dircache_remove(cache, entry);
+      cache->invalidations++;
+      entry = NULL;
+    }
+  }
+
+  if (entry == NULL || entry_store_copy(out, &entry->items) != 0)
+  {
+    cache->misses++;
+    return 0;
+  }
+
+  dircache_unlink(cache, entry);
+  dircache_push_front(cache, entry);
+  cache->hits++;
+  *order = entry->order;
+  return 1;
+}
+
+/*
+ * Whether a listing of `path` is cached, without copying it or counting a
+ * hit/miss. Unwatched entries are not stat'ed here, lookup still validates
+ * them.
+ */
+int dircache_contains(DirCache* cache, const char* path)
+{
+  if (cache->max_bytes == 0)
+    return 0;
+
+  dircache_process_events(cache);
+  return dircache_find(cache, path) != NULL;
+}
+
+/*
+ * @DIRCACHE_INSERT
+ *
+ * `scanned` is the directory's stat from when the listing was read. The watch
+ * is added before the directory is checked against it, so a change that raced
+ * the scan either shows up as a different mtime here or as an event later.
+ * `order` tags the order `items` are in.
+ */
+void dircache_insert(DirCache* cache, const char* path, const struct stat* scanned,
+                     const EntryStore* items, int order)
+{
+  if (cache->max_bytes == 0)
+    return;
+
+  DirCacheEntry* old = dircache_find(cache, path);
+  if (old)
+    dircache_remove(cache, old);
+
+  DirCacheEntry* entry = calloc(1, sizeof(DirCacheEntry));
+  if (entry == NULL)
+    return;
+  entry->path  = strdup(path);
+  entry->dev   = scanned->st_dev;
+  entry->ino   = scanned->st_ino;
+  entry->mtime = scanned->st_mtim;
+  entry->wd    = -1;
+  entry->order = order;
+  entry_store_init(&entry->items);
+
+  if (entry->path == NULL || entry_store_copy(&entry->items, items) != 0)
+  {
+    entry_store_free(&entry->items);
+    free(entry->path);
+    free(entry);
+    return;
+  }
+  entry->bytes =
+    sizeof(DirCacheEntry) + strlen(path) + 1 + entry_store_footprint(&entry->items);
+
+  if (cache->inotify_fd != -1)
+  {
+    entry->wd = dircache_watch(cache, path, order);
+    if (entry->wd == -1)
+      log_message(LOG_LEVEL_DEBUG, " [DIRCACHE] Unable to watch %s: %s", path, strerror(errno));
+  }
+  // Nothing would tell us when sizes or mtimes change
+  if (entry->wd == -1 && (order & DIRCACHE_BY_META))
+    entry->order = DIRCACHE_UNSORTED;
+
+  struct stat now;
+  if (entry->bytes > cache->max_bytes || stat(path, &now) == -1 || !same_identity(&now, entry))
+  {
+    if (entry->wd != -1 && !dircache_wd_in_use(cache, entry->wd))
+      inotify_rm_watch(cache->inotify_fd, entry->wd);
+    entry_store_free(&entry->items);
+    free(entry->path);
+    free(entry);
+    return;
+  }
+
+  while (cache->tail &&
+         (cache->bytes + entry->bytes > cache->max_bytes || cache->entries >= DIRCACHE_MAX_ENTRIES))
+  {
+    dircache_remove(cache, cache->tail);
+    cache->evictions++;
+  }
+
+  dircache_push_front(cache, entry);
+  cache->entries++;
+  cache->bytes += entry->bytes;
+}
+
+/*
+ * @DIRCACHE_SET_ORDER
+ *
+ * Replaces the cached listing of `path` with `items`, the same listing
+ * sorted in the order tagged `order`. Does nothing if `path` is not cached,
+ * or not with the listing in `items` (it changed since).
+ */
+void dircache_set_order(DirCache* cache, const char* path, const EntryStore* items, int order)
+{
+  if (cache->max_bytes == 0)
+    return;
+
+  dircache_process_events(cache);
+  DirCacheEntry* entry = dircache_find(cache, path);
+  if (entry == NULL || entry->items.count != items->count ||
+      entry->items.arena_len != items->arena_len)
+    return;
+
+  if ((order & DIRCACHE_BY_META) && entry->wd == -1)
+    order = DIRCACHE_UNSORTED; // nothing would tell us when sizes or mtimes change
+  else if (order & DIRCACHE_BY_META)
+  {
+    int wd = dircache_watch(cache, path, order);
+    if (wd != entry->wd)
+    {
+      // `path` is not the directory that was cached anymore
+      if (wd != -1 && !dircache_wd_in_use(cache, wd))
+        inotify_rm_watch(cache->inotify_fd, wd);
+      dircache_remove(cache, entry);
+      cache->invalidations++;
+      return;
+    }
+  }
+
+  if (entry_store_copy(&entry->items, items) != 0)
+  {
+    dircache_remove(cache, entry);
+    return;
+  }
+  entry->order = order;
+  cache->bytes -= entry->bytes;
+  entry->bytes =
+    sizeof(DirCacheEntry) + strlen(path) + 1 + entry_store_footprint(&entry->items);
+  cache->bytes += entry->bytes;
+}
+
+void dircache_log_stats(const DirCache* cache)
+{
+  log_message(LOG_LEVEL_DEBUG,
+              " [DIRCACHE] hits: %lu, misses: %lu, evictions: %lu, invalidations: %lu, "
+              "%zu entries using %zu / %zu bytes",
+              cache->hits, cache->misses, cache->evictions, cache->invalidations, cache->entries,
+              cache->bytes, cache->max_bytes);
+}
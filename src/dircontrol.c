@@ -55,13 +55,10 @@ void get_current_working_directory(char* cwd, size_t size)
   }
 }
 
-int create_directory(const char* path, const char* dirname, char* timestamp)
+int create_directory(int dir_fd, const char* dirname, char* timestamp)
 {
-  char full_path[PATH_MAX];
-  snprintf(full_path, PATH_MAX, "%s/%s", path, dirname);
-
   // Create the directory
-  if (mkdir(full_path, 0777) == -1)
+  if (mkdirat(dir_fd, dirname, 0777) == -1)
   {
     if (errno == EEXIST)
       return 1; // Directory already exists
@@ -120,30 +117,20 @@ void change_directory_with_popen(const char *path) {
 }
 
 
-int remove_file(const char* path, const char* filename)
+int remove_file(int dir_fd, const char* filename)
 {
-  char full_path[PATH_MAX];
-  snprintf(full_path, PATH_MAX, "%s/%s", path, filename);
-
-  truncate_symlink_name(full_path);
-
   // Remove the file
-  if (unlink(full_path) == -1)
+  if (unlinkat(dir_fd, filename, 0) == -1)
     return -1; // Error removing file
 
   return 0; // File removed successfully
 }
 
 /* NOT RECURSIVE */
-int remove_directory(const char* path, const char* dirname)
+int remove_directory(int dir_fd, const char* dirname)
 {
-  char full_path[PATH_MAX];
-  snprintf(full_path, PATH_MAX, "%s/%s", path, dirname);
-
-  truncate_symlink_name(full_path);
-
   // Remove the directory and its contents
-  if (rmdir(full_path) == -1)
+  if (unlinkat(dir_fd, dirname, AT_REMOVEDIR) == -1)
     return -1; // Error removing directory
 
   return 0; // Directory removed successfully
@@ -154,11 +141,8 @@ int remove_directory(const char* path, const char* dirname)
 /*
  * @SYMLINKS and Recursive deletion
  *
- * Due to the way that LiteFM handles symlinks currently,
- *
- * We need to truncate every single filename to ensure any symlink formatted name
- * (name ->symlinkName)
- * is not given to fstat to check for status before deletion
+ * Entries are lstat'ed (AT_SYMLINK_NOFOLLOW), so a symlink is unlinked like
+ * any other file and never followed.
  *
  * The log does a good job in giving concise information on the inodes deleted,
  * the directories it attempts at deleting, so on
@@ -167,19 +151,24 @@ int remove_directory(const char* path, const char* dirname)
  *
  * But time wise :: WORKS ON PAR WITH `rm -rf` command
  *
+ * Every level is opened relative to its parent's fd (`base_path` is only used
+ * for the log), so the depth of the tree does not matter. O_NOFOLLOW makes
+ * sure we never descend through a symlink into somebody else's tree.
+ *
  */
 
 int remove_directory_recursive(const char* base_path, const char* dirname, int parent_fd)
 {
   char full_path[PATH_MAX];
   snprintf(full_path, PATH_MAX, "%s/%s", base_path, dirname);
-  int dir_fd = openat(parent_fd, full_path, O_RDONLY | O_DIRECTORY);
+  int dir_fd = openat(parent_fd, dirname, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
   if (dir_fd == -1)
   {
     show_term_message("Error opening directory.", 1);
     return -1;
   }
 
+  // From here on dir_fd belongs to `dir`, closedir closes it
   DIR* dir = fdopendir(dir_fd);
   if (dir == NULL)
   {
@@ -201,8 +190,6 @@ int remove_directory_recursive(const char* base_path, const char* dirname, int p
       continue;
     }
 
-    truncate_symlink_name(entry->d_name);
-
     struct stat statbuf;
     if (fstatat(dir_fd, entry->d_name, &statbuf, AT_SYMLINK_NOFOLLOW) == 0)
     {
@@ -212,7 +199,6 @@ int remove_directory_recursive(const char* base_path, const char* dirname, int p
         if (remove_directory_recursive(full_path, entry->d_name, dir_fd) != 0)
         {
           closedir(dir);
-          close(dir_fd);
           return -1;
         }
         num_dirs_deleted++;
@@ -226,7 +212,6 @@ int remove_directory_recursive(const char* base_path, const char* dirname, int p
           log_message(LOG_LEVEL_ERROR, "   Error removing file: %s", entry->d_name);
           show_term_message("Error removing a file. Check log for more..", 1);
           closedir(dir);
-          close(dir_fd);
           return -1;
         }
         num_files_deleted++;
@@ -238,13 +223,11 @@ int remove_directory_recursive(const char* base_path, const char* dirname, int p
       log_message(LOG_LEVEL_ERROR, "   Error getting status of file: %s", entry->d_name);
       show_term_message("Unable to get status of a file. Check log for more..", 1);
       closedir(dir);
-      close(dir_fd);
       return -1;
     }
   }
 
   closedir(dir);
-  close(dir_fd);
 
   // Remove the now-empty directory
   if (unlinkat(parent_fd, dirname, AT_REMOVEDIR) != 0)
@@ -265,38 +248,28 @@ int remove_directory_recursive(const char* base_path, const char* dirname, int p
   return 0;
 }
 
-int rename_file_or_dir(const char* old_path, const char* new_name)
+int rename_file_or_dir(int dir_fd, const char* old_name, const char* new_name)
 {
-  char new_path[PATH_MAX];
-
-  // Construct the new path
-  snprintf(new_path, sizeof(new_path), "%s/%s", dirname(strdup(old_path)), new_name);
-
   // Rename the file or directory
-  if (rename(old_path, new_path) != 0)
+  if (renameat(dir_fd, old_name, dir_fd, new_name) != 0)
   {
-    log_message(LOG_LEVEL_ERROR, "Unable to rename %s to %s", old_path, new_path);
+    log_message(LOG_LEVEL_ERROR, "Unable to rename %s to %s: %s", old_name, new_name,
+                strerror(errno));
     return -1; // Return error code if rename fails
   }
 
   return 0; // Return success code
 }
 
-void move_file_or_dir(WINDOW* win, const char* basepath, const char* current_path,
-                      const char* selected_item)
+/*
+ * `base_fd` and `current_fd` are the source and destination directories
+ * (paths only for the messages), the item keeps its name.
+ */
+void move_file_or_dir(WINDOW* win, int base_fd, const char* basepath, int current_fd,
+                      const char* current_path, const char* selected_item)
 {
-  char full_current_path[MAX_PATH_LENGTH];
-  char full_destination_path[MAX_PATH_LENGTH];
-
-  // Construct the full path of the selected item
-  snprintf(full_current_path, sizeof(full_current_path), "%s/%s", basepath, selected_item);
-
-  // Construct the full destination path
-  snprintf(full_destination_path, sizeof(full_destination_path), "%s/%s", current_path,
-           selected_item);
-
   // Attempt to rename (move) the file or directory
-  if (rename(full_current_path, full_destination_path) == 0)
+  if (renameat(base_fd, selected_item, current_fd, selected_item) == 0)
   {
     char msg[256];
     log_message(LOG_LEVEL_INFO, "Moved `%s` from `%s` to `%s`", selected_item, basepath,
@@ -307,7 +280,8 @@ void move_file_or_dir(WINDOW* win, const char* basepath, const char* current_pat
   }
   else
   {
-    log_message(LOG_LEVEL_ERROR, "Error moving file/dir `%s`", selected_item);
+    log_message(LOG_LEVEL_ERROR, "Error moving file/dir `%s`: %s", selected_item,
+                strerror(errno));
     show_term_message("Error moving file or directory.", 1);
   }
 }
@@ -334,16 +308,18 @@ int is_directory(const char* path)
  * I will change this for a more wide scoped renaming function
  * if I understand more about safer and proper file handling
  *
+ * `name` is an entry of `dir_fd` (`path` is that directory, for the prompt)
+ *
  */
 
-void handle_rename(WINDOW* win, const char* path)
+void handle_rename(WINDOW* win, int dir_fd, const char* path, const char* name)
 {
   char        new_name[PATH_MAX];
   char        old_name[PATH_MAX];
   struct stat path_stat;
 
   // Copy the original filename
-  strncpy(old_name, basename((char*)path), PATH_MAX);
+  snprintf(old_name, PATH_MAX, "%s", name);
 
   // Prompt for new name
   get_user_input_from_bottom(win, new_name, sizeof(new_name), "rename", path);
@@ -356,7 +332,7 @@ void handle_rename(WINDOW* win, const char* path)
   }
 
   // Check if the path is a file or directory
-  if (stat(path, &path_stat) != 0)
+  if (fstatat(dir_fd, old_name, &path_stat, 0) != 0)
   {
     show_term_message("Unable to stat path. Aborting rename.", 1);
     return;
@@ -398,26 +374,23 @@ void handle_rename(WINDOW* win, const char* path)
   }
 
   // Perform rename
-  if (rename_file_or_dir(path, new_name) == 0)
+  if (rename_file_or_dir(dir_fd, old_name, new_name) == 0)
   {
-    log_message(LOG_LEVEL_INFO, "Rename successful for %s", path);
+    log_message(LOG_LEVEL_INFO, "Rename successful for %s/%s", path, old_name);
     show_term_message("Rename successful.", 0);
     // Update file list if needed
   }
   else
   {
-    log_message(LOG_LEVEL_ERROR, "Rename error for %s", path);
+    log_message(LOG_LEVEL_ERROR, "Rename error for %s/%s", path, old_name);
     show_term_message("Rename failed.", 1);
   }
 }
 
-int create_file(const char* path, const char* filename, char* timestamp)
+int create_file(int dir_fd, const char* filename, char* timestamp)
 {
-  char full_path[PATH_MAX];
-  snprintf(full_path, PATH_MAX, "%s/%s", path, filename);
-
   // Create the file
-  int fd = open(full_path, O_CREAT | O_EXCL | O_WRONLY, 0666);
+  int fd = openat(dir_fd, filename, O_CREAT | O_EXCL | O_WRONLY | O_CLOEXEC, 0666);
   if (fd == -1)
   {
     if (errno == EEXIST)
@@ -439,16 +412,16 @@ int create_file(const char* path, const char* filename, char* timestamp)
 void resolve_path(const char* base_path, const char* relative_path, char* resolved_path)
 {
   // Create a buffer to hold the concatenated path
-  char full_path[MAX_PATH_LENGTH];
+  char full_path[PATH_MAX];
 
   // Ensure base_path ends with a '/'
   if (base_path[strlen(base_path) - 1] != '/')
   {
-    snprintf(full_path, MAX_PATH_LENGTH, "%s/%s", base_path, relative_path);
+    snprintf(full_path, PATH_MAX, "%s/%s", base_path, relative_path);
   }
   else
   {
-    snprintf(full_path, MAX_PATH_LENGTH, "%s%s", base_path, relative_path);
+    snprintf(full_path, PATH_MAX, "%s%s", base_path, relative_path);
   }
 
   // Resolve the absolute path
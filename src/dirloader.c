@@ -0,0 +1,333 @@
+// // // // // //
+//             //
+//   LITE FM   //
+//             //
+// // // // // //
+
+/* BY nots1dd */
+
+#define _GNU_SOURCE
+
+#include "../include/dirloader.h"
+#include "../include/dirscan.h"
+#include "../include/logging.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+struct DirLoadJob
+{
+  pthread_mutex_t lock;
+  pthread_cond_t  published; /* signalled on every publish and when the scan ends */
+  int             refs;      /* worker + loader */
+  int             cancelled;
+  int             finished;
+  int             failed;
+  struct stat     stat;      /* the directory as it was when the scan started */
+  size_t          seen;      /* entries read by the worker so far */
+  EntryStore      pending;   /* published but not yet drained by the UI */
+  int             base_fd;   /* `name` is opened relative to this (owned, or AT_FDCWD) */
+  int             notify_fd; /* the loader's, not owned */
+  char            name[PATH_MAX];
+  char            path[PATH_MAX]; /* for log messages */
+};
+
+/* Worker side state, never shared */
+typedef struct
+{
+  DirLoadJob* job;
+  EntryStore  batch;
+  size_t      batch_limit;
+  int         dir_fd;
+  int         out_of_memory;
+} DirLoadWorker;
+
+static void dirloader_job_release(DirLoadJob* job)
+{
+  pthread_mutex_lock(&job->lock);
+  int refs = --job->refs;
+  pthread_mutex_unlock(&job->lock);
+
+  if (refs == 0)
+  {
+    if (job->base_fd >= 0)
+      close(job->base_fd);
+    entry_store_free(&job->pending);
+    pthread_cond_destroy(&job->published);
+    pthread_mutex_destroy(&job->lock);
+    free(job);
+  }
+}
+
+/* Called with the job locked, so a cancelled job is done with the fd once the flag is set */
+static void dirloader_notify(DirLoadJob* job)
+{
+  if (job->cancelled || job->notify_fd == -1)
+    return;
+
+  // Can only fail with the counter about to overflow, the UI has wake ups pending then
+  uint64_t one = 1;
+  ssize_t  rc  = write(job->notify_fd, &one, sizeof(one));
+  (void)rc;
+}
+
+/* Hands the worker's batch over to the UI side. Returns non zero if the job got cancelled. */
+static int dirloader_publish(DirLoadWorker* worker)
+{
+  DirLoadJob* job = worker->job;
+
+  pthread_mutex_lock(&job->lock);
+  int cancelled = job->cancelled;
+  if (!cancelled && entry_store_append_grouped(&job->pending, &worker->batch) == -1)
+    worker->out_of_memory = 1;
+  job->seen += worker->batch.count;
+  pthread_cond_broadcast(&job->published);
+  dirloader_notify(job);
+  pthread_mutex_unlock(&job->lock);
+
+  entry_store_clear(&worker->batch);
+  worker->batch_limit = DIRLOADER_BATCH;
+  return cancelled || worker->out_of_memory;
+}
+
+static int dirloader_collect(void* data, const char* name, size_t name_len, unsigned char d_type)
+{
+  DirLoadWorker* worker = (DirLoadWorker*)data;
+
+  // Symlink targets are read later, only for the rows that get shown (see entrymeta.h)
+  int index = entry_store_push(&worker->batch, name, name_len, entry_type_from_dtype(d_type));
+
+  if (index == -1)
+  {
+    worker->out_of_memory = 1;
+    return 1; // Keep what we have
+  }
+
+  if (worker->batch.count >= worker->batch_limit)
+    return dirloader_publish(worker);
+
+  // A cancelled job is only noticed on publish, this keeps the lock off the hot path
+  return 0;
+}
+
+static void* dirloader_thread(void* arg)
+{
+  DirLoadWorker worker;
+  worker.job           = (DirLoadJob*)arg;
+  worker.batch_limit   = DIRLOADER_FIRST_BATCH;
+  worker.out_of_memory = 0;
+  entry_store_init(&worker.batch);
+
+  int failed    = 0;
+  worker.dir_fd = openat(worker.job->base_fd, worker.job->name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (worker.dir_fd == -1)
+  {
+    log_message(LOG_LEVEL_ERROR, " [DIRLOADER] Unable to open directory %s: %s", worker.job->path,
+                strerror(errno));
+    failed = 1;
+  }
+  else
+  {
+    if (fstat(worker.dir_fd, &worker.job->stat) == -1)
+      failed = 1;
+    // Dot entries are always read, hiding them is up to the view (see entrystore.h)
+    if (dirscan_fd(worker.dir_fd, 1, dirloader_collect, &worker) == -1)
+      failed = 1;
+    close(worker.dir_fd);
+    dirloader_publish(&worker);
+  }
+
+  if (worker.out_of_memory)
+    log_message(LOG_LEVEL_ERROR, " [DIRLOADER] Out of memory, %s is only partially listed",
+                worker.job->path);
+
+  pthread_mutex_lock(&worker.job->lock);
+  worker.job->failed   = failed || worker.out_of_memory;
+  worker.job->finished = 1;
+  pthread_cond_broadcast(&worker.job->published);
+  dirloader_notify(worker.job);
+  pthread_mutex_unlock(&worker.job->lock);
+
+  entry_store_free(&worker.batch);
+  dirloader_job_release(worker.job);
+  return NULL;
+}
+
+void dirloader_init(DirLoader* loader)
+{
+  memset(loader, 0, sizeof(*loader));
+  loader->notify_fd = -1;
+}
+
+/* Applies to the scans started from now on */
+void dirloader_set_notify(DirLoader* loader, int notify_fd) { loader->notify_fd = notify_fd; }
+
+/*
+ * @DIRLOADER_START
+ *
+ * Cancels whatever scan is running and starts listing `name`, relative to
+ * `dir_fd` (may be AT_FDCWD, or an O_PATH fd with name "."), in the
+ * background. The fd is duplicated, the caller keeps its own. `path` names
+ * the directory in the loader (cache key, log messages).
+ *
+ * Returns 0 on success, -1 if the worker could not be started.
+ */
+int dirloader_start(DirLoader* loader, int dir_fd, const char* name, const char* path)
+{
+  dirloader_cancel(loader);
+  loader->complete = 0;
+
+  DirLoadJob* job = calloc(1, sizeof(DirLoadJob));
+  if (job == NULL)
+    return -1;
+
+  job->base_fd = AT_FDCWD;
+  if (dir_fd != AT_FDCWD && (job->base_fd = fcntl(dir_fd, F_DUPFD_CLOEXEC, 0)) == -1)
+  {
+    log_message(LOG_LEVEL_ERROR, " [DIRLOADER] Unable to dup fd of %s: %s", path,
+                strerror(errno));
+    free(job);
+    return -1;
+  }
+
+  pthread_mutex_init(&job->lock, NULL);
+  pthread_cond_init(&job->published, NULL);
+  entry_store_init(&job->pending);
+  snprintf(job->name, sizeof(job->name), "%s", name);
+  snprintf(job->path, sizeof(job->path), "%s", path);
+  job->refs      = 2;
+  job->notify_fd = loader->notify_fd;
+
+  pthread_attr_t attr;
+  pthread_t      thread;
+  pthread_attr_init(&attr);
+  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+  int rc = pthread_create(&thread, &attr, dirloader_thread, job);
+  pthread_attr_destroy(&attr);
+
+  if (rc != 0)
+  {
+    log_message(LOG_LEVEL_ERROR, " [DIRLOADER] Unable to start worker: %s", strerror(rc));
+    job->refs = 1;
+    dirloader_job_release(job);
+    return -1;
+  }
+
+  loader->job = job;
+  snprintf(loader->path, sizeof(loader->path), "%s", path);
+  return 0;
+}
+
+/* Never waits for the worker, it notices the flag on its next publish and bails out */
+void dirloader_cancel(DirLoader* loader)
+{
+  if (loader->job == NULL)
+    return;
+
+  pthread_mutex_lock(&loader->job->lock);
+  loader->job->cancelled = 1;
+  pthread_mutex_unlock(&loader->job->lock);
+
+  dirloader_job_release(loader->job);
+  loader->job = NULL;
+}
+
+/* Blocks until the scan finishes or `timeout_ms` passes, whichever comes first */
+void dirloader_wait(DirLoader* loader, int timeout_ms)
+{
+  if (loader->job == NULL)
+    return;
+
+  struct timespec deadline;
+  clock_gettime(CLOCK_REALTIME, &deadline);
+  deadline.tv_sec += timeout_ms / 1000;
+  deadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+  if (deadline.tv_nsec >= 1000000000L)
+  {
+    deadline.tv_sec++;
+    deadline.tv_nsec -= 1000000000L;
+  }
+
+  pthread_mutex_lock(&loader->job->lock);
+  while (!loader->job->finished)
+  {
+    if (pthread_cond_timedwait(&loader->job->published, &loader->job->lock, &deadline) ==
+        ETIMEDOUT)
+      break;
+  }
+  pthread_mutex_unlock(&loader->job->lock);
+}
+
+int dirloader_busy(const DirLoader* loader) { return loader->job != NULL; }
+
+size_t dirloader_seen(const DirLoader* loader)
+{
+  if (loader->job == NULL)
+    return 0;
+
+  pthread_mutex_lock(&loader->job->lock);
+  size_t seen = loader->job->seen;
+  pthread_mutex_unlock(&loader->job->lock);
+  return seen;
+}
+
+/*
+ * @DIRLOADER_DRAIN
+ *
+ * UI thread only. Moves everything published so far into `items`.
+ *
+ * If `highlight` is the row of an already loaded entry it follows that entry
+ * when new directories get slotted in above, so the cursor stays on the same
+ * entry. A row past the loaded entries is left alone (e.g. a highlight
+ * restored from history that is still streaming in).
+ */
+DirLoaderState dirloader_drain(DirLoader* loader, EntryStore* items, int* highlight,
+                               size_t* added)
+{
+  if (added)
+    *added = 0;
+  if (loader->job == NULL)
+    return DIRLOADER_IDLE;
+
+  DirLoadJob* job = loader->job;
+  pthread_mutex_lock(&job->lock);
+
+  size_t old_count     = items->count;
+  size_t old_dir_count = items->dir_count;
+  int    old_rows      = entry_store_rows(items);
+  size_t highlighted   = highlight ? entry_store_record(items, *highlight) : old_count;
+  int    shift         = entry_store_append_grouped(items, &job->pending);
+  entry_store_clear(&job->pending);
+  int finished = job->finished;
+  int failed   = job->failed;
+  if (finished && !failed)
+    loader->stat = job->stat;
+
+  pthread_mutex_unlock(&job->lock);
+
+  if (highlighted < old_count)
+  {
+    if (shift > 0 && highlighted >= old_dir_count)
+      highlighted += (size_t)shift;
+    *highlight = entry_store_row(items, highlighted);
+  }
+  if (added)
+    *added = (size_t)(entry_store_rows(items) - old_rows);
+
+  if (!finished)
+    return DIRLOADER_LOADING;
+
+  dirloader_job_release(job);
+  loader->job      = NULL;
+  loader->complete = !failed && shift != -1;
+  return failed ? DIRLOADER_FAILED : DIRLOADER_DONE;
+}
@@ -0,0 +1,257 @@
+// // // // // //
+//             //
+//   LITE FM   //
+//             //
+// // // // // //
+
+/* BY nots1dd */
+
+#define _GNU_SOURCE
+
+#include "../include/dirprefetch.h"
+#include "../include/logging.h"
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/vfs.h>
+#include <unistd.h>
+
+/* statfs f_type values of filesystems where a speculative scan costs network
+ * round trips (or worse, triggers a mount). Spelled out here since not every
+ * one of them is in <linux/magic.h> */
+#define FS_MAGIC_NFS    0x00006969u
+#define FS_MAGIC_SMB    0x0000517Bu
+#define FS_MAGIC_CIFS   0xFF534D42u
+#define FS_MAGIC_SMB2   0xFE534D42u
+#define FS_MAGIC_FUSE   0x65735546u
+#define FS_MAGIC_V9FS   0x01021997u
+#define FS_MAGIC_AFS    0x5346414Fu
+#define FS_MAGIC_CEPH   0x00C36400u
+#define FS_MAGIC_CODA   0x73757245u
+#define FS_MAGIC_NCP    0x0000564Cu
+#define FS_MAGIC_AUTOFS 0x00000187u
+
+static long elapsed_ms(const struct timespec* since, const struct timespec* now)
+{
+  return (now->tv_sec - since->tv_sec) * 1000 + (now->tv_nsec - since->tv_nsec) / 1000000;
+}
+
+/*
+ * The highlighted row was already statx'ed for the info pane, so asking its
+ * filesystem for statfs does not reach anything the UI has not touched yet.
+ */
+static int is_remote_fs(int fd)
+{
+  struct statfs sfs;
+  if (fstatfs(fd, &sfs) == -1)
+    return 1; // Cannot tell, leave it alone
+
+  switch ((uint32_t)sfs.f_type)
+  {
+    case FS_MAGIC_NFS:
+    case FS_MAGIC_SMB:
+    case FS_MAGIC_CIFS:
+    case FS_MAGIC_SMB2:
+    case FS_MAGIC_FUSE:
+    case FS_MAGIC_V9FS:
+    case FS_MAGIC_AFS:
+    case FS_MAGIC_CEPH:
+    case FS_MAGIC_CODA:
+    case FS_MAGIC_NCP:
+    case FS_MAGIC_AUTOFS:
+      return 1;
+    default:
+      return 0;
+  }
+}
+
+void dirprefetch_init(DirPrefetch* pf)
+{
+  memset(pf, 0, sizeof(*pf));
+  dirloader_init(&pf->loader);
+  entry_store_init(&pf->items);
+  pf->enabled = 1;
+
+  const char* value = getenv(DIRPREFETCH_ENV);
+  if (value == NULL || *value == '\0' || strcmp(value, "1") == 0)
+    return;
+  if (strcmp(value, "0") == 0)
+    pf->enabled = 0;
+  else if (strcmp(value, "remote") == 0)
+    pf->allow_remote = 1;
+  else
+    log_message(LOG_LEVEL_WARN, " [PREFETCH] Ignoring invalid %s=%s", DIRPREFETCH_ENV, value);
+}
+
+void dirprefetch_free(DirPrefetch* pf)
+{
+  dirloader_cancel(&pf->loader);
+  entry_store_free(&pf->items);
+}
+
+/* Called on every key press, prefetching only starts once input stops */
+void dirprefetch_touch(DirPrefetch* pf)
+{
+  clock_gettime(CLOCK_MONOTONIC, &pf->idle_since);
+  pf->waiting = 1;
+}
+
+/* How long the main loop may sleep before the next tick is due, -1 if no tick is due */
+int dirprefetch_timeout(const DirPrefetch* pf)
+{
+  if (!pf->enabled || !pf->waiting)
+    return -1;
+
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  long idle     = DIRPREFETCH_IDLE_MS - elapsed_ms(&pf->idle_since, &now);
+  long interval = DIRPREFETCH_INTERVAL_MS - elapsed_ms(&pf->last_start, &now);
+  long wait     = idle > interval ? idle : interval;
+  return wait > 0 ? (int)wait : 0;
+}
+
+static void dirprefetch_cancel(DirPrefetch* pf)
+{
+  if (!dirloader_busy(&pf->loader))
+    return;
+  dirloader_cancel(&pf->loader);
+  entry_store_clear(&pf->items);
+  pf->cancelled++;
+}
+
+/*
+ * @DIRPREFETCH_COLLECT
+ *
+ * Pulls in what the running scan has published. A finished listing goes
+ * into the cache, one that grew too large is dropped.
+ */
+void dirprefetch_collect(DirPrefetch* pf, DirCache* cache)
+{
+  if (!dirloader_busy(&pf->loader))
+    return;
+
+  DirLoaderState state = dirloader_drain(&pf->loader, &pf->items, NULL, NULL);
+  if (state == DIRLOADER_DONE)
+  {
+    if (pf->loader.complete)
+    {
+      dircache_insert(cache, pf->loader.path, &pf->loader.stat, &pf->items,
+                      DIRCACHE_UNSORTED);
+      pf->cached++;
+      log_message(LOG_LEVEL_DEBUG, " [PREFETCH] Cached %s (%zu entries)", pf->loader.path,
+                  pf->items.count);
+    }
+    entry_store_clear(&pf->items);
+  }
+  else if (state == DIRLOADER_FAILED)
+  {
+    entry_store_clear(&pf->items);
+  }
+  else if (pf->items.count > DIRPREFETCH_MAX_ENTRIES)
+  {
+    log_message(LOG_LEVEL_DEBUG, " [PREFETCH] Dropping %s, more than %d entries",
+                pf->loader.path, DIRPREFETCH_MAX_ENTRIES);
+    dirprefetch_cancel(pf);
+  }
+}
+
+/*
+ * @DIRPREFETCH_TICK
+ *
+ * Called from the main loop whenever there was no input. `name` is the
+ * highlighted directory (relative to `dir_fd`) and `target` its full path,
+ * both NULL if there is nothing worth prefetching (a file is highlighted,
+ * the current listing is still loading, ...).
+ */
+void dirprefetch_tick(DirPrefetch* pf, DirCache* cache, int dir_fd, const char* name,
+                      const char* target)
+{
+  if (!pf->enabled)
+    return;
+
+  pf->waiting = 0;
+  dirprefetch_collect(pf, cache);
+
+  if (target == NULL)
+  {
+    dirprefetch_cancel(pf);
+    pf->target[0] = '\0';
+    return;
+  }
+  // Running, done or given up on already
+  if (strcmp(pf->target, target) == 0)
+    return;
+
+  // The cursor moved on, the old scan is of no use anymore
+  dirprefetch_cancel(pf);
+
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  if (elapsed_ms(&pf->idle_since, &now) < DIRPREFETCH_IDLE_MS ||
+      elapsed_ms(&pf->last_start, &now) < DIRPREFETCH_INTERVAL_MS)
+  {
+    pf->waiting = 1;
+    return;
+  }
+
+  if (snprintf(pf->target, sizeof(pf->target), "%s", target) >= (int)sizeof(pf->target))
+    return; // Truncated, the target stays marked as tried
+
+  if (dircache_contains(cache, target))
+    return;
+
+  int fd = openat(dir_fd, name, O_PATH | O_DIRECTORY | O_CLOEXEC);
+  if (fd == -1)
+    return;
+  if (!pf->allow_remote && is_remote_fs(fd))
+  {
+    log_message(LOG_LEVEL_DEBUG, " [PREFETCH] Skipping %s (network/FUSE filesystem)", target);
+    pf->skipped_remote++;
+    close(fd);
+    return;
+  }
+
+  entry_store_clear(&pf->items);
+  int started = dirloader_start(&pf->loader, fd, ".", target);
+  close(fd);
+  if (started == -1)
+    return;
+  pf->last_start = now;
+  pf->started++;
+}
+
+/*
+ * @DIRPREFETCH_ADOPT
+ *
+ * If the directory being entered is the one the prefetcher is still reading,
+ * hands its scan (and what it has delivered so far) over to `loader` so
+ * list_dir carries on from there instead of reading the directory again.
+ *
+ * Returns 1 if the scan was adopted, 0 otherwise.
+ */
+int dirprefetch_adopt(DirPrefetch* pf, const char* path, DirLoader* loader, EntryStore* items)
+{
+  if (!dirloader_busy(&pf->loader) || strcmp(pf->loader.path, path) != 0)
+    return 0;
+  if (entry_store_copy(items, &pf->items) != 0)
+    return 0;
+
+  dirloader_cancel(loader);
+  DirLoader idle = *loader;
+  *loader        = pf->loader;
+  pf->loader     = idle;
+  entry_store_clear(&pf->items);
+  pf->adopted++;
+  return 1;
+}
+
+void dirprefetch_log_stats(const DirPrefetch* pf)
+{
+  log_message(LOG_LEVEL_DEBUG,
+              " [PREFETCH] started: %lu, cached: %lu, adopted: %lu, cancelled: %lu, "
+              "skipped (remote): %lu",
+              pf->started, pf->cached, pf->adopted, pf->cancelled, pf->skipped_remote);
+}
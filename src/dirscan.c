@@ -0,0 +1,141 @@
+// // // // // //
+//             //
+//   LITE FM   //
+//             //
+// // // // // //
+
+/* BY nots1dd */
+
+#define _GNU_SOURCE
+
+#include "../include/dirscan.h"
+#include "../include/logging.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/*
+ * glibc only wraps getdents64 from 2.30 onwards, so we talk to the
+ * syscall ourselves and lay out the record as the kernel writes it.
+ */
+struct linux_dirent64
+{
+  uint64_t       d_ino;
+  int64_t        d_off;
+  unsigned short d_reclen;
+  unsigned char  d_type;
+  char           d_name[];
+};
+
+unsigned char dirscan_mode_to_dtype(unsigned int st_mode)
+{
+  switch (st_mode & S_IFMT)
+  {
+    case S_IFDIR:
+      return DT_DIR;
+    case S_IFLNK:
+      return DT_LNK;
+    case S_IFREG:
+      return DT_REG;
+    case S_IFIFO:
+      return DT_FIFO;
+    case S_IFCHR:
+      return DT_CHR;
+    case S_IFBLK:
+      return DT_BLK;
+    case S_IFSOCK:
+      return DT_SOCK;
+    default:
+      return DT_UNKNOWN;
+  }
+}
+
+/*
+ * @DIRSCAN
+ *
+ * Reads `dir_fd` front to back exactly once. The fd is NOT closed and its
+ * offset is left at the end of the directory.
+ *
+ * Returns the number of entries handed to `fn`, or -1 on error.
+ */
+int dirscan_fd(int dir_fd, int show_hidden, DirScanFn fn, void* data)
+{
+  char* buf = malloc(DIRSCAN_BUFFER_SIZE);
+  if (buf == NULL)
+  {
+    log_message(LOG_LEVEL_ERROR, " [DIRSCAN] Unable to allocate getdents buffer");
+    return -1;
+  }
+
+  int  count   = 0;
+  int  stopped = 0;
+
+  while (!stopped)
+  {
+    long nread = syscall(SYS_getdents64, dir_fd, buf, DIRSCAN_BUFFER_SIZE);
+    if (nread == -1)
+    {
+      if (errno == EINTR)
+        continue;
+      log_message(LOG_LEVEL_ERROR, " [DIRSCAN] getdents64 failed: %s", strerror(errno));
+      free(buf);
+      return -1;
+    }
+    if (nread == 0)
+      break; // End of directory
+
+    for (long pos = 0; pos < nread;)
+    {
+      struct linux_dirent64* d = (struct linux_dirent64*)(buf + pos);
+      pos += d->d_reclen;
+
+      const char* name = d->d_name;
+      // Skip `.` and `..`, and dot-entries unless show_hidden is set
+      if (name[0] == '.')
+      {
+        if (name[1] == '\0' || (name[1] == '.' && name[2] == '\0') || !show_hidden)
+          continue;
+      }
+
+      unsigned char type = d->d_type;
+      if (type == DT_UNKNOWN)
+      {
+        // Some filesystems (older xfs, reiserfs, some FUSE) do not fill d_type
+        struct stat st;
+        if (fstatat(dir_fd, name, &st, AT_SYMLINK_NOFOLLOW) == 0)
+        {
+          type = dirscan_mode_to_dtype(st.st_mode);
+        }
+      }
+
+      count++;
+      if (fn(data, name, strlen(name), type) != 0)
+      {
+        stopped = 1;
+        break;
+      }
+    }
+  }
+
+  free(buf);
+  return count;
+}
+
+int dirscan_path(const char* path, int show_hidden, DirScanFn fn, void* data)
+{
+  int dir_fd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (dir_fd == -1)
+  {
+    return -1;
+  }
+
+  int count = dirscan_fd(dir_fd, show_hidden, fn, data);
+  close(dir_fd);
+  return count;
+}
@@ -0,0 +1,143 @@
+// // // // // //
+//             //
+//   LITE FM   //
+//             //
+// // // // // //
+
+/* BY nots1dd */
+
+#define _GNU_SOURCE
+
+#include "../include/entrymeta.h"
+#include "../include/logging.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <string.h>
+#include <unistd.h>
+
+#define ENTRY_META_STATX_MASK                                                         \
+  (STATX_TYPE | STATX_MODE | STATX_INO | STATX_UID | STATX_GID | STATX_SIZE | STATX_MTIME)
+
+static int entry_meta_stat(int dir_fd, const char* name, EntryMeta* meta)
+{
+  static int have_statx = 1;
+
+  memset(meta, 0, sizeof(*meta));
+  if (have_statx)
+  {
+    struct statx stx;
+    if (statx(dir_fd, name, AT_SYMLINK_NOFOLLOW | AT_STATX_DONT_SYNC, ENTRY_META_STATX_MASK,
+              &stx) == 0)
+    {
+      meta->size  = stx.stx_size;
+      meta->ino   = stx.stx_ino;
+      meta->mtime = stx.stx_mtime.tv_sec;
+      meta->mode  = stx.stx_mode;
+      meta->uid   = stx.stx_uid;
+      meta->gid   = stx.stx_gid;
+      meta->valid = 1;
+      return 0;
+    }
+    if (errno != ENOSYS)
+      return -1;
+    have_statx = 0; // Kernel older than 4.11
+  }
+
+  struct stat st;
+  if (fstatat(dir_fd, name, &st, AT_SYMLINK_NOFOLLOW) == -1)
+    return -1;
+  meta->size  = (uint64_t)st.st_size;
+  meta->ino   = st.st_ino;
+  meta->mtime = st.st_mtime;
+  meta->mode  = st.st_mode;
+  meta->uid   = st.st_uid;
+  meta->gid   = st.st_gid;
+  meta->valid = 1;
+  return 0;
+}
+
+/* Reads the target of symlink record `record` into the store */
+static void entry_meta_read_link(EntryStore* store, int dir_fd, size_t record)
+{
+  char        target[PATH_MAX];
+  const char* name = store->arena + store->records[record].name_off;
+  ssize_t     len  = readlinkat(dir_fd, name, target, sizeof(target) - 1);
+  if (len == -1)
+  {
+    log_message(LOG_LEVEL_DEBUG, " [ENTRYMETA] readlink %s: %s", name, strerror(errno));
+    entry_store_set_link(store, record, NULL, 0);
+    return;
+  }
+  entry_store_set_link(store, record, target, (size_t)len);
+}
+
+/* Returns 1 if the record had to be stat'ed */
+static int entry_meta_fetch_record(EntryStore* store, int dir_fd, size_t record)
+{
+  const EntryRecord* rec = &store->records[record];
+  if (rec->type == ENTRY_SYMLINK && !(rec->flags & ENTRY_LINK_READ))
+    entry_meta_read_link(store, dir_fd, record);
+
+  if (entry_store_record_meta(store, record) != NULL)
+    return 0;
+
+  EntryMeta   meta;
+  const char* name = store->arena + store->records[record].name_off;
+  if (entry_meta_stat(dir_fd, name, &meta) == -1)
+    log_message(LOG_LEVEL_DEBUG, " [ENTRYMETA] statx %s: %s", name, strerror(errno));
+  // Failures are remembered too (valid = 0), no point in retrying on every redraw
+  entry_store_set_meta(store, record, &meta);
+  return 1;
+}
+
+/*
+ * @ENTRY_META_FETCH
+ *
+ * Makes sure rows [first, last] (clamped to the view) have metadata, and
+ * symlinks among them their target. Entries that already have it are
+ * skipped, so calling this on every redraw only costs syscalls for rows that
+ * just scrolled into range.
+ *
+ * `dir_fd` is the listed directory (see navctx.h), -1 to only use what is
+ * already there.
+ *
+ * Reading a target appends to the store's arena, names fetched before this
+ * call may have moved.
+ *
+ * Returns the number of entries that had to be stat'ed.
+ */
+int entry_meta_fetch(EntryStore* store, int dir_fd, int first, int last)
+{
+  if (first < 0)
+    first = 0;
+  if (last >= entry_store_rows(store))
+    last = entry_store_rows(store) - 1;
+
+  int fetched = 0;
+  for (int row = first; row <= last && dir_fd != -1; row++)
+    fetched += entry_meta_fetch_record(store, dir_fd, entry_store_record(store, row));
+  return fetched;
+}
+
+/* Same for every record of the listing, the ones filtered out of the view too (for sorting) */
+int entry_meta_fetch_all(EntryStore* store, int dir_fd)
+{
+  int fetched = 0;
+  for (size_t i = 0; i < store->count && dir_fd != -1; i++)
+    fetched += entry_meta_fetch_record(store, dir_fd, i);
+  return fetched;
+}
+
+/* For code that still wants a `struct stat` (print_permissions, ...) */
+void entry_meta_to_stat(const EntryMeta* meta, struct stat* st)
+{
+  memset(st, 0, sizeof(*st));
+  st->st_size  = (off_t)meta->size;
+  st->st_ino   = (ino_t)meta->ino;
+  st->st_mtime = (time_t)meta->mtime;
+  st->st_mode  = (mode_t)meta->mode;
+  st->st_uid   = (uid_t)meta->uid;
+  st->st_gid   = (gid_t)meta->gid;
+}
@@ -0,0 +1,121 @@
+// // // // // //
+//             //
+//   LITE FM   //
+//             //
+// // // // // //
+
+/* BY nots1dd */
+
+#define _GNU_SOURCE
+
+#include "../include/entrymime.h"
+#include "../include/entrymeta.h"
+#include "../include/mimetype.h"
+
+#include <string.h>
+
+/*
+ * @ENTRY_MIME_KEEP
+ *
+ * Keeps `type` as the MIME type of `record`, which has to have metadata
+ * already, and lets it pick the icon of a regular file. "Error" (`file`
+ * could not be run) is not the file's type and is not kept, it is asked
+ * for again next time. Returns 0, or -1 if nothing was kept.
+ */
+int entry_mime_keep(EntryStore* store, size_t record, const char* type)
+{
+  uint16_t id = strcmp(type, "Error") != 0 ? mimetype_intern(type) : 0;
+  if (id == 0)
+    return -1;
+  return entry_store_set_mime(store, record, id, entry_kind_of_mime(type));
+}
+
+/* Classifies `count` records in one go and keeps what came out */
+static int entry_mime_classify_records(EntryStore* store, int dir_fd, const size_t* records,
+                                       size_t count)
+{
+  const char* names[MIMETYPE_BATCH] = {NULL};
+  const char* types[MIMETYPE_BATCH];
+  for (size_t i = 0; i < count; i++)
+    names[i] = store->arena + store->records[records[i]].name_off;
+  mimetype_classify_at(dir_fd, names, count, types);
+
+  int classified = 0;
+  for (size_t i = 0; i < count; i++)
+  {
+    if (entry_mime_keep(store, records[i], types[i]) == 0)
+      classified++;
+  }
+  return classified;
+}
+
+/*
+ * @ENTRY_MIME_CLASSIFY
+ *
+ * Works out the MIME type of every row in [first, last] (clamped to the
+ * view) that has none yet. They are asked for together, so whatever has to
+ * go to the `file` coprocess costs one round trip per MIMETYPE_BATCH rows
+ * (see mimetype.h). Fetches the rows' metadata first, the type is kept with
+ * it.
+ *
+ * Returns the number of rows that got a type.
+ */
+int entry_mime_classify(EntryStore* store, int dir_fd, int first, int last)
+{
+  if (dir_fd == -1)
+    return 0;
+  if (first < 0)
+    first = 0;
+  if (last >= entry_store_rows(store))
+    last = entry_store_rows(store) - 1;
+  entry_meta_fetch(store, dir_fd, first, last); // Reads link targets, names do not move after
+
+  size_t records[MIMETYPE_BATCH];
+  size_t count      = 0;
+  int    classified = 0;
+  for (int row = first; row <= last; row++)
+  {
+    size_t           record = entry_store_record(store, row);
+    const EntryMeta* meta   = entry_store_record_meta(store, record);
+    if (meta == NULL || meta->mime != 0)
+      continue;
+    records[count++] = record;
+    if (count == MIMETYPE_BATCH)
+    {
+      classified += entry_mime_classify_records(store, dir_fd, records, count);
+      count = 0;
+    }
+  }
+  if (count > 0)
+    classified += entry_mime_classify_records(store, dir_fd, records, count);
+  return classified;
+}
+
+/*
+ * @ENTRY_MIME
+ *
+ * MIME type of `row` (see mimetype.h), worked out the first time it is
+ * asked for and kept with the row's metadata after that. The string stays
+ * valid for the whole session. `dir_fd` is the listed directory, -1 to
+ * only use what is already there ("Unknown" if nothing is).
+ */
+const char* entry_mime(EntryStore* store, int dir_fd, int row)
+{
+  if (row < 0 || row >= entry_store_rows(store))
+    return "Unknown";
+
+  entry_mime_classify(store, dir_fd, row, row);
+  const EntryMeta* meta = entry_store_meta(store, row);
+  if (meta != NULL && meta->mime != 0)
+    return mimetype_name(meta->mime);
+
+  // Could not be kept (no metadata slot, `file` did not run...), ask without keeping it
+  return dir_fd != -1 ? mimetype_at(dir_fd, entry_store_name(store, row)) : "Unknown";
+}
+
+/* MIME type of `row` if it is already known, NULL if not. Never classifies anything. */
+const char* entry_mime_known(const EntryStore* store, int row)
+{
+  const EntryMeta* meta = entry_store_meta(store, row);
+  return meta != NULL && meta->mime != 0 ? mimetype_name(meta->mime) : NULL;
+}
@@ -0,0 +1,400 @@
+// // // // // //
+//             //
+//   LITE FM   //
+//             //
+// // // // // //
+
+/* BY nots1dd */
+
+#define _GNU_SOURCE
+
+#include "../include/entrysort.h"
+#include "../include/entrymeta.h"
+#include "../include/logging.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct
+{
+  uint64_t key;     /* integer key, or the first 8 key bytes for string modes */
+  uint32_t pos;     /* position of the record before sorting */
+  uint32_t str_off; /* key string in the sort's string buffer (string modes only) */
+} SortItem;
+
+static const char* sort_mode_labels[SORT_MODE_COUNT] = {
+  "dir order", "name", "natural", "size", "mtime", "extension",
+};
+
+/* Key strings and direction of the sort in progress, qsort comparators have no context */
+static const char* sort_strings;
+static int         sort_reverse;
+
+const char* entry_sort_label(SortMode mode)
+{
+  if (mode < 0 || mode >= SORT_MODE_COUNT)
+    return "?";
+  return sort_mode_labels[mode];
+}
+
+/* Whether `mode` sorts by metadata, i.e. has to stat every entry */
+int entry_sort_needs_meta(SortMode mode)
+{
+  return mode == SORT_SIZE || mode == SORT_MTIME;
+}
+
+static int cmp_pos(const SortItem* x, const SortItem* y)
+{
+  return (x->pos > y->pos) - (x->pos < y->pos);
+}
+
+/* Key comparison `c` in the sort's direction, equal keys keep listing order either way */
+static int cmp_directed(int c, const SortItem* x, const SortItem* y)
+{
+  if (c == 0)
+    return cmp_pos(x, y);
+  return (c > 0) == !sort_reverse ? 1 : -1;
+}
+
+static int cmp_string_items(const void* a, const void* b)
+{
+  const SortItem* x = (const SortItem*)a;
+  const SortItem* y = (const SortItem*)b;
+  if (x->key != y->key)
+    return cmp_directed(x->key < y->key ? -1 : 1, x, y);
+
+  // Same 8 byte prefix: if it had no NUL in it both strings go on, skip it
+  size_t skip = (x->key & 0xff) ? 8 : 0;
+  int    c    = strcmp(sort_strings + x->str_off + skip, sort_strings + y->str_off + skip);
+  return cmp_directed(c, x, y);
+}
+
+static int cmp_natural_items(const void* a, const void* b)
+{
+  const SortItem* x = (const SortItem*)a;
+  const SortItem* y = (const SortItem*)b;
+  int             c = strverscmp(sort_strings + x->str_off, sort_strings + y->str_off);
+  return cmp_directed(c, x, y);
+}
+
+/* First 8 bytes of `s`, big endian, so integer order == strcmp order */
+static uint64_t pack_prefix(const char* s)
+{
+  uint64_t key = 0;
+  int      end = 0;
+  for (int i = 0; i < 8; i++)
+  {
+    key <<= 8;
+    if (!end)
+    {
+      unsigned char c = (unsigned char)s[i];
+      if (c == '\0')
+        end = 1;
+      else
+        key |= c;
+    }
+  }
+  return key;
+}
+
+/* ASCII only on purpose: keys stay byte comparable and do not depend on the locale */
+static char* fold_copy(char* dst, const char* src, size_t len)
+{
+  for (size_t i = 0; i < len; i++)
+  {
+    unsigned char c = (unsigned char)src[i];
+    *dst++          = (c >= 'A' && c <= 'Z') ? (char)(c + ('a' - 'A')) : (char)c;
+  }
+  return dst;
+}
+
+#define RADIX_BITS    11
+#define RADIX_BUCKETS (1 << RADIX_BITS)
+
+static int bits_for(uint64_t value)
+{
+  int bits = 0;
+  while (value)
+  {
+    bits++;
+    value >>= 1;
+  }
+  return bits;
+}
+
+/*
+ * Stable LSD radix sort on `key`, 8 bits per pass over the full 16 byte
+ * items. Only used when the packed variant below does not fit.
+ */
+static int radix_sort_wide(SortItem* items, size_t n)
+{
+  SortItem* tmp = malloc(n * sizeof(SortItem));
+  if (tmp == NULL)
+    return -1;
+
+  SortItem* src = items;
+  SortItem* dst = tmp;
+  for (int shift = 0; shift < 64; shift += 8)
+  {
+    size_t count[256] = {0};
+    for (size_t i = 0; i < n; i++)
+      count[(src[i].key >> shift) & 0xff]++;
+
+    // Every key has the same byte here, this pass would not move anything
+    if (count[(src[0].key >> shift) & 0xff] == n)
+      continue;
+
+    size_t offset = 0;
+    for (int b = 0; b < 256; b++)
+    {
+      size_t c = count[b];
+      count[b] = offset;
+      offset += c;
+    }
+    for (size_t i = 0; i < n; i++)
+      dst[count[(src[i].key >> shift) & 0xff]++] = src[i];
+
+    SortItem* swap = src;
+    src            = dst;
+    dst            = swap;
+  }
+
+  if (src != items)
+    memcpy(items, src, n * sizeof(SortItem));
+  free(tmp);
+  return 0;
+}
+
+/*
+ * Stable radix sort of items by `key`. Returns -1 if out of memory.
+ *
+ * Keys are rebased on the smallest one and packed together with the item's
+ * index into one 64 bit word ((key - min) << index_bits | index), so the
+ * passes move 8 bytes per item instead of 16, and only cover the bits in
+ * which the keys actually differ (11 bits per pass). Equal keys keep their
+ * order because the passes are stable.
+ */
+static int radix_sort(SortItem* items, size_t n)
+{
+  uint64_t min = UINT64_MAX, max = 0;
+  for (size_t i = 0; i < n; i++)
+  {
+    if (items[i].key < min)
+      min = items[i].key;
+    if (items[i].key > max)
+      max = items[i].key;
+  }
+
+  int index_bits = bits_for(n - 1);
+  int key_bits   = bits_for(max - min);
+  if (key_bits == 0)
+    return 0; // All keys equal, already in (stable) order
+  if (key_bits + index_bits > 64)
+    return radix_sort_wide(items, n);
+
+  int       passes = (key_bits + RADIX_BITS - 1) / RADIX_BITS;
+  uint64_t* src    = malloc(n * sizeof(uint64_t));
+  uint64_t* dst    = malloc(n * sizeof(uint64_t));
+  size_t(*count)[RADIX_BUCKETS] = calloc((size_t)passes, sizeof(*count));
+  if (src == NULL || dst == NULL || count == NULL)
+  {
+    free(src);
+    free(dst);
+    free(count);
+    return -1;
+  }
+
+  // One read of the input builds the histograms of every pass
+  for (size_t i = 0; i < n; i++)
+  {
+    uint64_t packed = ((items[i].key - min) << index_bits) | i;
+    src[i]          = packed;
+    for (int p = 0; p < passes; p++)
+      count[p][(packed >> (index_bits + p * RADIX_BITS)) & (RADIX_BUCKETS - 1)]++;
+  }
+
+  for (int p = 0; p < passes; p++)
+  {
+    int shift = index_bits + p * RADIX_BITS;
+    if (count[p][(src[0] >> shift) & (RADIX_BUCKETS - 1)] == n)
+      continue;
+
+    size_t offset = 0;
+    for (int b = 0; b < RADIX_BUCKETS; b++)
+    {
+      size_t c    = count[p][b];
+      count[p][b] = offset;
+      offset += c;
+    }
+    for (size_t i = 0; i < n; i++)
+      dst[count[p][(src[i] >> shift) & (RADIX_BUCKETS - 1)]++] = src[i];
+
+    uint64_t* swap = src;
+    src            = dst;
+    dst            = swap;
+  }
+
+  // Only the positions are needed from here on
+  uint64_t index_mask = index_bits ? (~0ULL >> (64 - index_bits)) : 0;
+  for (size_t i = 0; i < n; i++)
+    dst[i] = items[src[i] & index_mask].pos;
+  for (size_t i = 0; i < n; i++)
+    items[i].pos = (uint32_t)dst[i];
+
+  free(src);
+  free(dst);
+  free(count);
+  return 0;
+}
+
+static int build_string_keys(const EntryStore* store, SortItem* items, size_t lo, size_t hi,
+                             SortMode mode, char** strings)
+{
+  // Keys are the name + NUL, extension keys also carry the extension and a separator
+  size_t bytes = 0;
+  for (size_t pos = lo; pos < hi; pos++)
+  {
+    size_t len = store->records[pos].name_len;
+    bytes += (mode == SORT_EXTENSION ? 2 * len + 1 : len) + 1;
+  }
+
+  char* buf = malloc(bytes ? bytes : 1);
+  if (buf == NULL)
+    return -1;
+
+  char* out = buf;
+  for (size_t pos = lo; pos < hi; pos++)
+  {
+    const char* name = store->arena + store->records[pos].name_off;
+    SortItem*   item = &items[pos - lo];
+    item->str_off    = (uint32_t)(out - buf);
+
+    if (mode == SORT_EXTENSION)
+    {
+      // "<ext>\x01<name>": no extension sorts first, then by extension, then by name
+      size_t      len = store->records[pos].name_len;
+      const char* dot = NULL;
+      for (size_t i = len; i > 1; i--)
+      {
+        if (name[i - 1] == '.')
+        {
+          dot = name + i - 1;
+          break;
+        }
+      }
+      if (dot)
+        out = fold_copy(out, dot + 1, len - (size_t)(dot + 1 - name));
+      *out++ = '\x01';
+      out    = fold_copy(out, name, store->records[pos].name_len);
+    }
+    else
+    {
+      out = fold_copy(out, name, store->records[pos].name_len);
+    }
+    *out++ = '\0';
+
+    item->key = mode == SORT_NATURAL ? 0 : pack_prefix(buf + item->str_off);
+  }
+
+  *strings = buf;
+  return 0;
+}
+
+/* Sorts records [lo, hi) into items[0, hi - lo). Returns -1 if out of memory. */
+static int sort_range(const EntryStore* store, SortItem* items, size_t lo, size_t hi,
+                      SortMode mode, int reverse)
+{
+  size_t n = hi - lo;
+  if (n == 0)
+    return 0;
+
+  for (size_t pos = lo; pos < hi; pos++)
+  {
+    SortItem* item = &items[pos - lo];
+    item->pos      = (uint32_t)pos;
+    item->str_off  = 0;
+    item->key      = 0;
+
+    const EntryMeta* meta = entry_store_record_meta(store, pos);
+    if (mode == SORT_DIR_ORDER)
+      item->key = store->records[pos].name_off;
+    else if (mode == SORT_SIZE && meta && meta->valid)
+      item->key = meta->size;
+    else if (mode == SORT_MTIME && meta && meta->valid)
+      item->key = (uint64_t)meta->mtime ^ (1ULL << 63); // signed -> unsigned order
+    else
+      continue; // No metadata: key 0, at the top in both directions
+
+    // Descending is ascending on the complement, the radix sort stays stable
+    if (reverse)
+      item->key = ~item->key;
+  }
+
+  if (mode == SORT_DIR_ORDER || mode == SORT_SIZE || mode == SORT_MTIME)
+  {
+    if (radix_sort(items, n) != 0)
+      return -1;
+  }
+  else
+  {
+    char* strings;
+    if (build_string_keys(store, items, lo, hi, mode, &strings) != 0)
+      return -1;
+    sort_strings = strings;
+    sort_reverse = reverse;
+    qsort(items, n, sizeof(SortItem), mode == SORT_NATURAL ? cmp_natural_items : cmp_string_items);
+    sort_strings = NULL;
+    free(strings);
+  }
+  return 0;
+}
+
+/*
+ * @ENTRY_SORT
+ *
+ * Sorts the dirs and the files of `store` separately by `mode`. `dir_fd` is
+ * only needed by the modes that have to stat every entry (-1 if the
+ * metadata is already there).
+ *
+ * If `highlight` is given it is moved along with the entry it pointed at.
+ * Returns 0, or -1 if we ran out of memory (the order is then unchanged).
+ */
+int entry_sort(EntryStore* store, int dir_fd, SortMode mode, int reverse, int* highlight)
+{
+  size_t count = store->count;
+  if (count < 2)
+    return 0;
+
+  if (entry_sort_needs_meta(mode))
+    entry_meta_fetch_all(store, dir_fd);
+
+  SortItem*    items  = malloc(count * sizeof(SortItem));
+  EntryRecord* sorted = malloc(count * sizeof(EntryRecord));
+  if (items == NULL || sorted == NULL ||
+      sort_range(store, items, 0, store->dir_count, mode, reverse) != 0 ||
+      sort_range(store, items + store->dir_count, store->dir_count, count, mode, reverse) != 0)
+  {
+    log_message(LOG_LEVEL_ERROR, " [SORT] Out of memory sorting %zu entries", count);
+    free(items);
+    free(sorted);
+    return -1;
+  }
+
+  // Hidden entries are sorted too, so showing them again needs no sort
+  size_t highlighted = highlight ? entry_store_record(store, *highlight) : count;
+  size_t moved_to    = count;
+  for (size_t i = 0; i < count; i++)
+  {
+    sorted[i] = store->records[items[i].pos];
+    if (items[i].pos == highlighted)
+      moved_to = i;
+  }
+  memcpy(store->records, sorted, count * sizeof(EntryRecord));
+  entry_store_update_view(store);
+  if (highlight && moved_to < count)
+    *highlight = entry_store_row(store, moved_to);
+
+  free(sorted);
+  free(items);
+  return 0;
+}
@@ -0,0 +1,604 @@
+// // // // // //
+//             //
+//   LITE FM   //
+//             //
+// // // // // //
+
+/* BY nots1dd */
+
+#define _GNU_SOURCE
+
+#include "../include/entrystore.h"
+#include "../include/dirscan.h"
+#include "../include/exttable.h"
+#include "../include/logging.h"
+
+#include <dirent.h>
+#include <stdlib.h>
+#include <string.h>
+
+void entry_store_init(EntryStore* store) { memset(store, 0, sizeof(*store)); }
+
+void entry_store_free(EntryStore* store)
+{
+  free(store->records);
+  free(store->arena);
+  free(store->meta);
+  free(store->rows);
+  entry_store_init(store);
+}
+
+/* Keeps both allocations around so that re-listing does not hit malloc */
+void entry_store_clear(EntryStore* store)
+{
+  store->count      = 0;
+  store->dir_count  = 0;
+  store->arena_len  = 0;
+  store->meta_count = 0;
+  store->row_count  = 0;
+}
+
+static int entry_store_reserve(EntryStore* store, size_t records, size_t name_bytes)
+{
+  if (store->count + records > store->capacity)
+  {
+    size_t new_cap = store->capacity ? store->capacity * 2 : ENTRY_STORE_INITIAL_RECORDS;
+    while (new_cap < store->count + records)
+      new_cap *= 2;
+    EntryRecord* grown = realloc(store->records, new_cap * sizeof(EntryRecord));
+    if (grown == NULL)
+      return -1;
+    store->records  = grown;
+    store->capacity = new_cap;
+  }
+
+  if (store->arena_len + name_bytes > store->arena_cap)
+  {
+    size_t new_cap = store->arena_cap ? store->arena_cap * 2 : ENTRY_STORE_INITIAL_ARENA;
+    while (new_cap < store->arena_len + name_bytes)
+      new_cap *= 2;
+    if (new_cap > UINT32_MAX)
+      return -1; // name offsets are 32 bit
+    char* grown = realloc(store->arena, new_cap);
+    if (grown == NULL)
+      return -1;
+    store->arena     = grown;
+    store->arena_cap = new_cap;
+  }
+
+  return 0;
+}
+
+static int entry_store_reserve_rows(EntryStore* store, size_t rows)
+{
+  if (rows <= store->row_cap)
+    return 0;
+
+  size_t new_cap = store->row_cap ? store->row_cap * 2 : ENTRY_STORE_INITIAL_RECORDS;
+  while (new_cap < rows)
+    new_cap *= 2;
+  uint32_t* grown = realloc(store->rows, new_cap * sizeof(uint32_t));
+  if (grown == NULL)
+    return -1;
+  store->rows    = grown;
+  store->row_cap = new_cap;
+  return 0;
+}
+
+/* Returns the record index of the new entry, or -1 if we ran out of memory */
+int entry_store_push(EntryStore* store, const char* name, size_t name_len, EntryType type)
+{
+  if (entry_store_reserve(store, 1, name_len + 1) != 0 ||
+      (store->filter && entry_store_reserve_rows(store, store->row_count + 1) != 0))
+  {
+    log_message(LOG_LEVEL_ERROR, " [ENTRYSTORE] Out of memory at %zu entries", store->count);
+    return -1;
+  }
+
+  EntryRecord* rec = &store->records[store->count];
+  rec->name_off    = (uint32_t)store->arena_len;
+  rec->name_len    = (uint32_t)name_len;
+  rec->meta        = 0;
+  rec->link_off    = 0;
+  rec->link_len    = 0;
+  rec->type        = (uint8_t)type;
+  rec->flags       = name_len > 0 && name[0] == '.' ? ENTRY_HIDDEN : 0;
+  rec->label_len   = 0;
+
+  memcpy(store->arena + store->arena_len, name, name_len);
+  store->arena[store->arena_len + name_len] = '\0';
+  rec->kind = (uint8_t)entry_kind_of(store->arena + store->arena_len, type);
+  store->arena_len += name_len + 1;
+
+  if (store->filter && !(rec->flags & store->filter))
+    store->rows[store->row_count++] = (uint32_t)store->count;
+
+  return (int)store->count++;
+}
+
+/* Number of rows in the view */
+int entry_store_rows(const EntryStore* store)
+{
+  return (int)(store->filter ? store->row_count : store->count);
+}
+
+/* The record shown at `row`, out of range rows map to `store->count` */
+size_t entry_store_record(const EntryStore* store, int row)
+{
+  if (row < 0 || row >= entry_store_rows(store))
+    return store->count;
+  return store->filter ? store->rows[row] : (size_t)row;
+}
+
+/*
+ * The row `record` is shown at. If it is filtered out, the row of the next
+ * record that is shown (the number of rows if there is none).
+ */
+int entry_store_row(const EntryStore* store, size_t record)
+{
+  if (!store->filter)
+    return (int)(record < store->count ? record : store->count);
+
+  // rows are in record order
+  size_t lo = 0, hi = store->row_count;
+  while (lo < hi)
+  {
+    size_t mid = lo + (hi - lo) / 2;
+    if (store->rows[mid] < record)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return (int)lo;
+}
+
+/* Out of range rows (empty dir, highlight of -1, ...) resolve to an empty name */
+const char* entry_store_name(const EntryStore* store, int row)
+{
+  size_t record = entry_store_record(store, row);
+  if (record >= store->count)
+    return "";
+  return store->arena + store->records[record].name_off;
+}
+
+int entry_store_is_dir(const EntryStore* store, int row)
+{
+  size_t record = entry_store_record(store, row);
+  if (record >= store->count)
+    return 0;
+  return store->records[record].type == ENTRY_DIR;
+}
+
+/* Directories and symlinks are listed before everything else */
+static int entry_in_dir_group(const EntryRecord* rec)
+{
+  return rec->type == ENTRY_DIR || rec->type == ENTRY_SYMLINK;
+}
+
+/*
+ * Appends `src` (in whatever order it was read) to `dst` while keeping `dst`
+ * grouped: dirs/symlinks of the batch are slotted in at the end of the dir
+ * group, the rest at the very end. Each group keeps its read order, so the
+ * result is the same whether a directory arrives in one batch or in many.
+ *
+ * Only the fixed size records are shifted; the batch's names are copied to
+ * the end of the arena in one go.
+ *
+ * Returns how many records were inserted in front of the existing
+ * non-directory entries (i.e. how far those moved), or -1 on failure.
+ */
+int entry_store_append_grouped(EntryStore* dst, const EntryStore* src)
+{
+  if (src->count == 0)
+    return 0;
+
+  if (entry_store_reserve(dst, src->count, src->arena_len) != 0)
+  {
+    log_message(LOG_LEVEL_ERROR, " [ENTRYSTORE] Out of memory at %zu entries", dst->count);
+    return -1;
+  }
+
+  size_t dirs = 0;
+  for (size_t i = 0; i < src->count; i++)
+  {
+    if (entry_in_dir_group(&src->records[i]))
+      dirs++;
+  }
+
+  // Make room for the new dirs between the existing dir and file groups
+  memmove(dst->records + dst->dir_count + dirs, dst->records + dst->dir_count,
+          (dst->count - dst->dir_count) * sizeof(EntryRecord));
+
+  uint32_t base     = (uint32_t)dst->arena_len;
+  size_t   dir_slot = dst->dir_count;
+  size_t   end_slot = dst->count + dirs;
+  for (size_t i = 0; i < src->count; i++)
+  {
+    EntryRecord rec = src->records[i];
+    rec.name_off += base;
+    rec.link_off += base;
+    rec.meta = 0; // slots belong to src's slab
+    if (src->label_cap != dst->label_cap)
+      rec.flags &= ~ENTRY_LABEL_FIT;
+    if (entry_in_dir_group(&rec))
+      dst->records[dir_slot++] = rec;
+    else
+      dst->records[end_slot++] = rec;
+  }
+
+  memcpy(dst->arena + dst->arena_len, src->arena, src->arena_len);
+  dst->arena_len += src->arena_len;
+  dst->dir_count += dirs;
+  dst->count += src->count;
+
+  // The new dirs went into the middle of the listing (shows everything if this fails)
+  entry_store_update_view(dst);
+  return (int)dirs;
+}
+
+/*
+ * Replaces the listing in `dst` with the one in `src`, without metadata.
+ * Returns 0, or -1 if we ran out of memory.
+ */
+int entry_store_copy(EntryStore* dst, const EntryStore* src)
+{
+  entry_store_clear(dst);
+  if (entry_store_reserve(dst, src->count, src->arena_len) != 0)
+  {
+    log_message(LOG_LEVEL_ERROR, " [ENTRYSTORE] Out of memory copying %zu entries", src->count);
+    return -1;
+  }
+
+  for (size_t i = 0; i < src->count; i++)
+  {
+    dst->records[i]      = src->records[i];
+    dst->records[i].meta = 0; // metadata is never copied, it may be stale by the time it is read
+  }
+  if (src->arena_len > 0)
+    memcpy(dst->arena, src->arena, src->arena_len);
+  dst->count     = src->count;
+  dst->dir_count = src->dir_count;
+  dst->arena_len = src->arena_len;
+  dst->label_cap = src->label_cap;
+  entry_store_update_view(dst);
+  return 0;
+}
+
+/* Bytes held by the store, used for cache accounting */
+size_t entry_store_footprint(const EntryStore* store)
+{
+  return store->capacity * sizeof(EntryRecord) + store->arena_cap +
+         store->meta_cap * sizeof(EntryMeta) + store->row_cap * sizeof(uint32_t);
+}
+
+/* NULL until the entry has been through entry_meta_fetch */
+const EntryMeta* entry_store_record_meta(const EntryStore* store, size_t record)
+{
+  if (record >= store->count || store->records[record].meta == 0)
+    return NULL;
+  return &store->meta[store->records[record].meta - 1];
+}
+
+const EntryMeta* entry_store_meta(const EntryStore* store, int row)
+{
+  return entry_store_record_meta(store, entry_store_record(store, row));
+}
+
+/* Returns 0, or -1 if we ran out of memory (the entry then just stays unfetched) */
+int entry_store_set_meta(EntryStore* store, size_t record, const EntryMeta* meta)
+{
+  if (record >= store->count)
+    return -1;
+
+  EntryRecord* rec = &store->records[record];
+  if (meta->valid)
+  {
+    // The scanner may not have known the type (DT_UNKNOWN) or the entry was replaced since
+    EntryType type = entry_type_from_dtype(dirscan_mode_to_dtype(meta->mode));
+    if (type != rec->type)
+      rec->kind = (uint8_t)entry_kind_of(store->arena + rec->name_off, type);
+  }
+
+  if (rec->meta != 0)
+  {
+    store->meta[rec->meta - 1] = *meta;
+    return 0;
+  }
+
+  if (store->meta_count == store->meta_cap)
+  {
+    size_t     new_cap = store->meta_cap ? store->meta_cap * 2 : 64;
+    EntryMeta* grown   = realloc(store->meta, new_cap * sizeof(EntryMeta));
+    if (grown == NULL)
+      return -1;
+    store->meta     = grown;
+    store->meta_cap = new_cap;
+  }
+
+  store->meta[store->meta_count++] = *meta;
+  rec->meta                        = (uint32_t)store->meta_count;
+  return 0;
+}
+
+/*
+ * Only for records that have metadata, the MIME type goes with it. `kind`
+ * (see entry_kind_of_mime) replaces the one picked by extension if the
+ * entry is a regular file. Returns 0 or -1.
+ */
+int entry_store_set_mime(EntryStore* store, size_t record, uint16_t mime, EntryKind kind)
+{
+  if (record >= store->count || store->records[record].meta == 0)
+    return -1;
+
+  EntryRecord* rec = &store->records[record];
+  store->meta[rec->meta - 1].mime = mime;
+  if (rec->type == ENTRY_FILE)
+  {
+    rec->kind = (uint8_t)kind;
+    rec->flags |= ENTRY_CLASSIFIED;
+  }
+  return 0;
+}
+
+/* The next entry_meta_fetch stats the entry again (e.g. after it was edited) */
+void entry_store_forget_meta(EntryStore* store, int row)
+{
+  size_t record = entry_store_record(store, row);
+  if (record < store->count)
+    store->records[record].meta = 0;
+}
+
+EntryType entry_type_from_dtype(unsigned char d_type)
+{
+  switch (d_type)
+  {
+    case DT_REG:
+      return ENTRY_FILE;
+    case DT_DIR:
+      return ENTRY_DIR;
+    case DT_LNK:
+      return ENTRY_SYMLINK;
+    case DT_FIFO:
+      return ENTRY_FIFO;
+    case DT_SOCK:
+      return ENTRY_SOCKET;
+    case DT_CHR:
+      return ENTRY_CHARDEV;
+    case DT_BLK:
+      return ENTRY_BLOCKDEV;
+    default:
+      return ENTRY_UNKNOWN;
+  }
+}
+
+/* Type of the entry, from its metadata when we have it, else from the scan */
+EntryType entry_store_type(const EntryStore* store, int row)
+{
+  size_t           record = entry_store_record(store, row);
+  const EntryMeta* meta   = entry_store_record_meta(store, record);
+  if (meta && meta->valid)
+    return entry_type_from_dtype(dirscan_mode_to_dtype(meta->mode));
+  if (record >= store->count)
+    return ENTRY_UNKNOWN;
+  return (EntryType)store->records[record].type;
+}
+
+static EntryKind entry_kind_of_category(ExtCategory category)
+{
+  switch (category)
+  {
+    case EXT_CATEGORY_ARCHIVE:
+      return ENTRY_KIND_ARCHIVE;
+    case EXT_CATEGORY_AUDIO:
+      return ENTRY_KIND_AUDIO;
+    case EXT_CATEGORY_IMAGE:
+      return ENTRY_KIND_IMAGE;
+    case EXT_CATEGORY_VIDEO:
+      return ENTRY_KIND_VIDEO;
+    default:
+      return ENTRY_KIND_FILE;
+  }
+}
+
+/* Icon and color of an entry, by type and then by extension (see exttable.def) */
+EntryKind entry_kind_of(const char* name, EntryType type)
+{
+  if (type == ENTRY_DIR)
+    return ENTRY_KIND_DIR;
+  if (type == ENTRY_SYMLINK)
+    return ENTRY_KIND_SYMLINK;
+
+  const ExtInfo* ext = ext_lookup(name);
+  return entry_kind_of_category(ext ? (ExtCategory)ext->category : EXT_CATEGORY_NONE);
+}
+
+/* Same, for a regular file whose MIME type is known (see mimetype.h) */
+EntryKind entry_kind_of_mime(const char* mime)
+{
+  return entry_kind_of_category(ext_category_for_mime(mime));
+}
+
+EntryKind entry_store_kind(const EntryStore* store, int row)
+{
+  size_t record = entry_store_record(store, row);
+  if (record >= store->count)
+    return ENTRY_KIND_FILE;
+
+  // The extension may lie, so it is not worth an icon while the real type is on its way
+  const EntryRecord* rec = &store->records[record];
+  if (store->mime_kinds && rec->type == ENTRY_FILE && !(rec->flags & ENTRY_CLASSIFIED))
+    return ENTRY_KIND_FILE;
+  return (EntryKind)rec->kind;
+}
+
+/*
+ * How many bytes of the label ("name", or "name -> target" once a symlink's
+ * target was read) are drawn in `cap` columns, and whether it gets an
+ * ellipsis. Never cuts into a UTF-8 sequence.
+ */
+static int entry_label_fit(const EntryStore* store, const EntryRecord* rec, int cap, int* cut)
+{
+  size_t name_len = rec->name_len;
+  size_t len      = name_len;
+  if (rec->flags & ENTRY_LINK_READ)
+    len += 4 + (rec->link_len ? rec->link_len : sizeof(ENTRY_UNKNOWN_TARGET) - 1);
+
+  *cut = 0;
+  if (cap < 6)
+    return 0;
+  if (len <= (size_t)cap - 3)
+    return (int)len;
+
+  *cut       = 1;
+  size_t fit = (size_t)cap - 6;
+  if (fit < name_len)
+  {
+    const char* name = store->arena + rec->name_off;
+    while (fit > 0 && (name[fit] & 0xC0) == 0x80)
+      fit--;
+  }
+  else if (rec->link_len && fit > name_len + 4)
+  {
+    const char* target = store->arena + rec->link_off;
+    while (fit > name_len + 4 && (target[fit - name_len - 4] & 0xC0) == 0x80)
+      fit--;
+  }
+  return (int)fit;
+}
+
+/*
+ * Label bytes of `row` that fit in `cap` columns, as fit by
+ * entry_store_fit_labels, worked out on the spot if the row was not.
+ */
+int entry_store_label_len(const EntryStore* store, int row, int cap, int* cut)
+{
+  size_t record = entry_store_record(store, row);
+  *cut          = 0;
+  if (record >= store->count)
+    return 0;
+
+  const EntryRecord* rec = &store->records[record];
+  if ((rec->flags & ENTRY_LABEL_FIT) && store->label_cap == cap)
+  {
+    *cut = (rec->flags & ENTRY_LABEL_CUT) != 0;
+    return rec->label_len;
+  }
+  return entry_label_fit(store, rec, cap, cut);
+}
+
+/*
+ * @ENTRY_STORE_FIT_LABELS
+ *
+ * Fits the labels of rows [from_row, to_row) to `cap` columns (at most 255)
+ * once, later draws just read them back. A different `cap` than last time
+ * (the terminal was resized) throws all fitted labels away.
+ */
+void entry_store_fit_labels(EntryStore* store, int cap, int from_row, int to_row)
+{
+  if (cap > UINT8_MAX)
+    cap = UINT8_MAX;
+  if (cap != store->label_cap)
+  {
+    for (size_t i = 0; i < store->count; i++)
+      store->records[i].flags &= ~ENTRY_LABEL_FIT;
+    store->label_cap = cap;
+  }
+
+  int rows = entry_store_rows(store);
+  if (from_row < 0)
+    from_row = 0;
+  if (to_row > rows)
+    to_row = rows;
+  for (int row = from_row; row < to_row; row++)
+  {
+    EntryRecord* rec = &store->records[entry_store_record(store, row)];
+    if (rec->flags & ENTRY_LABEL_FIT)
+      continue;
+    int cut        = 0;
+    rec->label_len = (uint8_t)entry_label_fit(store, rec, cap, &cut);
+    rec->flags     = (rec->flags | ENTRY_LABEL_FIT) & ~ENTRY_LABEL_CUT;
+    if (cut)
+      rec->flags |= ENTRY_LABEL_CUT;
+  }
+}
+
+/*
+ * Target of a symlink entry. NULL until it has been read (and for anything
+ * that is not a symlink), "" if it could not be read.
+ */
+const char* entry_store_link(const EntryStore* store, int row)
+{
+  size_t record = entry_store_record(store, row);
+  if (record >= store->count || !(store->records[record].flags & ENTRY_LINK_READ))
+    return NULL;
+  if (store->records[record].link_len == 0)
+    return "";
+  return store->arena + store->records[record].link_off;
+}
+
+/*
+ * Stores the target of a symlink entry in the arena, `target` is NULL if it
+ * could not be read. Like a push, this may move the arena.
+ *
+ * Returns 0, or -1 if we ran out of memory (the entry then just stays unread).
+ */
+int entry_store_set_link(EntryStore* store, size_t record, const char* target,
+                         size_t target_len)
+{
+  if (record >= store->count)
+    return -1;
+
+  EntryRecord* rec = &store->records[record];
+  rec->link_len    = 0;
+  if (target != NULL && target_len > 0)
+  {
+    if (entry_store_reserve(store, 0, target_len + 1) != 0)
+      return -1;
+    rec->link_off = (uint32_t)store->arena_len;
+    rec->link_len = (uint32_t)target_len;
+    memcpy(store->arena + store->arena_len, target, target_len);
+    store->arena[store->arena_len + target_len] = '\0';
+    store->arena_len += target_len + 1;
+  }
+  rec->flags = (rec->flags | ENTRY_LINK_READ) & ~ENTRY_LABEL_FIT; // the label grew
+  return 0;
+}
+
+/*
+ * @ENTRY_STORE_SET_FILTER
+ *
+ * Leaves records with any of the `filter` flags (ENTRY_HIDDEN, ...) out of
+ * the view, 0 shows everything. One pass over the records, no I/O.
+ *
+ * Returns 0, or -1 if we ran out of memory (the view then shows everything).
+ */
+int entry_store_set_filter(EntryStore* store, uint8_t filter)
+{
+  store->filter = filter & ENTRY_FILTERABLE;
+  return entry_store_update_view(store);
+}
+
+/*
+ * Rebuilds the view after records were added or reordered behind its back
+ * (entry_sort moves records around directly).
+ */
+int entry_store_update_view(EntryStore* store)
+{
+  store->row_count = 0;
+  if (!store->filter)
+    return 0;
+
+  if (entry_store_reserve_rows(store, store->count) != 0)
+  {
+    log_message(LOG_LEVEL_ERROR, " [ENTRYSTORE] Out of memory filtering %zu entries",
+                store->count);
+    store->filter = 0;
+    return -1;
+  }
+  for (size_t i = 0; i < store->count; i++)
+  {
+    if (!(store->records[i].flags & store->filter))
+      store->rows[store->row_count++] = (uint32_t)i;
+  }
+  return 0;
+}
@@ -0,0 +1,185 @@
+// // // // // //
+//             //
+//   LITE FM   //
+//             //
+// // // // // //
+
+/* BY nots1dd */
+
+#define _GNU_SOURCE
+
+#include "../include/eventloop.h"
+#include "../include/logging.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#define EVENTLOOP_MAX_EVENTS 8
+
+/* The mask from before eventloop_init, for children started with fork() */
+static sigset_t saved_mask;
+
+static void eventloop_atfork_child(void) { pthread_sigmask(SIG_SETMASK, &saved_mask, NULL); }
+
+static int eventloop_add(EventLoop* loop, int fd)
+{
+  struct epoll_event event;
+  memset(&event, 0, sizeof(event));
+  event.events  = EPOLLIN;
+  event.data.fd = fd;
+  return epoll_ctl(loop->epoll_fd, EPOLL_CTL_ADD, fd, &event);
+}
+
+static void drain_counter(int fd)
+{
+  uint64_t value;
+  while (read(fd, &value, sizeof(value)) == sizeof(value))
+    ;
+}
+
+/*
+ * @EVENTLOOP_INIT
+ *
+ * Has to be called on the UI thread before any other thread is started,
+ * threads inherit the blocked SIGWINCH/SIGCHLD from it.
+ *
+ * Returns 0, or -1 if there is no epoll. `eventloop_wait` then falls back to
+ * a short poll on stdin, the UI keeps working but no longer sleeps for good.
+ */
+int eventloop_init(EventLoop* loop, int status_ms)
+{
+  static int atfork_registered;
+
+  loop->epoll_fd  = -1;
+  loop->signal_fd = -1;
+  loop->wake_fd   = -1;
+  loop->timer_fd  = -1;
+  loop->watch_fd  = -1;
+
+  sigset_t mask;
+  sigemptyset(&mask);
+  sigaddset(&mask, SIGWINCH);
+  sigaddset(&mask, SIGCHLD);
+  pthread_sigmask(SIG_BLOCK, &mask, &saved_mask);
+  if (!atfork_registered && pthread_atfork(NULL, NULL, eventloop_atfork_child) == 0)
+    atfork_registered = 1;
+
+  loop->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  if (loop->epoll_fd == -1)
+  {
+    log_message(LOG_LEVEL_ERROR, " [EVENTLOOP] epoll unavailable (%s), polling stdin",
+                strerror(errno));
+    pthread_sigmask(SIG_SETMASK, &saved_mask, NULL);
+    return -1;
+  }
+  eventloop_add(loop, STDIN_FILENO);
+
+  loop->signal_fd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+  if (loop->signal_fd != -1)
+    eventloop_add(loop, loop->signal_fd);
+  else
+    log_message(LOG_LEVEL_WARN, " [EVENTLOOP] signalfd unavailable: %s", strerror(errno));
+
+  loop->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (loop->wake_fd != -1)
+    eventloop_add(loop, loop->wake_fd);
+  else
+    log_message(LOG_LEVEL_WARN, " [EVENTLOOP] eventfd unavailable: %s", strerror(errno));
+
+  loop->timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+  if (loop->timer_fd != -1)
+  {
+    struct itimerspec interval;
+    interval.it_interval.tv_sec  = status_ms / 1000;
+    interval.it_interval.tv_nsec = (long)(status_ms % 1000) * 1000000L;
+    interval.it_value            = interval.it_interval;
+    timerfd_settime(loop->timer_fd, 0, &interval, NULL);
+    eventloop_add(loop, loop->timer_fd);
+  }
+  return 0;
+}
+
+/* Only once every worker that was handed `wake_fd` has been cancelled */
+void eventloop_free(EventLoop* loop)
+{
+  int* fds[] = {&loop->epoll_fd, &loop->signal_fd, &loop->wake_fd, &loop->timer_fd};
+  for (size_t i = 0; i < sizeof(fds) / sizeof(fds[0]); i++)
+  {
+    if (*fds[i] != -1)
+      close(*fds[i]);
+    *fds[i] = -1;
+  }
+  loop->watch_fd = -1;
+  pthread_sigmask(SIG_SETMASK, &saved_mask, NULL);
+}
+
+/* Reports `fd` (an inotify fd, -1 is ignored) as EVENT_FS, reading it is up to the caller */
+void eventloop_watch(EventLoop* loop, int fd)
+{
+  if (fd == -1 || loop->epoll_fd == -1 || eventloop_add(loop, fd) == -1)
+    return;
+  loop->watch_fd = fd;
+}
+
+/*
+ * @EVENTLOOP_WAIT
+ *
+ * Sleeps until something is ready or `timeout_ms` passes (-1 waits for
+ * good) and returns the EVENT_* bits of what woke us, 0 on timeout. The
+ * signal, wake and timer fds are drained here, stdin and the watched fd are
+ * left for the caller.
+ */
+unsigned eventloop_wait(EventLoop* loop, int timeout_ms)
+{
+  if (loop->epoll_fd == -1)
+  {
+    struct pollfd in = {.fd = STDIN_FILENO, .events = POLLIN};
+    if (timeout_ms < 0 || timeout_ms > 50)
+      timeout_ms = 50;
+    return poll(&in, 1, timeout_ms) > 0 ? EVENT_KEY | EVENT_WAKE : EVENT_WAKE;
+  }
+
+  struct epoll_event events[EVENTLOOP_MAX_EVENTS];
+  int                n = epoll_wait(loop->epoll_fd, events, EVENTLOOP_MAX_EVENTS, timeout_ms);
+  if (n == -1)
+    return 0; // EINTR, e.g. SIGTSTP/SIGCONT
+
+  unsigned fired = 0;
+  for (int i = 0; i < n; i++)
+  {
+    int fd = events[i].data.fd;
+    if (fd == STDIN_FILENO)
+    {
+      fired |= EVENT_KEY;
+    }
+    else if (fd == loop->wake_fd)
+    {
+      drain_counter(fd);
+      fired |= EVENT_WAKE;
+    }
+    else if (fd == loop->timer_fd)
+    {
+      drain_counter(fd);
+      fired |= EVENT_TIMER;
+    }
+    else if (fd == loop->watch_fd)
+    {
+      fired |= EVENT_FS;
+    }
+    else if (fd == loop->signal_fd)
+    {
+      struct signalfd_siginfo info;
+      while (read(fd, &info, sizeof(info)) == sizeof(info))
+        fired |= info.ssi_signo == SIGWINCH ? EVENT_RESIZE : EVENT_CHILD;
+    }
+  }
+  return fired;
+}
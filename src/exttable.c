@@ -0,0 +1,87 @@
+// // // // // //
+//             //
+//   LITE FM   //
+//             //
+// // // // // //
+
+/* BY nots1dd */
+
+#define _GNU_SOURCE
+
+#include "../include/exttable.h"
+#include "exttable_gen.h" /* generated from exttable.def at build time, see tools/exttable_gen.c */
+
+#include <string.h>
+
+/* `ext` against a (lower case) table entry, ignoring ASCII case */
+static int ext_equal(const char* entry, const char* ext, size_t len)
+{
+  for (size_t i = 0; i < len; i++)
+  {
+    unsigned char c = (unsigned char)ext[i];
+    if (c >= 'A' && c <= 'Z')
+      c += 'a' - 'A';
+    if (c != (unsigned char)entry[i])
+      return 0;
+  }
+  return 1;
+}
+
+/* Table entry of extension `ext` (without the dot), NULL if it is not a known one */
+const ExtInfo* ext_lookup_ext(const char* ext, size_t len)
+{
+  if (len == 0 || len > EXT_MAX_LEN)
+    return NULL;
+
+  const ExtInfo* info = &ext_table[ext_hash(ext, len, EXT_TABLE_SEED) & (EXT_TABLE_SLOTS - 1)];
+  if (info->len != len || !ext_equal(info->ext, ext, len))
+    return NULL;
+  return info;
+}
+
+/* By the last extension of `filename`, NULL if it has none or an unknown one */
+const ExtInfo* ext_lookup(const char* filename)
+{
+  const char* dot = strrchr(filename, '.');
+  if (dot == NULL)
+    return NULL;
+  return ext_lookup_ext(dot + 1, strlen(dot + 1));
+}
+
+/*
+ * Syntax language for a MIME type as reported by `file`, for files whose
+ * extension does not tell (shell scripts without one...). NULL if none.
+ */
+const char* ext_syntax_for_mime(const char* mime)
+{
+  for (size_t i = 0; i < EXT_TABLE_SLOTS; i++)
+  {
+    const ExtInfo* info = &ext_table[i];
+    if (info->syntax != NULL && info->mime != NULL && strcmp(info->mime, mime) == 0)
+      return info->syntax;
+  }
+  return NULL;
+}
+
+/*
+ * Category of a MIME type as worked out from a file's content (see
+ * mimetype.h): audio, image and video by their top level type, archives by
+ * the types the table knows them by. EXT_CATEGORY_NONE for anything else.
+ */
+ExtCategory ext_category_for_mime(const char* mime)
+{
+  if (strncmp(mime, "audio/", 6) == 0)
+    return EXT_CATEGORY_AUDIO;
+  if (strncmp(mime, "image/", 6) == 0)
+    return EXT_CATEGORY_IMAGE;
+  if (strncmp(mime, "video/", 6) == 0)
+    return EXT_CATEGORY_VIDEO;
+  for (size_t i = 0; i < EXT_TABLE_SLOTS; i++)
+  {
+    const ExtInfo* info = &ext_table[i];
+    if (info->category == EXT_CATEGORY_ARCHIVE && info->mime != NULL &&
+        strcmp(info->mime, mime) == 0)
+      return EXT_CATEGORY_ARCHIVE;
+  }
+  return EXT_CATEGORY_NONE;
+}
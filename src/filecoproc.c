@@ -0,0 +1,243 @@
+// // // // // //
+//             //
+//   LITE FM   //
+//             //
+// // // // // //
+
+/* BY nots1dd */
+
+#define _GNU_SOURCE
+
+#include "../include/filecoproc.h"
+#include "../include/logging.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+void filecoproc_init(FileCoproc* coproc)
+{
+  memset(coproc, 0, sizeof(*coproc));
+  coproc->pid  = -1;
+  coproc->to   = -1;
+  coproc->from = -1;
+}
+
+void filecoproc_stop(FileCoproc* coproc)
+{
+  if (coproc->pid == -1)
+    return;
+  close(coproc->to);
+  close(coproc->from);
+  kill(coproc->pid, SIGKILL); // It may be stuck reading a file, do not wait for it to notice EOF
+  while (waitpid(coproc->pid, NULL, 0) == -1 && errno == EINTR)
+    ;
+  coproc->pid  = -1;
+  coproc->to   = -1;
+  coproc->from = -1;
+  coproc->len  = 0;
+}
+
+static int coproc_start(FileCoproc* coproc)
+{
+  int in[2], out[2];
+  if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, in) == -1)
+    return -1;
+  if (pipe2(out, O_CLOEXEC) == -1)
+  {
+    close(in[0]);
+    close(in[1]);
+    return -1;
+  }
+
+  pid_t pid = fork();
+  if (pid == -1)
+  {
+    close(in[0]);
+    close(in[1]);
+    close(out[0]);
+    close(out[1]);
+    return -1;
+  }
+  if (pid == 0)
+  {
+    int null_fd = open("/dev/null", O_WRONLY);
+    dup2(in[1], STDIN_FILENO);
+    dup2(out[1], STDOUT_FILENO);
+    if (null_fd != -1)
+      dup2(null_fd, STDERR_FILENO);
+    execlp("file", "file", "--brief", "--mime-type", "--dereference", "-n", "-f", "-",
+           (char*)NULL);
+    _exit(127);
+  }
+
+  close(in[1]);
+  close(out[1]);
+  coproc->pid  = pid;
+  coproc->to   = in[0];
+  coproc->from = out[0];
+  coproc->len  = 0;
+  coproc->starts++;
+  return 0;
+}
+
+static int send_all(FileCoproc* coproc, const char* data, size_t len)
+{
+  while (len > 0)
+  {
+    ssize_t n = send(coproc->to, data, len, MSG_NOSIGNAL);
+    if (n == -1 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return -1;
+    data += n;
+    len -= (size_t)n;
+  }
+  return 0;
+}
+
+/* RFC 6838 restricted-name characters, what both halves of a MIME type are made of */
+static int mime_name_char(char c)
+{
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+         (c != '\0' && strchr("!#$&^_.+-", c) != NULL);
+}
+
+/*
+ * @FILECOPROC_IS_MIME_TYPE
+ *
+ * Whether `answer` is a `type/subtype` token, what `file --mime-type` prints
+ * for a file it could read. Anything else is `file` telling us it could not
+ * ("cannot open `...' (...)"), never a type to show or to cache.
+ */
+int filecoproc_is_mime_type(const char* answer)
+{
+  const char* slash = strchr(answer, '/');
+  if (slash == NULL || slash == answer || slash[1] == '\0')
+    return 0;
+  for (const char* c = answer; *c != '\0'; c++)
+    if (c != slash && !mime_name_char(*c))
+      return 0;
+  return 1;
+}
+
+/* Hands out the next buffered answer line, 0 if there is no complete one yet */
+static int next_answer(FileCoproc* coproc, char* type)
+{
+  char* newline = memchr(coproc->buf, '\n', coproc->len);
+  if (newline == NULL)
+    return 0;
+  size_t line = (size_t)(newline - coproc->buf);
+  snprintf(type, FILECOPROC_ANSWER_MAX, "%.*s", (int)line, coproc->buf);
+  coproc->len -= line + 1;
+  memmove(coproc->buf, newline + 1, coproc->len);
+  return 1;
+}
+
+/* Waits for more answers. Returns -1 if the coprocess died or stopped answering. */
+static int read_answers(FileCoproc* coproc)
+{
+  if (coproc->len == sizeof(coproc->buf))
+    coproc->len = 0; // A line this long is no MIME type, drop it
+  struct pollfd from = {.fd = coproc->from, .events = POLLIN};
+  int           rc;
+  while ((rc = poll(&from, 1, FILECOPROC_TIMEOUT_MS)) == -1 && errno == EINTR)
+    ;
+  if (rc == 0)
+  {
+    log_message(LOG_LEVEL_WARN, " [FILECOPROC] `file` did not answer within %d ms, restarting it",
+                FILECOPROC_TIMEOUT_MS);
+    return -1;
+  }
+  ssize_t n;
+  while ((n = read(coproc->from, coproc->buf + coproc->len,
+                   sizeof(coproc->buf) - coproc->len)) == -1 &&
+         errno == EINTR)
+    ;
+  if (n <= 0)
+    return -1;
+  coproc->len += (size_t)n;
+  return 0;
+}
+
+/*
+ * @FILECOPROC_CLASSIFY
+ *
+ * MIME types of up to FILECOPROC_BATCH open files `fds` (read from the
+ * start, whatever their offset) into `types`, in one round trip. Returns
+ * how many leading entries of `types` were filled, less than `count` if the
+ * coprocess could not be started or died on the way. An entry is left empty
+ * when the answer was not a MIME type (`file` could not open the /proc path,
+ * hidepid...), the caller classifies those some other way.
+ */
+size_t filecoproc_classify(FileCoproc* coproc, const int* fds, size_t count,
+                           char (*types)[FILECOPROC_ANSWER_MAX])
+{
+  if (count > FILECOPROC_BATCH)
+    count = FILECOPROC_BATCH;
+  if (coproc->disabled || count == 0)
+    return 0;
+
+  size_t answered = 0;
+  if (coproc->pid != -1 || coproc_start(coproc) == 0)
+  {
+    char   request[FILECOPROC_BATCH * 40];
+    size_t len  = 0;
+    pid_t  self = getpid();
+    for (size_t i = 0; i < count; i++)
+      len += (size_t)snprintf(request + len, sizeof(request) - len, "/proc/%d/fd/%d\n", (int)self,
+                              fds[i]);
+
+    if (send_all(coproc, request, len) == 0)
+    {
+      coproc->round_trips++;
+      while (answered < count)
+      {
+        if (next_answer(coproc, types[answered]))
+          answered++;
+        else if (read_answers(coproc) == -1)
+          break;
+      }
+    }
+    if (answered < count)
+      filecoproc_stop(coproc);
+  }
+
+  size_t typed = 0;
+  for (size_t i = 0; i < answered; i++)
+  {
+    if (filecoproc_is_mime_type(types[i]))
+    {
+      typed++;
+      continue;
+    }
+    log_message(LOG_LEVEL_DEBUG, " [FILECOPROC] Not a MIME type: %s", types[i]);
+    types[i][0] = '\0';
+  }
+
+  coproc->answers += typed;
+  coproc->rejected += answered - typed;
+  if (typed > 0)
+    coproc->fails = 0;
+  else if (++coproc->fails >= FILECOPROC_MAX_FAILS)
+  {
+    log_message(LOG_LEVEL_ERROR, " [FILECOPROC] Unable to get MIME types from `file`, giving up");
+    filecoproc_stop(coproc);
+    coproc->disabled = 1;
+  }
+  return answered;
+}
+
+/* `who` tells the coprocesses of different threads apart in the log */
+void filecoproc_log_stats(const FileCoproc* coproc, const char* who)
+{
+  log_message(LOG_LEVEL_DEBUG,
+              " [FILECOPROC] %s: starts: %lu, round trips: %lu, answers: %lu, rejected: %lu", who,
+              coproc->starts, coproc->round_trips, coproc->answers, coproc->rejected);
+}
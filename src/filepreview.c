@@ -7,12 +7,16 @@
 /* By nots1dd */
 
 #include "../include/filepreview.h"
+#include "../include/compositor.h"
 #include "../include/cursesutils.h"
 #include "../include/highlight.h"
 #include "../include/logging.h"
+#include "../include/mimetype.h"
+#include "../include/previewtext.h"
 #include "../include/signalhandling.h"
+#include "../include/syntax.h"
 
-int singlecommentslen = 0;
+#include <fcntl.h>
 
 const char* determine_file_type(const char* filename);
 
@@ -39,97 +43,8 @@ const char* get_file_extension(const char* filename)
   return dot + 1;
 }
 
-const char* determine_file_type(const char* filename)
-{
-  static char file_type[MAX_FILE_TYPE_LENGTH];
-  char*       command;
-
-  // Construct the command to run the 'file' command with the provided filename
-  asprintf(&command, "file --brief --mime-type \"%s\"", filename);
-
-  FILE* fp = popen(command, "r");
-  if (!fp)
-  {
-    return "Error";
-  }
-
-  // Read the output from the 'file' command
-  if (fgets(file_type, sizeof(file_type), fp) == NULL)
-  {
-    pclose(fp);
-    return "Unknown";
-  }
-
-  // Remove trailing newline character
-  file_type[strcspn(file_type, "\n")] = '\0';
-
-  pclose(fp);
-  return file_type;
-}
-
-const char* read_lines(const char* filename, size_t max_lines)
-{
-  FILE* file = fopen(filename, "r"); // Open file in text mode
-  if (file == NULL)
-  {
-    perror("Error opening file");
-    return NULL;
-  }
-
-  // Allocate buffer for the entire content
-  char* content = (char*)malloc(BUFFER_SIZE);
-  if (content == NULL)
-  {
-    perror("Memory allocation failed");
-    fclose(file);
-    return NULL;
-  }
-
-  size_t content_size = BUFFER_SIZE;
-  size_t total_length = 0;
-  size_t line_count   = 0;
-
-  while (line_count < max_lines)
-  {
-    if (fgets(content + total_length, content_size - total_length, file) == NULL)
-    {
-      if (feof(file))
-      {
-        break; // End of file reached
-      }
-      perror("Error reading file");
-      free(content);
-      fclose(file);
-      return NULL;
-    }
-
-    total_length = strlen(content);
-    if (total_length > 0 && content[total_length - 1] == '\n')
-    {
-      line_count++;
-    }
-
-    // Reallocate if needed
-    if (total_length + BUFFER_SIZE > content_size)
-    {
-      content_size += BUFFER_SIZE;
-      content = (char*)realloc(content, content_size);
-      if (content == NULL)
-      {
-        perror("Memory reallocation failed");
-        fclose(file);
-        return NULL;
-      }
-    }
-  }
-
-  fclose(file);
-
-  // Ensure the string is null-terminated
-  content[total_length] = '\0';
-
-  return content;
-}
+/* MIME type of `filename`, in process through libmagic when we have it (see mimetype.h) */
+const char* determine_file_type(const char* filename) { return mimetype_at(AT_FDCWD, filename); }
 
 const char* empty_message[] = {" _____ __  __ ____ _______   __  _____ ___ _     _____   _ ",
                                "| ____|  \\/  |  _ \\_   _\\ \\ / / |  ___|_ _| |   | ____| | |",
@@ -138,110 +53,29 @@ const char* empty_message[] = {" _____ __  __ ____ _______   __  _____ ___ _
                                "|_____|_|  |_|_|    |_|   |_|   |_|   |___|_____|_____| (_)",
                                " "};
 
-const char* get_keywords_file(const char* mime_type)
+/* `mime` is the file's MIME type if the caller already has it (see entrymeta.h), else NULL */
+void display_file(WINDOW* info_win, const char* filename, const char* mime)
 {
-  static char keywords_file[256];
-  char*       project_dir;
-  char        resolved_path[PATH_MAX];
-
-  // Get the full path of the current file
-  if (realpath(__FILE__, resolved_path) != NULL)
-  {
-    // Get the directory where this source file is located
-    project_dir = dirname(resolved_path);
-
-    // Map MIME types to the corresponding YAML file
-    if (strcmp(mime_type, MIME_TEXT_C) == 0 || strcmp(mime_type, MIME_TEXT_CPP) == 0)
-    {
-      snprintf(keywords_file, sizeof(keywords_file), "%s/../keywords/c-keywords.yaml", project_dir);
-    }
-    else if (strcmp(mime_type, MIME_APPLICATION_JSON) == 0)
-    {
-      snprintf(keywords_file, sizeof(keywords_file), "%s/../keywords/json-keywords.yaml",
-               project_dir);
-    }
-    else if (strcmp(mime_type, MIME_TEXT_JAVASCRIPT) == 0)
-    {
-      snprintf(keywords_file, sizeof(keywords_file), "%s/../keywords/js-keywords.yaml",
-               project_dir);
-    }
-    else if (strcmp(mime_type, MIME_TEXT_PYTHON) == 0)
-    {
-      snprintf(keywords_file, sizeof(keywords_file), "%s/../keywords/py-keywords.yaml",
-               project_dir);
-    }
-    else if (strcmp(mime_type, MIME_TEXT_HTML) == 0)
-    {
-      snprintf(keywords_file, sizeof(keywords_file), "%s/../keywords/html-keywords.yaml",
-               project_dir);
-    }
-    else if (strcmp(mime_type, MIME_TEXT_CSS) == 0)
-    {
-      snprintf(keywords_file, sizeof(keywords_file), "%s/../keywords/css-keywords.yaml",
-               project_dir);
-    }
-    else if (strcmp(mime_type, MIME_TEXT_SHELLSCRIPT) == 0)
-    {
-      snprintf(keywords_file, sizeof(keywords_file), "%s/../keywords/sh-keywords.yaml",
-               project_dir);
-    }
-    else if (strcmp(mime_type, MIME_TEXT_JAVA) == 0)
-    {
-      snprintf(keywords_file, sizeof(keywords_file), "%s/../keywords/java-keywords.yaml",
-               project_dir);
-    }
-    /*else if (strcmp(mime_type, MIME_TEXT_MAKEFILE) == 0)*/
-    /*{*/
-    /*    snprintf(keywords_file, sizeof(keywords_file), "%s/../keywords/makefile-keywords.yaml",
-     * project_dir);*/
-    /*}*/
-    else
-    {
-      log_message(LOG_LEVEL_ERROR, " [LIBYAML] No desired yaml file found. Going default....");
-      return NULL;
-    }
-    log_message(LOG_LEVEL_DEBUG, " [SYNHASH] Loading in %s", keywords_file);
-  }
-  else
-  {
-    log_message(LOG_LEVEL_ERROR, " [SYNHASH] Could not resolve the project directory.");
-    return NULL;
-  }
-
-  return keywords_file;
-}
-
-void display_file(WINDOW* info_win, const char* filename)
-{
-
-  HashTable* keywords       = create_table();
-  HashTable* singlecomments = create_table();
-  HashTable* multicomments1 = create_table();
-  HashTable* multicomments2 = create_table();
-  HashTable* strings        = create_table();
-  HashTable* functions      = create_table();
-  HashTable* symbols        = create_table();
-  HashTable* operators      = create_table();
-
-  FILE* file = fopen(filename, "r");
-  if (!file)
+  // Non blocking, so a FIFO with no writer reads as empty instead of hanging the UI
+  int fd = open(filename, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+  if (fd == -1)
   {
     werase(info_win); // Clear the window first
     mvwprintw(info_win, 1, 2, "Error opening file");
     box(info_win, 0, 0);
-    wrefresh(info_win); // Refresh the window to show the error message
+    compositor_mark(info_win); // Refresh the window to show the error message
     return;
   }
-  char        keywords_file[256];
-  const char* ext                = determine_file_type(filename);
-  const char* keywords_file_path = get_keywords_file(ext);
-  bool        syntaxLoad =
-    load_syntax(keywords_file_path, keywords, singlecomments, multicomments1, multicomments2,
-                strings, functions, symbols, operators, &singlecommentslen);
+  // The extension decides, `file` is only asked about extensions we do not know
+  const ExtInfo* ext = ext_lookup(filename);
+  const char*    syntax =
+    ext ? ext->syntax : ext_syntax_for_mime(mime ? mime : determine_file_type(filename));
+  // Parsed once per language and session, see syntax.h
+  const Syntax* compiled   = syntax_get(syntax);
+  bool          syntaxLoad = compiled != NULL;
   werase(info_win);                             // Clear the window before displaying content
   mvwprintw(info_win, 0, 2, " File Preview: "); // Add a title to the window
 
-  char line[MAX_LINE_LENGTH];
   int  row        = 3; // Start at row 3 to account for the title and spacing
   int  lines_read = 0;
   char sanitizedCurPath[PATH_MAX];
@@ -275,23 +109,39 @@ void display_file(WINDOW* info_win, const char* filename)
   init_pair(27, COLOR_RED, -1);
   init_pair(28, 108, 235);
 
-  // Read file and display lines with syntax highlighting
+  // Anything drawn on the bottom border or below it is never seen
+  int bottom   = getmaxy(info_win) - 1;
+  int last_row = bottom < MAX_LINES - 1 ? bottom : MAX_LINES - 1; // of plain text
+  int lines    = last_row - row;
   if (syntaxLoad)
-  {
-    const char* text = read_lines(filename, MAX_LINES);
-    highlight_code(info_win, 3, 1, text, keywords, singlecomments, multicomments1, multicomments2,
-                   strings, functions, symbols, operators, &singlecommentslen);
-    wrefresh(info_win);
-  }
+    lines = bottom - row < MAX_LINES ? bottom - row : MAX_LINES;
+  if (lines < 1)
+    lines = 1;
+
+  // Only what fits is read, see previewtext.h. Plain text rows are MAX_LINE_LENGTH - 1 at most.
+  PreviewText view;
+  previewtext_read(&view, fd, (size_t)lines,
+                   syntaxLoad ? PREVIEWTEXT_MAX_BYTES : (size_t)lines * (MAX_LINE_LENGTH - 1));
+  close(fd);
+
+  if (syntaxLoad)
+    highlight_code(info_win, row, 1, view.text, compiled);
   else
   {
-    while (fgets(line, sizeof(line), file) && row < MAX_LINES - 1)
+    // Longer lines take more than one row
+    const char* cursor = view.text;
+    const char* end    = view.text + view.len;
+    while (cursor < end && row < last_row)
     {
-      // Remove newline character from the line if present
-      line[strcspn(line, "\n")] = '\0';
-
-      // Highlight syntax in the line and display
-      mvwprintw(info_win, row, 1, "%s", line);
+      size_t      chunk = (size_t)(end - cursor);
+      const char* nl;
+      if (chunk > MAX_LINE_LENGTH - 1)
+        chunk = MAX_LINE_LENGTH - 1;
+      if ((nl = memchr(cursor, '\n', chunk)) != NULL)
+        chunk = (size_t)(nl + 1 - cursor);
+
+      mvwprintw(info_win, row, 1, "%.*s", (int)(nl ? chunk - 1 : chunk), cursor);
+      cursor += chunk;
       row++;
       lines_read++;
     }
@@ -306,19 +156,14 @@ void display_file(WINDOW* info_win, const char* filename)
     }
     mvwprintw(info_win, empty_message_size + 4, 2, "Printed by LiteFM");
   }
-  fclose(file);
 
   // Draw border and refresh window
   draw_colored_border(info_win, 4);
-  wrefresh(info_win); // Refresh the window to show the content
 }
 
-const char* is_readable_extension(const char* filename, const char* current_path)
+/* What we can do with a file of MIME type `file_type`: READABLE, AUDIO, VIDEO, IMAGE or "NULL" */
+const char* preview_class(const char* file_type)
 {
-  char filepath[PATH_MAX];
-  snprintf(filepath, PATH_MAX, "%s/%s", current_path, filename);
-  const char* file_type = determine_file_type(filepath);
-
   if (file_type)
   {
     if (strcmp(file_type, MIME_TEXT_PLAIN) == 0 || strcmp(file_type, MIME_TEXT_SHELLSCRIPT) == 0 ||
@@ -496,7 +341,7 @@ void launch_env_var(WINDOW* win, const char* current_path, const char* filename,
   cbreak();
   noecho();
   keypad(win, TRUE);
-  refresh();
+  compositor_mark(stdscr);
   clear();
 }
 
@@ -542,7 +387,7 @@ void print_permissions(WINDOW* info_win, struct stat* file_stat)
  *
  */
 
-void display_archive_contents(WINDOW* info_win, const char* full_path, const char* file_ext)
+void display_archive_contents(WINDOW* info_win, const char* full_path, ExtArchive format)
 {
   // Validate and sanitize user input
   char* file_name = basename(full_path);
@@ -553,19 +398,9 @@ void display_archive_contents(WINDOW* info_win, const char* full_path, const cha
     return;
   }
 
-  // Whitelist valid file extensions
-  const char* valid_exts[] = {".zip", ".7z", ".tar", ".gz"};
-  int         ext_len      = strlen(file_ext);
-  bool        is_valid_ext = false;
-  for (int i = 0; i < sizeof(valid_exts) / sizeof(valid_exts[0]); i++)
-  {
-    if (strcmp(file_ext, valid_exts[i]) == 0)
-    {
-      is_valid_ext = true;
-      break;
-    }
-  }
-  if (!is_valid_ext)
+  // Only formats we have a lister for (see exttable.def)
+  if (format != EXT_ARCHIVE_ZIP && format != EXT_ARCHIVE_SEVENZIP && format != EXT_ARCHIVE_TAR &&
+      format != EXT_ARCHIVE_GZIP)
   {
     show_message(info_win, "Unsupported file extension.");
     return;
@@ -583,11 +418,11 @@ void display_archive_contents(WINDOW* info_win, const char* full_path, const cha
    *
    */
   char* cmd;
-  if (strcmp(file_ext, ".zip") == 0)
+  if (format == EXT_ARCHIVE_ZIP)
   {
     asprintf(&cmd, "unzip -l '%s/%s'", dir_name, file_name);
   }
-  else if (strcmp(file_ext, ".7z") == 0)
+  else if (format == EXT_ARCHIVE_SEVENZIP)
   {
     asprintf(&cmd, "7z l '%s/%s'", dir_name, file_name);
   }
@@ -614,5 +449,5 @@ void display_archive_contents(WINDOW* info_win, const char* full_path, const cha
   pclose(fp);
 
   // Refresh the window to display the output
-  wrefresh(info_win);
+  compositor_mark(info_win);
 }
@@ -189,12 +189,12 @@ void highlightLine(WINDOW* win, int color_pair, int y, int x, char* buffer)
   wattroff(win, COLOR_PAIR(color_pair));
 }
 
-// Function to highlight code snippet
-void highlight_code(WINDOW* win, int start_y, int start_x, const char* code, HashTable* keywords,
-                    HashTable* singlecomments, HashTable* multicomments1, HashTable* multicomments2,
-                    HashTable* strings, HashTable* functions, HashTable* symbols,
-                    HashTable* operators, int* singlecommentslen)
+// Function to highlight code snippet, `syntax` comes from syntax_get and is only read
+void highlight_code(WINDOW* win, int start_y, int start_x, const char* code,
+                    const Syntax* syntax)
 {
+  const int* singlecommentslen = &syntax->singlecommentslen;
+
   int         max_x_coord = getmaxx(win) - 1;
   const char* cursor      = code;
   char        buffer[256];
@@ -207,8 +207,8 @@ void highlight_code(WINDOW* win, int start_y, int start_x, const char* code, Has
   while (*cursor != '\0' && x != max_x_coord)
   {
     // Check for multiline comments first
-    if (hash_table_contains(multicomments1, cursor) &&
-        hash_table_contains(multicomments2, cursor + 1))
+    if (syntax_has_char(syntax, SYNTAX_MULTICOMMENTS1, cursor) &&
+        syntax_has_char(syntax, SYNTAX_MULTICOMMENTS2, cursor + 1))
     {
       in_multiline_comment = 1;
       cursor++;
@@ -226,8 +226,8 @@ void highlight_code(WINDOW* win, int start_y, int start_x, const char* code, Has
     else if (in_multiline_comment)
     {
       highlightLine(win, 21, y, x, (char[]){*cursor, '\0'});
-      if (hash_table_contains(multicomments2, cursor) &&
-          hash_table_contains(multicomments1, cursor + 1))
+      if (syntax_has_char(syntax, SYNTAX_MULTICOMMENTS2, cursor) &&
+          syntax_has_char(syntax, SYNTAX_MULTICOMMENTS1, cursor + 1))
       {
         highlightLine(win, 21, y, x + 1, (char[]){*(cursor + 1), '\0'});
         x++;
@@ -244,7 +244,7 @@ void highlight_code(WINDOW* win, int start_y, int start_x, const char* code, Has
       cursor++;
     }
     // Then check for strings
-    else if (hash_table_contains(strings, cursor))
+    else if (syntax_has_char(syntax, SYNTAX_STRINGS, cursor))
     {
       if (!in_string)
       {
@@ -272,7 +272,7 @@ void highlight_code(WINDOW* win, int start_y, int start_x, const char* code, Has
     }
 
     // Then check for single line comments
-    else if (hash_table_contains(singlecomments, cursor) && !in_string)
+    else if (syntax_has_char(syntax, SYNTAX_SINGLECOMMENTS, cursor) && !in_string)
     {
       int comment_track = 1;
 
@@ -289,7 +289,7 @@ void highlight_code(WINDOW* win, int start_y, int start_x, const char* code, Has
       // Check if the length of the comment matches singlecommentslen
       while (comment_track < *singlecommentslen && *cursor != '\0' && *cursor != ' ')
       {
-        if (hash_table_contains(singlecomments, cursor))
+        if (syntax_has_char(syntax, SYNTAX_SINGLECOMMENTS, cursor))
         {
           comment_track++;
           cursor++;
@@ -377,7 +377,7 @@ void highlight_code(WINDOW* win, int start_y, int start_x, const char* code, Has
       if (buffer_index > 0)
       {
         buffer[buffer_index] = '\0';
-        if (search(functions, buffer))
+        if (syntax_has_word(syntax, SYNTAX_FUNCTIONS, buffer))
         {
           highlightLine(win, 26, y, x, buffer);
         }
@@ -400,7 +400,7 @@ void highlight_code(WINDOW* win, int start_y, int start_x, const char* code, Has
         cursor++;
       }
       buffer[buffer_index] = '\0';
-      if (search(functions, buffer))
+      if (syntax_has_word(syntax, SYNTAX_FUNCTIONS, buffer))
       {
         highlightLine(win, 26, y, x, buffer);
       }
@@ -418,15 +418,15 @@ void highlight_code(WINDOW* win, int start_y, int start_x, const char* code, Has
       if (buffer_index > 0)
       {
         buffer[buffer_index] = '\0';
-        if (search(keywords, buffer))
+        if (syntax_has_word(syntax, SYNTAX_KEYWORDS, buffer))
         {
           highlightLine(win, 24, y, x, buffer);
         }
-        else if (search(functions, buffer))
+        else if (syntax_has_word(syntax, SYNTAX_FUNCTIONS, buffer))
         {
           highlightLine(win, 26, y, x, buffer);
         }
-        else if (search(symbols, buffer))
+        else if (syntax_has_word(syntax, SYNTAX_SYMBOLS, buffer))
         {
           highlightLine(win, 25, y, x, buffer);
         }
@@ -464,21 +464,21 @@ void highlight_code(WINDOW* win, int start_y, int start_x, const char* code, Has
       x++;
       cursor++;
     }
-    else if (hash_table_contains(operators, cursor))
+    else if (syntax_has_char(syntax, SYNTAX_OPERATORS, cursor))
     {
       if (buffer_index > 0)
       {
         buffer[buffer_index] = '\0';
         // Print buffer content before handling the operator
-        if (search(keywords, buffer))
+        if (syntax_has_word(syntax, SYNTAX_KEYWORDS, buffer))
         {
           highlightLine(win, 24, y, x, buffer);
         }
-        else if (search(functions, buffer))
+        else if (syntax_has_word(syntax, SYNTAX_FUNCTIONS, buffer))
         {
           highlightLine(win, 26, y, x, buffer);
         }
-        else if (search(symbols, buffer))
+        else if (syntax_has_word(syntax, SYNTAX_SYMBOLS, buffer))
         {
           highlightLine(win, 25, y, x, buffer);
         }
@@ -495,7 +495,7 @@ void highlight_code(WINDOW* win, int start_y, int start_x, const char* code, Has
       cursor++;
     }
     // Handle symbols
-    else if (hash_table_contains(symbols, cursor) && *cursor != '(')
+    else if (syntax_has_char(syntax, SYNTAX_SYMBOLS, cursor) && *cursor != '(')
     {
       if (buffer_index > 0)
       {
@@ -520,15 +520,15 @@ void highlight_code(WINDOW* win, int start_y, int start_x, const char* code, Has
   if (buffer_index > 0)
   {
     buffer[buffer_index] = '\0';
-    if (search(keywords, buffer))
+    if (syntax_has_word(syntax, SYNTAX_KEYWORDS, buffer))
     {
       highlightLine(win, 24, y, x, buffer);
     }
-    else if (search(functions, buffer))
+    else if (syntax_has_word(syntax, SYNTAX_FUNCTIONS, buffer))
     {
       highlightLine(win, 26, y, x, buffer);
     }
-    else if (search(symbols, buffer))
+    else if (syntax_has_word(syntax, SYNTAX_SYMBOLS, buffer))
     {
       highlightLine(win, 25, y, x, buffer);
     }
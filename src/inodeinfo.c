@@ -1,5 +1,6 @@
 
 #include "../include/inodeinfo.h"
+#include "../include/compositor.h"
 #include "../include/cursesutils.h"
 #include "../include/filepreview.h"
 #include "../include/logging.h"
@@ -28,14 +29,28 @@ int cap_label_length(unsigned int len, unsigned int quarter, unsigned int margin
   }
 }
 
-void get_file_info_popup(WINDOW* main_win, const char* path, const char* filename)
+/* opendir() for an entry of `dir_fd` */
+static DIR* opendir_at(int dir_fd, const char* name)
+{
+  int fd = openat(dir_fd, name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (fd == -1)
+    return NULL;
+  DIR* dir = fdopendir(fd);
+  if (dir == NULL)
+    close(fd);
+  return dir;
+}
+
+/* `mime` is the file's MIME type if the caller already has it (see entrymeta.h), else NULL */
+void get_file_info_popup(WINDOW* main_win, int dir_fd, const char* path, const char* filename,
+                         const char* mime)
 {
   struct stat file_stat;
   char        full_path[PATH_MAX];
   snprintf(full_path, PATH_MAX, "%s/%s", path, filename);
 
   // Get file information
-  if (stat(full_path, &file_stat) == -1)
+  if (fstatat(dir_fd, filename, &file_stat, 0) == -1)
   {
     log_message(LOG_LEVEL_ERROR, "Error retrieving file information for `%s`", full_path);
     show_message(main_win, "Error retrieving file information.");
@@ -71,7 +86,7 @@ void get_file_info_popup(WINDOW* main_win, const char* path, const char* filenam
   wattron(info_win, COLOR_PAIR(AUDIO_COLOR_PAIR));
   if (file_ext != NULL)
   {
-    wprintw(info_win, "%s", determine_file_type(full_path));
+    wprintw(info_win, "%s", mime ? mime : determine_file_type(full_path));
   }
   else
   {
@@ -104,39 +119,58 @@ void get_file_info_popup(WINDOW* main_win, const char* path, const char* filenam
   wattroff(info_win, COLOR_PAIR(AUDIO_COLOR_PAIR));
 
   colorLine(info_win, "Press any key to close this window.", 2, info_win_height - 2, 2);
-  wrefresh(info_win);
+  compositor_present(info_win);
 
   wgetch(info_win); // Wait for user input
   wclear(info_win); // Clear info window before deleting
   delwin(info_win); // Delete info window
 
   // Refresh the main window to ensure no artifacts remain
-  wrefresh(main_win);
+  compositor_mark(main_win);
 }
 
-void get_file_info(WINDOW* info_win, const char* path, const char* filename)
+/*
+ * `filename` is an entry of `dir_fd`, the directory `path` (see navctx.h).
+ *
+ * `cached` and `mime` are the entry's metadata and MIME type if the caller
+ * already has them (see entrymeta.h), pass NULL to have them looked up here.
+ */
+void get_file_info(WINDOW* info_win, int dir_fd, const char* path, const char* filename,
+                   const struct stat* cached, const char* mime)
 {
   werase(info_win);
   struct stat file_stat;
+  char        name[PATH_MAX];
   char        full_path[PATH_MAX];
   char        truncated_file_name[MAX_ITEM_NAME_LENGTH + 4]; // +4 for ellipsis and space
   char        symlink_target[PATH_MAX];
   ssize_t     len;
 
-  snprintf(full_path, PATH_MAX, "%s/%s", path, filename);
-  truncate_symlink_name(full_path);
+  snprintf(name, PATH_MAX, "%s", filename);
+  if (snprintf(full_path, PATH_MAX, "%s/%s", path, name) >= PATH_MAX)
+  {
+    log_message(LOG_LEVEL_ERROR, "Path too long for file information: %s/%s", path, name);
+    show_message(info_win, "Path too long.");
+    box(info_win, 0, 0);
+    compositor_mark(info_win);
+    return;
+  }
 
   // Get file information using lstat to handle symlinks
-  if (lstat(full_path, &file_stat) == -1)
+  if (cached != NULL)
+  {
+    file_stat = *cached;
+  }
+  else if (fstatat(dir_fd, name, &file_stat, AT_SYMLINK_NOFOLLOW) == -1)
   {
     log_message(LOG_LEVEL_ERROR, "Error retrieving file information for %s", full_path);
     show_message(info_win, "Error retrieving file/dir info.");
     box(info_win, 0, 0);
-    wrefresh(info_win);
+    compositor_mark(info_win);
     return;
   }
 
-  if (access(full_path, R_OK) != 0)
+  if (faccessat(dir_fd, name, R_OK, 0) != 0)
   {
     log_message(LOG_LEVEL_ERROR, "Access denied for %s", full_path);
     int denied_message_size = sizeof(denied_message) / sizeof(denied_message[0]);
@@ -146,7 +180,7 @@ void get_file_info(WINDOW* info_win, const char* path, const char* filename)
     }
     show_message(info_win, "Access denied for you!");
     box(info_win, 0, 0);
-    wrefresh(info_win);
+    compositor_mark(info_win);
     return;
   }
 
@@ -177,13 +211,12 @@ void get_file_info(WINDOW* info_win, const char* path, const char* filename)
   wprintw(info_win, "%s", format_file_size(file_stat.st_size));
   wattroff(info_win, COLOR_PAIR(AUDIO_COLOR_PAIR));
 
-  const char* file_ext = strrchr(filename, '.');
   clearLine(info_win, 5, 2);
   colorLine(info_win, "Inode Type: ", 3, 5, 2);
   wattron(info_win, COLOR_PAIR(AUDIO_COLOR_PAIR));
   if (!S_ISDIR(file_stat.st_mode))
   {
-    wprintw(info_win, "%s", determine_file_type(full_path));
+    wprintw(info_win, "%s", mime ? mime : determine_file_type(full_path));
   }
   else
   {
@@ -226,11 +259,11 @@ void get_file_info(WINDOW* info_win, const char* path, const char* filename)
     wprintw(info_win, "Regular File");
 
     // Check if the file is an archive
-    if (file_ext != NULL && (strcmp(file_ext, ".zip") == 0 || strcmp(file_ext, ".7z") == 0 ||
-                             strcmp(file_ext, ".tar") == 0 || strcmp(file_ext, ".gz") == 0))
+    const ExtInfo* ext = ext_lookup(filename);
+    if (ext != NULL && ext->archive != EXT_ARCHIVE_NONE)
     {
       // Display archive contents
-      display_archive_contents(info_win, full_path, file_ext);
+      display_archive_contents(info_win, full_path, (ExtArchive)ext->archive);
     }
   }
   else if (S_ISDIR(file_stat.st_mode))
@@ -245,22 +278,13 @@ void get_file_info(WINDOW* info_win, const char* path, const char* filename)
     mvwprintw(info_win, 12, getmaxx(info_win) / 2, " Children: ");
     wattroff(info_win, A_BOLD | COLOR_PAIR(DARK_BG_COLOR_PAIR));
 
-    char parent_dir[PATH_MAX];
-    char current_path[PATH_MAX];
-    strncpy(current_path, path, sizeof(current_path));
-    current_path[sizeof(current_path) - 1] = '\0'; // Ensure null termination
-    char* parent_dir_ptr                   = dirname(current_path);
-
-    // Make a copy of the parent directory path to avoid modifying the original path
-    strncpy(parent_dir, parent_dir_ptr, sizeof(parent_dir));
-    parent_dir[sizeof(parent_dir) - 1] = '\0'; // Ensure null termination
-    int line                           = 13;
-    int sub_dir_line                   = 13;
+    int line         = 13;
+    int sub_dir_line = 13;
     int max_y, max_x;
     getmaxyx(info_win, max_y, max_x);
 
     // Print parent directories on the left
-    DIR*           dir = opendir(parent_dir);
+    DIR*           dir = opendir_at(dir_fd, "..");
     struct dirent* entry;
     if (dir != NULL)
     {
@@ -302,7 +326,7 @@ void get_file_info(WINDOW* info_win, const char* path, const char* filename)
     }
 
     // Print subdirectories and files on the right
-    dir = opendir(full_path);
+    dir = opendir_at(dir_fd, name);
     if (dir != NULL)
     {
       while ((entry = readdir(dir)) != NULL && sub_dir_line < max_y - 1)
@@ -358,7 +382,7 @@ void get_file_info(WINDOW* info_win, const char* path, const char* filename)
     wprintw(info_win, "Symbolic Link");
 
     // Read the symlink target
-    len = readlink(full_path, symlink_target, sizeof(symlink_target) - 1);
+    len = readlinkat(dir_fd, name, symlink_target, sizeof(symlink_target) - 1);
     if (len != -1)
     {
       symlink_target[len] = '\0'; // Null-terminate the string
@@ -401,35 +425,14 @@ void get_file_info(WINDOW* info_win, const char* path, const char* filename)
   print_permissions(info_win, &file_stat);
 
   box(info_win, 0, 0);
-  wrefresh(info_win);
-}
-
-/*
- * TRUNCATING A SYMLINK NAME IS NECESSARY AS THE ITEM NAME MIGHT HAVE
- * THE STRING QUERY WE ARE LOOKING FOR,
- *
- * EXAMPLE: LIB64 ->LIB
- * IF I WANT TO SEARCH FOR LIB, I SHOULD GO TO THE ITEM THAT ACTUALLY
- * HAS THE STRING `LIB`, AND NOT A SYMLINK OF IT.
- *
- */
-void truncate_symlink_name(char* name)
-{
-  char* arrow = strstr(name, " ->");
-  if (arrow)
-  {
-    *arrow = '\0'; // Truncate the name at the " -> " point
-  }
+  compositor_mark(info_win);
 }
 
-int is_symlink(const char* path)
+int is_symlink(int dir_fd, const char* name)
 {
   struct stat statbuf;
-  char        tmpPath[MAX_PATH_LENGTH];
-  strcpy(tmpPath, path);
-  truncate_symlink_name(tmpPath);
   // Use lstat to check for symbolic links
-  if (lstat(tmpPath, &statbuf) == 0)
+  if (fstatat(dir_fd, name, &statbuf, AT_SYMLINK_NOFOLLOW) == 0)
   {
     if (S_ISLNK(statbuf.st_mode))
     {
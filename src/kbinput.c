@@ -1,8 +1,10 @@
 
 #include "../include/kbinput.h"
 #include "../include/archivecontrol.h"
+#include "../include/compositor.h"
 #include "../include/cursesutils.h"
 #include "../include/dircontrol.h"
+#include "../include/exttable.h"
 #include "../include/filepreview.h"
 #include "../include/inodeinfo.h"
 #include "../include/logging.h"
@@ -35,11 +37,30 @@ void handleInputScrollDown(int* highlight, int* scroll_position, int* item_count
   }
 }
 
-void handleInputToggleHidden(int* show_hidden, int* scroll_position, int* highlight)
+/*
+ * Dot entries are always part of the listing, hiding them is a filter over
+ * what is already in memory (see entrystore.h) so nothing is read again.
+ * The cursor stays on its entry, or the next one that is still shown.
+ */
+void handleInputToggleHidden(int* show_hidden, EntryStore* items, int* item_count, int* highlight,
+                             int* scroll_position)
 {
-  *show_hidden     = !*show_hidden; // Toggle show_hidden flag
-  *highlight       = 0;
-  *scroll_position = 0;
+  size_t highlighted   = entry_store_record(items, *highlight);
+  int    old_highlight = *highlight;
+
+  *show_hidden = !*show_hidden; // Toggle show_hidden flag
+  entry_store_set_filter(items, *show_hidden ? 0 : ENTRY_HIDDEN);
+  *item_count = entry_store_rows(items);
+
+  *highlight = entry_store_row(items, highlighted);
+  if (*highlight >= *item_count)
+    *highlight = *item_count - 1;
+  if (*highlight < 0)
+    *highlight = 0;
+  // Keep the cursor on the same screen line
+  *scroll_position += *highlight - old_highlight;
+  if (*scroll_position < 0)
+    *scroll_position = 0;
 }
 
 void handleInputMovCursBtm(int* highlight, int* item_count, int* scroll_position, int* max_y)
@@ -64,31 +85,39 @@ void handleInputMovCursTop(int* highlight, int* scroll_position)
   *scroll_position = 0;
 }
 
-int find_item(const char* query, FileItem items[], int* item_count, int* start_index, int direction)
+/*
+ * Case insensitive substring match against the name of an entry (a symlink's
+ * target is not part of it).
+ */
+static int item_matches(const char* name, const char* lower_query)
+{
+  char lower_name[NAME_MAX + 1];
+  snprintf(lower_name, sizeof(lower_name), "%s", name);
+
+  for (int j = 0; lower_name[j]; j++)
+  {
+    lower_name[j] = tolower((unsigned char)lower_name[j]);
+  }
+
+  return strstr(lower_name, lower_query) != NULL;
+}
+
+int find_item(const char* query, const EntryStore* items, int* item_count, int* start_index,
+              int direction)
 {
   char lower_query[NAME_MAX];
-  for (int i = 0; query[i] && i < NAME_MAX; i++)
+  int  qlen = 0;
+  for (; query[qlen] && qlen < NAME_MAX - 1; qlen++)
   {
-    lower_query[i] = tolower(query[i]);
+    lower_query[qlen] = tolower((unsigned char)query[qlen]);
   }
-  lower_query[strlen(query)] = '\0';
+  lower_query[qlen] = '\0';
 
   if (direction == 1)
   { // Forward search
     for (int i = *start_index; i < *item_count; i++)
     {
-      char truncated_name[NAME_MAX];
-      strcpy(truncated_name, items[i].name);
-      truncate_symlink_name(truncated_name);
-
-      char lower_name[NAME_MAX];
-      for (int j = 0; truncated_name[j] && j < NAME_MAX; j++)
-      {
-        lower_name[j] = tolower(truncated_name[j]);
-      }
-      lower_name[strlen(truncated_name)] = '\0';
-
-      if (strstr(lower_name, lower_query) != NULL)
+      if (item_matches(entry_store_name(items, i), lower_query))
       {
         *start_index = i;
         return i;
@@ -96,18 +125,7 @@ int find_item(const char* query, FileItem items[], int* item_count, int* start_i
     }
     for (int i = 0; i < *start_index; i++)
     {
-      char truncated_name[NAME_MAX];
-      strcpy(truncated_name, items[i].name);
-      truncate_symlink_name(truncated_name);
-
-      char lower_name[NAME_MAX];
-      for (int j = 0; truncated_name[j] && j < NAME_MAX; j++)
-      {
-        lower_name[j] = tolower(truncated_name[j]);
-      }
-      lower_name[strlen(truncated_name)] = '\0';
-
-      if (strstr(lower_name, lower_query) != NULL)
+      if (item_matches(entry_store_name(items, i), lower_query))
       {
         *start_index = i;
         return i;
@@ -118,18 +136,7 @@ int find_item(const char* query, FileItem items[], int* item_count, int* start_i
   { // Backward search
     for (int i = *start_index; i >= 0; i--)
     {
-      char truncated_name[NAME_MAX];
-      strcpy(truncated_name, items[i].name);
-      truncate_symlink_name(truncated_name);
-
-      char lower_name[NAME_MAX];
-      for (int j = 0; truncated_name[j] && j < NAME_MAX; j++)
-      {
-        lower_name[j] = tolower(truncated_name[j]);
-      }
-      lower_name[strlen(truncated_name)] = '\0';
-
-      if (strstr(lower_name, lower_query) != NULL)
+      if (item_matches(entry_store_name(items, i), lower_query))
       {
         *start_index = i;
         return i;
@@ -137,18 +144,7 @@ int find_item(const char* query, FileItem items[], int* item_count, int* start_i
     }
     for (int i = *item_count - 1; i > *start_index; i--)
     {
-      char truncated_name[NAME_MAX];
-      strcpy(truncated_name, items[i].name);
-      truncate_symlink_name(truncated_name);
-
-      char lower_name[NAME_MAX];
-      for (int j = 0; truncated_name[j] && j < NAME_MAX; j++)
-      {
-        lower_name[j] = tolower(truncated_name[j]);
-      }
-      lower_name[strlen(truncated_name)] = '\0';
-
-      if (strstr(lower_name, lower_query) != NULL)
+      if (item_matches(entry_store_name(items, i), lower_query))
       {
         *start_index = i;
         return i;
@@ -159,7 +155,7 @@ int find_item(const char* query, FileItem items[], int* item_count, int* start_i
   return -1; // Not found
 }
 
-void handleInputStringSearch(WINDOW* win, FileItem items[], int* item_count, int* highlight,
+void handleInputStringSearch(WINDOW* win, const EntryStore* items, int* item_count, int* highlight,
                              int* scroll_position, int* height, char* last_query,
                              const char* current_path)
 {
@@ -167,7 +163,7 @@ void handleInputStringSearch(WINDOW* win, FileItem items[], int* item_count, int
   wattron(win, A_BOLD | COLOR_PAIR(AQUA_COLOR_PAIR));
   mvwprintw(win, LINES - 3, (COLS / 2) - 75, "%s Search ON ", UNICODE_SEARCH);
   wattroff(win, A_BOLD | COLOR_PAIR(AQUA_COLOR_PAIR));
-  wrefresh(win);
+  compositor_mark(win);
 
   // Get user input for the search query
   char query[NAME_MAX];
@@ -202,7 +198,7 @@ void handleInputStringSearch(WINDOW* win, FileItem items[], int* item_count, int
   }
 }
 
-void handleInputStringOccurance(int direction, const char* last_query, FileItem items[],
+void handleInputStringOccurance(int direction, const char* last_query, const EntryStore* items,
                                 int* item_count, int* highlight, int* scroll_position, int* height)
 {
   if (strlen(last_query) > 0)
@@ -233,26 +229,29 @@ void handleInputStringOccurance(int direction, const char* last_query, FileItem
   }
 }
 
-void handleInputGoToDir(const char* current_path, const char* path, int* highlight,
-                        int* scroll_position)
+int handleInputGoToDir(NavContext* nav, const char* path, int* highlight, int* scroll_position)
 {
   show_term_message("", -1);
-  strcpy(current_path, path);
+  if (navctx_open(nav, path) == -1)
+  {
+    log_message(LOG_LEVEL_ERROR, "Unable to go to `%s`: %s", path, strerror(errno));
+    show_term_message("Invalid destination!", 1);
+    return -1;
+  }
   *highlight       = 0;
   *scroll_position = 0;
+  return 0;
 }
 
 void handleInputRename(int* item_count, int* highlight, int* scroll_position,
-                       const char* current_path, FileItem items[])
+                       const NavContext* nav, const EntryStore* items)
 {
   if (*item_count > 0)
   {
-    const char* current_name = items[*highlight].name;
-    char        full_path[PATH_MAX];
-    snprintf(full_path, PATH_MAX, "%s/%s", current_path, current_name);
+    const char* current_name = entry_store_name(items, *highlight);
 
     // Call the handle_rename function
-    handle_rename(stdscr, full_path);
+    handle_rename(stdscr, navctx_fd(nav), navctx_path(nav), current_name);
 
     // Update file list after renaming
     *scroll_position = 0;
@@ -265,12 +264,12 @@ void handleInputRename(int* item_count, int* highlight, int* scroll_position,
   }
 }
 
-void handleInputExtractArchive(WINDOW* win, FileItem items[], const char* current_path,
+void handleInputExtractArchive(WINDOW* win, const EntryStore* items, const char* current_path,
                                const char* last_query, int* scroll_position, int* highlight)
 {
-  const char* filename = items[*highlight].name;
-  if (strstr(filename, ".zip") || strstr(filename, ".tar") || strstr(filename, ".7z") ||
-      strstr(filename, ".jar"))
+  const char*    filename = entry_store_name(items, *highlight);
+  const ExtInfo* ext      = ext_lookup(filename);
+  if (!entry_store_is_dir(items, *highlight) && ext != NULL && ext->archive != EXT_ARCHIVE_NONE)
   {
     char full_path[PATH_MAX];
     snprintf(full_path, PATH_MAX, "%s/%s", current_path, filename);
@@ -290,20 +289,25 @@ void handleInputExtractArchive(WINDOW* win, FileItem items[], const char* curren
       }
     }
   }
-  else
+  else if (entry_store_is_dir(items, *highlight))
   {
-    log_message(LOG_LEVEL_ERROR, "Cannot extract %s as it is is directory", items[*highlight].name);
+    log_message(LOG_LEVEL_ERROR, "Cannot extract %s as it is is directory", entry_store_name(items, *highlight));
     show_term_message("Cannot extract a directory.", 1);
   }
+  else
+  {
+    log_message(LOG_LEVEL_ERROR, "Cannot extract %s, not a known archive format", filename);
+    show_term_message("Not a supported archive.", 1);
+  }
 }
 
-void handleInputCompressInode(WINDOW* win, FileItem items[], const char* current_path,
+void handleInputCompressInode(WINDOW* win, const EntryStore* items, const char* current_path,
                               int* highlight, int* scroll_position)
 {
-  if (items[*highlight].is_dir)
+  if (entry_store_is_dir(items, *highlight))
   {
 
-    const char* dirname = items[*highlight].name;
+    const char* dirname = entry_store_name(items, *highlight);
     char        full_path[PATH_MAX];
     snprintf(full_path, PATH_MAX, "%s/%s", current_path, dirname);
 
@@ -358,7 +362,7 @@ void handleInputCompressInode(WINDOW* win, FileItem items[], const char* current
   }
   else
   {
-    log_message(LOG_LEVEL_WARN, "Selected item %s is not a directory", items[*highlight].name);
+    log_message(LOG_LEVEL_WARN, "Selected item %s is not a directory", entry_store_name(items, *highlight));
     show_term_message("Selected item is not a directory.", 1);
   }
 }
@@ -409,75 +413,3 @@ void handleInputScopeBack(int* history_count, int* highlight, int* scroll_positi
   // List the contents of the new directory
   *scroll_position = 0;
 }
-
-/*void handleInputScopeForward(WINDOW* win, WINDOW* info_win, int* history_count, int* highlight,*/
-/*                             int* scroll_position, bool* firstKeyPress, FileItem items[],*/
-/*                             DirHistory history[], const char* cur_user, const char*
- * current_path)*/
-/*{*/
-/*  show_term_message("", -1);*/
-/*  char fullPath[MAX_PATH_LENGTH];*/
-/*  snprintf(fullPath, MAX_PATH_LENGTH, "%s/%s", current_path, items[*highlight].name);*/
-/**/
-/*  // Check access to the directory or file*/
-/**/
-/*  if (access(fullPath, R_OK) != 0)*/
-/*  {*/
-/*    // Log the message safely*/
-/*    log_message(LOG_LEVEL_ERROR, "[%s] Access denied for inode path %s: %s\n", cur_user,
- * fullPath,*/
-/*                strerror(errno));*/
-/**/
-/*    // Show the message to the user*/
-/*    show_term_message("Access denied for this inode. Check log more details..", 1);*/
-/*    return;*/
-/*  }*/
-/**/
-/*  // Check access to the realPath*/
-/*  if (items[*highlight].is_dir)*/
-/*  {*/
-/*    if (history_count < MAX_HISTORY)*/
-/*    {*/
-/*      strcpy(history[*history_count].path, current_path);*/
-/*      history[*history_count].highlight = *highlight;*/
-/*      (*history_count)++;*/
-/*    }*/
-/*    strcat(current_path, "/");*/
-/*    log_message(LOG_LEVEL_DEBUG, " [CHILD] Checking into %s", items[*highlight].name);*/
-/*    strcat(current_path, items[*highlight].name);*/
-/*    log_message(LOG_LEVEL_DEBUG, " [CHILD] Navigating into to %s", current_path);*/
-/*    *highlight       = 0;*/
-/*    *scroll_position = 0;*/
-/*  }*/
-/*  else*/
-/*  {*/
-/*    if ((is_readable_extension(items[*highlight].name) || !is_image(items[*highlight].name)) &&*/
-/*        !items[*highlight].is_dir && !is_audio(items[*highlight].name))*/
-/*    {*/
-/*      *firstKeyPress = true;*/
-/*      launch_env_var(win, current_path, items[*highlight].name, "EDITOR");*/
-/*      /* Since we have set firstKeyPress to true, it will not wgetch(), rather it will just
- * refresh*/
-/*       * everything back to how it was */
-/*    }*/
-/*    else if (is_image(items[*highlight].name) && !items[*highlight].is_dir)*/
-/*    {*/
-/*      *firstKeyPress = true;*/
-/*      launch_env_var(win, current_path, items[*highlight].name, "VISUAL");*/
-/*    }*/
-/*    else if (is_audio(items[*highlight].name) && !items[*highlight].is_dir)*/
-/*    {*/
-/*      char file_path[MAX_PATH_LENGTH];*/
-/*      snprintf(file_path, MAX_PATH_LENGTH, "%s/%s", current_path, items[*highlight].name);*/
-/*      show_term_message(" [PREVIEW] Previewing audio file. Press q to quit.", 0);*/
-/*      preview_audio(file_path);*/
-/*      show_term_message("", -1);*/
-/*    }*/
-/*    else*/
-/*    {*/
-/*      show_term_message("Cannot enter this directory/file.", 1);*/
-/*    }*/
-/*    check_term_size(win, info_win);*/
-/*    werase(win);*/
-/*  }*/
-/*}*/
@@ -17,16 +17,20 @@
    TO WORK!
 */
 
+#define _GNU_SOURCE
+
 #include "../include/logging.h"
 
-// Function to get the current time as a string
-const char* current_time_str()
+#include <fcntl.h>
+
+// Function to get the current time as a string, written into `buffer`
+const char* current_time_str(char* buffer, size_t buffer_size)
 {
-  static char time_str[20];
-  time_t      now = time(NULL);
-  struct tm*  t   = localtime(&now);
-  strftime(time_str, sizeof(time_str), "%Y-%m-%d %H:%M:%S", t);
-  return time_str;
+  time_t    now = time(NULL);
+  struct tm t;
+  if (localtime_r(&now, &t) == NULL || strftime(buffer, buffer_size, "%Y-%m-%d %H:%M:%S", &t) == 0)
+    snprintf(buffer, buffer_size, "?");
+  return buffer;
 }
 
 // Function to get the home directory path
@@ -86,6 +90,9 @@ void ensure_log_file_exists()
 }
 
 // Function to log messages
+// Worker threads log too: each record is formatted into one line and written
+// with a single write() on an O_APPEND descriptor, so records from different
+// threads never interleave.
 void log_message(LogLevel level, const char* format, ...)
 {
   ensure_log_directory_exists();
@@ -94,8 +101,8 @@ void log_message(LogLevel level, const char* format, ...)
   char log_file_path[PATH_MAX];
   get_log_file_path(log_file_path, sizeof(log_file_path));
 
-  FILE* log_file = fopen(log_file_path, "a");
-  if (log_file == NULL)
+  int log_fd = open(log_file_path, O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+  if (log_fd == -1)
   {
     perror("Failed to open log file");
     return;
@@ -120,12 +127,26 @@ void log_message(LogLevel level, const char* format, ...)
       level_str = "UNKNOWN";
   }
 
+  char time_str[20];
+  char line[LOG_LINE_MAX];
+  int  len = snprintf(line, sizeof(line), "[%s] [%s] ",
+                      current_time_str(time_str, sizeof(time_str)), level_str);
+
   va_list args;
   va_start(args, format);
-  fprintf(log_file, "[%s] [%s] ", current_time_str(), level_str);
-  vfprintf(log_file, format, args);
-  fprintf(log_file, "\n");
+  int message_len = vsnprintf(line + len, sizeof(line) - (size_t)len, format, args);
   va_end(args);
 
-  fclose(log_file);
+  // A record too long for the buffer is cut, it still ends in a newline
+  if (message_len < 0)
+    message_len = 0;
+  len += message_len;
+  if ((size_t)len > sizeof(line) - 2)
+    len = (int)sizeof(line) - 2;
+  line[len++] = '\n';
+
+  ssize_t written;
+  while ((written = write(log_fd, line, (size_t)len)) == -1 && errno == EINTR)
+    ;
+  close(log_fd);
 }
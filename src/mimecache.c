@@ -0,0 +1,332 @@
+// // // // // //
+//             //
+//   LITE FM   //
+//             //
+// // // // // //
+
+/* BY nots1dd */
+
+#define _GNU_SOURCE
+
+#include "../include/mimecache.h"
+#include "../include/logging.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MIMECACHE_MAGIC         "LFMMIME"
+#define MIMECACHE_VERSION       1
+#define MIMECACHE_TOUCH_SECS    (24 * 60 * 60)
+#define MIMECACHE_OPEN_ATTEMPTS 4 /* another instance can replace the file in between */
+
+typedef struct
+{
+  char     magic[8];
+  uint32_t version;
+  uint32_t slots;
+  uint32_t slot_size;
+  char     reserved[108];
+} MimeCacheHeader;
+
+typedef struct
+{
+  uint32_t seq;   /* odd while a writer is in the slot */
+  uint32_t stamp; /* seconds since the epoch when stored or last hit, 0 if empty */
+  uint64_t dev;
+  uint64_t ino;
+  uint64_t size;
+  int64_t  mtime_ns;
+  char     mime[MIMECACHE_MIME_MAX];
+} MimeCacheSlot;
+
+typedef char mimecache_header_is_128_bytes[sizeof(MimeCacheHeader) == 128 ? 1 : -1];
+typedef char mimecache_slot_is_128_bytes[sizeof(MimeCacheSlot) == 128 ? 1 : -1];
+
+#define MIMECACHE_FILE_SIZE (sizeof(MimeCacheHeader) + MIMECACHE_SLOTS * sizeof(MimeCacheSlot))
+
+/* The classification workers (see mimepool.h) look up and insert concurrently */
+#define MIMECACHE_COUNT(counter) __atomic_fetch_add(&cache.counter, 1, __ATOMIC_RELAXED)
+
+static struct
+{
+  void*          map; /* NULL while the cache is off */
+  MimeCacheSlot* slots;
+  unsigned long  hits;
+  unsigned long  misses;
+  unsigned long  stale; /* same inode, but size or mtime changed */
+  unsigned long  inserts;
+  unsigned long  evictions;
+} cache;
+
+static int64_t mtime_ns(const struct stat* st)
+{
+  return (int64_t)st->st_mtim.tv_sec * 1000000000LL + st->st_mtim.tv_nsec;
+}
+
+static uint32_t now_stamp(void) { return (uint32_t)time(NULL); }
+
+static size_t slot_of(uint64_t dev, uint64_t ino)
+{
+  uint64_t h = ino * 0x9E3779B97F4A7C15ULL ^ dev;
+  h ^= h >> 31;
+  h *= 0xBF58476D1CE4E5B9ULL;
+  h ^= h >> 29;
+  return (size_t)(h % MIMECACHE_SLOTS);
+}
+
+static int expired(uint32_t stamp, uint32_t now)
+{
+  return now - stamp > (uint32_t)MIMECACHE_MAX_AGE_DAYS * 24 * 60 * 60;
+}
+
+static int header_ok(const MimeCacheHeader* header)
+{
+  return memcmp(header->magic, MIMECACHE_MAGIC, sizeof(MIMECACHE_MAGIC)) == 0 &&
+         header->version == MIMECACHE_VERSION && header->slots == MIMECACHE_SLOTS &&
+         header->slot_size == sizeof(MimeCacheSlot);
+}
+
+/* Writes an empty cache file next to `path` and renames it over `path`. Returns 0 or -1. */
+static int mimecache_create(const char* path)
+{
+  char tmp[PATH_MAX];
+  if (snprintf(tmp, sizeof(tmp), "%s.XXXXXX", path) >= (int)sizeof(tmp))
+  {
+    errno = ENAMETOOLONG;
+    return -1;
+  }
+  int fd = mkostemp(tmp, O_CLOEXEC);
+  if (fd == -1)
+    return -1;
+
+  // A new file reads as zeroes, every slot is empty
+  MimeCacheHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, MIMECACHE_MAGIC, sizeof(MIMECACHE_MAGIC));
+  header.version   = MIMECACHE_VERSION;
+  header.slots     = MIMECACHE_SLOTS;
+  header.slot_size = sizeof(MimeCacheSlot);
+  int ok = ftruncate(fd, (off_t)MIMECACHE_FILE_SIZE) == 0 &&
+           pwrite(fd, &header, sizeof(header), 0) == (ssize_t)sizeof(header) &&
+           rename(tmp, path) == 0;
+  int saved = errno;
+  if (!ok)
+    unlink(tmp);
+  close(fd);
+  errno = saved;
+  return ok ? 0 : -1;
+}
+
+/*
+ * Opens the cache file if it is valid. If it is not, a new one is written
+ * under another name and renamed over it, under the old file's flock:
+ * instances that map the old file keep its inode (resetting it in place
+ * would SIGBUS their next lookup). Returns the fd of a valid file, -1 on
+ * error, or -2 if `path` was replaced since it was opened and has to be
+ * opened again.
+ */
+static int mimecache_open(const char* path)
+{
+  int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+  if (fd == -1)
+    return -1;
+
+  flock(fd, LOCK_EX);
+  struct stat     st;
+  struct stat     named;
+  MimeCacheHeader header;
+  int             result;
+  if (fstat(fd, &st) == -1)
+    result = -1;
+  else if (stat(path, &named) == -1 || named.st_dev != st.st_dev || named.st_ino != st.st_ino)
+    result = -2; // Another instance replaced it while we waited for the lock
+  else if ((size_t)st.st_size == MIMECACHE_FILE_SIZE &&
+           pread(fd, &header, sizeof(header), 0) == (ssize_t)sizeof(header) && header_ok(&header))
+    result = fd;
+  else if (mimecache_create(path) == 0)
+  {
+    log_message(LOG_LEVEL_DEBUG, " [MIMECACHE] Created %s", path);
+    result = -2;
+  }
+  else
+    result = -1;
+
+  int saved = errno;
+  flock(fd, LOCK_UN);
+  if (result != fd)
+    close(fd);
+  errno = saved;
+  return result;
+}
+
+/*
+ * @MIMECACHE_INIT
+ *
+ * Maps the cache file, creating (or replacing) it under an exclusive flock
+ * so that two instances starting at once do not both set it up. Returns 0,
+ * or -1 if the cache is off.
+ */
+int mimecache_init(void)
+{
+  if (cache.map != NULL)
+    return 0;
+
+  char path[PATH_MAX];
+  snprintf(path, sizeof(path), "%s/%s", get_home_directory(), MIMECACHE_RELATIVE_PATH);
+  int fd = -2;
+  for (int attempt = 0; fd == -2 && attempt < MIMECACHE_OPEN_ATTEMPTS; attempt++)
+    fd = mimecache_open(path);
+  if (fd < 0)
+  {
+    log_message(LOG_LEVEL_WARN, " [MIMECACHE] Unable to set up %s (%s), not caching", path,
+                fd == -1 ? strerror(errno) : "it keeps being replaced");
+    return -1;
+  }
+
+  void* map = mmap(NULL, MIMECACHE_FILE_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED)
+  {
+    log_message(LOG_LEVEL_WARN, " [MIMECACHE] mmap failed (%s), not caching", strerror(errno));
+    return -1;
+  }
+  cache.map   = map;
+  cache.slots = (MimeCacheSlot*)((char*)map + sizeof(MimeCacheHeader));
+  return 0;
+}
+
+void mimecache_free(void)
+{
+  if (cache.map != NULL)
+    munmap(cache.map, MIMECACHE_FILE_SIZE);
+  cache.map   = NULL;
+  cache.slots = NULL;
+}
+
+/*
+ * @MIMECACHE_LOOKUP
+ *
+ * Copies the cached MIME type of the file `st` describes into `mime`.
+ * Returns 1 on a hit, 0 otherwise.
+ */
+int mimecache_lookup(const struct stat* st, char* mime, size_t mime_size)
+{
+  if (cache.map == NULL)
+    return 0;
+
+  uint64_t dev   = (uint64_t)st->st_dev;
+  uint64_t ino   = (uint64_t)st->st_ino;
+  uint32_t now   = now_stamp();
+  size_t   first = slot_of(dev, ino);
+  for (size_t i = 0; i < MIMECACHE_PROBE; i++)
+  {
+    MimeCacheSlot* slot = &cache.slots[(first + i) % MIMECACHE_SLOTS];
+    uint32_t       seq  = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+    if (seq & 1)
+      continue;
+    if (slot->dev != dev || slot->ino != ino)
+      continue;
+
+    uint32_t stamp = slot->stamp;
+    int      fresh = slot->size == (uint64_t)st->st_size && slot->mtime_ns == mtime_ns(st) &&
+                !expired(stamp, now);
+    char copy[MIMECACHE_MIME_MAX];
+    memcpy(copy, slot->mime, sizeof(copy));
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (__atomic_load_n(&slot->seq, __ATOMIC_RELAXED) != seq)
+      break; // Rewritten while we read it
+
+    if (!fresh)
+    {
+      MIMECACHE_COUNT(stale);
+      return 0;
+    }
+    copy[sizeof(copy) - 1] = '\0';
+    snprintf(mime, mime_size, "%s", copy);
+    if (now - stamp > MIMECACHE_TOUCH_SECS)
+      __atomic_store_n(&slot->stamp, now, __ATOMIC_RELAXED);
+    MIMECACHE_COUNT(hits);
+    return 1;
+  }
+  MIMECACHE_COUNT(misses);
+  return 0;
+}
+
+/*
+ * @MIMECACHE_INSERT
+ *
+ * Stores `mime` for the file `st` describes: in the slot it already had,
+ * else an empty or expired one, else over the oldest in the probe window.
+ * Gives up quietly if another instance is writing that slot.
+ */
+void mimecache_insert(const struct stat* st, const char* mime)
+{
+  if (cache.map == NULL || strlen(mime) >= MIMECACHE_MIME_MAX)
+    return;
+
+  uint64_t       dev    = (uint64_t)st->st_dev;
+  uint64_t       ino    = (uint64_t)st->st_ino;
+  uint32_t       now    = now_stamp();
+  size_t         first  = slot_of(dev, ino);
+  MimeCacheSlot* victim = NULL;
+  uint32_t       oldest = 0;
+  for (size_t i = 0; i < MIMECACHE_PROBE; i++)
+  {
+    MimeCacheSlot* slot = &cache.slots[(first + i) % MIMECACHE_SLOTS];
+    if (slot->dev == dev && slot->ino == ino)
+    {
+      victim = slot;
+      break;
+    }
+    // Empty slots count as the oldest of all
+    uint32_t stamp = __atomic_load_n(&slot->stamp, __ATOMIC_RELAXED);
+    uint32_t age   = stamp == 0 ? UINT32_MAX : now - stamp;
+    if (victim == NULL || age > oldest)
+    {
+      victim = slot;
+      oldest = age;
+    }
+  }
+
+  uint32_t seq = __atomic_load_n(&victim->seq, __ATOMIC_RELAXED);
+  if ((seq & 1) || !__atomic_compare_exchange_n(&victim->seq, &seq, seq + 1, 0,
+                                                __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+    return;
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+
+  if (victim->stamp != 0 && (victim->dev != dev || victim->ino != ino))
+    MIMECACHE_COUNT(evictions);
+  victim->dev      = dev;
+  victim->ino      = ino;
+  victim->size     = (uint64_t)st->st_size;
+  victim->mtime_ns = mtime_ns(st);
+  victim->stamp    = now;
+  memset(victim->mime, 0, sizeof(victim->mime));
+  memcpy(victim->mime, mime, strlen(mime));
+  __atomic_store_n(&victim->seq, seq + 2, __ATOMIC_RELEASE);
+  MIMECACHE_COUNT(inserts);
+}
+
+void mimecache_log_stats(void)
+{
+  if (cache.map == NULL)
+    return;
+
+  size_t used = 0;
+  for (size_t i = 0; i < MIMECACHE_SLOTS; i++)
+    used += cache.slots[i].stamp != 0;
+  unsigned long lookups = cache.hits + cache.misses + cache.stale;
+  log_message(LOG_LEVEL_DEBUG,
+              " [MIMECACHE] hits: %lu/%lu (%lu%%), stale: %lu, inserts: %lu, evictions: %lu, "
+              "slots used: %zu/%d, file: %zu KiB",
+              cache.hits, lookups, lookups ? cache.hits * 100 / lookups : 0, cache.stale,
+              cache.inserts, cache.evictions, used, MIMECACHE_SLOTS,
+              (size_t)MIMECACHE_FILE_SIZE / 1024);
+}
@@ -0,0 +1,367 @@
+// // // // // //
+//             //
+//   LITE FM   //
+//             //
+// // // // // //
+
+/* BY nots1dd */
+
+#define _GNU_SOURCE
+
+#include "../include/mimepool.h"
+#include "../include/entrymime.h"
+#include "../include/logging.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/* A directory the queued names are relative to, shared by the pool and busy workers */
+struct MimePoolDir
+{
+  int fd;
+  int refs;
+};
+
+typedef struct
+{
+  MimePool* pool;
+  int       index;
+} MimePoolWorker;
+
+/* Called with the pool locked */
+static void mimepool_dir_release(MimePoolDir* dir)
+{
+  if (--dir->refs > 0)
+    return;
+  close(dir->fd);
+  free(dir);
+}
+
+/* Called with the pool locked. Can only fail with the counter about to overflow. */
+static void mimepool_notify(MimePool* pool)
+{
+  if (pool->notify_fd == -1)
+    return;
+  uint64_t one = 1;
+  ssize_t  rc  = write(pool->notify_fd, &one, sizeof(one));
+  (void)rc;
+}
+
+/* Called with the pool locked, hands over what one batch came up with */
+static void mimepool_post(MimePool* pool, const MimePoolJob* jobs, size_t count,
+                          char (*types)[MIMETYPE_MAX])
+{
+  for (size_t i = 0; i < count; i++)
+  {
+    // Full only if the UI has not collected for a while, the entry is asked for again then
+    if (pool->result_count == MIMEPOOL_QUEUE)
+      break;
+    MimePoolResult* result = &pool->results[pool->result_count++];
+    result->slot           = jobs[i].slot;
+    result->record         = jobs[i].record;
+    memcpy(result->type, types[i], MIMETYPE_MAX);
+  }
+  mimepool_notify(pool);
+}
+
+static void* mimepool_thread(void* arg)
+{
+  MimePoolWorker worker = *(MimePoolWorker*)arg;
+  MimePool*      pool   = worker.pool;
+  free(arg);
+
+  MimeClassifier classifier;
+  mimetype_classifier_init(&classifier);
+
+  MimePoolJob jobs[MIMETYPE_BATCH];
+  const char* names[MIMETYPE_BATCH] = {NULL};
+  char        types[MIMETYPE_BATCH][MIMETYPE_MAX];
+
+  pthread_mutex_lock(&pool->lock);
+  while (1)
+  {
+    while (!pool->stopping && pool->queued == 0)
+      pthread_cond_wait(&pool->work, &pool->lock);
+    if (pool->stopping)
+      break;
+
+    // The front of the queue is what the UI wants first
+    size_t count = pool->queued < MIMETYPE_BATCH ? pool->queued : MIMETYPE_BATCH;
+    memcpy(jobs, pool->queue, count * sizeof(MimePoolJob));
+    pool->queued -= count;
+    memmove(pool->queue, pool->queue + count, pool->queued * sizeof(MimePoolJob));
+    for (size_t i = 0; i < count; i++)
+      pool->busy[worker.index][i] = jobs[i].slot;
+    pool->busy_count[worker.index]      = count;
+    pool->busy_generation[worker.index] = pool->generation;
+    unsigned     generation             = pool->generation;
+    MimePoolDir* dir                    = pool->dir;
+    dir->refs++;
+    pthread_mutex_unlock(&pool->lock);
+
+    for (size_t i = 0; i < count; i++)
+      names[i] = jobs[i].name;
+    mimetype_classify_into(&classifier, dir->fd, names, count, types);
+
+    pthread_mutex_lock(&pool->lock);
+    pool->busy_count[worker.index] = 0;
+    mimepool_dir_release(dir);
+    if (generation == pool->generation)
+      mimepool_post(pool, jobs, count, types);
+    else
+      pool->discarded += count;
+  }
+
+  char who[32];
+  snprintf(who, sizeof(who), "worker %d", worker.index);
+  mimetype_classifier_log_stats(&classifier, who);
+  mimetype_classifier_free(&classifier);
+  pool->workers--;
+  pthread_cond_broadcast(&pool->gone);
+  pthread_mutex_unlock(&pool->lock);
+  return NULL;
+}
+
+/*
+ * @MIMEPOOL_INIT
+ *
+ * Starts the workers. `notify_fd` (an eventfd, or -1) is bumped whenever
+ * there is something to collect. Returns the number of workers that could
+ * be started, 0 if none (everything stays on the UI thread then).
+ */
+int mimepool_init(MimePool* pool, int notify_fd)
+{
+  memset(pool, 0, sizeof(*pool));
+  pthread_mutex_init(&pool->lock, NULL);
+  pthread_cond_init(&pool->work, NULL);
+  pthread_cond_init(&pool->gone, NULL);
+  pool->notify_fd = notify_fd;
+  pool->direction = 1;
+
+  pthread_attr_t attr;
+  pthread_attr_init(&attr);
+  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+  for (int i = 0; i < MIMEPOOL_WORKERS; i++)
+  {
+    MimePoolWorker* worker = malloc(sizeof(MimePoolWorker));
+    if (worker == NULL)
+      break;
+    worker->pool  = pool;
+    worker->index = i;
+
+    pthread_t thread;
+    pthread_mutex_lock(&pool->lock);
+    int rc = pthread_create(&thread, &attr, mimepool_thread, worker);
+    if (rc == 0)
+      pool->workers++;
+    pthread_mutex_unlock(&pool->lock);
+    if (rc != 0)
+    {
+      log_message(LOG_LEVEL_ERROR, " [MIMEPOOL] Unable to start worker: %s", strerror(rc));
+      free(worker);
+      break;
+    }
+  }
+  pthread_attr_destroy(&attr);
+  return pool->workers;
+}
+
+int mimepool_running(const MimePool* pool) { return pool->workers > 0 && !pool->stopping; }
+
+/* Called with the pool locked: a worker is on it, or its type is waiting to be collected */
+static int mimepool_in_flight(const MimePool* pool, uint32_t slot)
+{
+  for (int w = 0; w < MIMEPOOL_WORKERS; w++)
+  {
+    if (pool->busy_generation[w] != pool->generation)
+      continue;
+    for (size_t i = 0; i < pool->busy_count[w]; i++)
+    {
+      if (pool->busy[w][i] == slot)
+        return 1;
+    }
+  }
+  for (size_t i = 0; i < pool->result_count; i++)
+  {
+    if (pool->results[i].slot == slot)
+      return 1;
+  }
+  return 0;
+}
+
+/* Called with the pool locked, queues `row` unless there is nothing to do for it */
+static void mimepool_queue_row(MimePool* pool, const EntryStore* store, int row)
+{
+  if (row < 0 || row >= entry_store_rows(store) || pool->queued == MIMEPOOL_QUEUE)
+    return;
+  size_t           record = entry_store_record(store, row);
+  const EntryMeta* meta   = entry_store_record_meta(store, record);
+  if (meta == NULL || meta->mime != 0)
+    return;
+
+  uint32_t slot = store->records[record].meta;
+  if (mimepool_in_flight(pool, slot))
+    return;
+  MimePoolJob* job = &pool->queue[pool->queued++];
+  job->slot        = slot;
+  job->record      = (uint32_t)record;
+  snprintf(job->name, sizeof(job->name), "%s", entry_store_name(store, row));
+  pool->requested++;
+}
+
+/*
+ * @MIMEPOOL_REQUEST
+ *
+ * UI thread only. Asks for the types of `highlight` and the viewport rows
+ * [first, last] that have none yet, then of MIMEPOOL_LOOKAHEAD rows past
+ * the viewport in the direction it last moved. Replaces whatever was queued
+ * before. `dir_fd` is the listed directory, it is dup'ed on the first
+ * request after a cancel.
+ */
+void mimepool_request(MimePool* pool, const EntryStore* store, int dir_fd, int highlight,
+                      int first, int last)
+{
+  if (!mimepool_running(pool) || dir_fd == -1)
+    return;
+
+  pthread_mutex_lock(&pool->lock);
+  if (pool->dir == NULL)
+  {
+    MimePoolDir* dir = malloc(sizeof(MimePoolDir));
+    if (dir == NULL || (dir->fd = fcntl(dir_fd, F_DUPFD_CLOEXEC, 0)) == -1)
+    {
+      log_message(LOG_LEVEL_ERROR, " [MIMEPOOL] Unable to dup the directory fd: %s",
+                  strerror(errno));
+      free(dir);
+      pthread_mutex_unlock(&pool->lock);
+      return;
+    }
+    dir->refs = 1;
+    pool->dir = dir;
+  }
+
+  if (first != pool->last_first)
+    pool->direction = first > pool->last_first ? 1 : -1;
+  pool->last_first = first;
+
+  pool->queued = 0;
+  mimepool_queue_row(pool, store, highlight);
+  for (int row = first; row <= last; row++)
+  {
+    if (row != highlight)
+      mimepool_queue_row(pool, store, row);
+  }
+  for (int i = 1; i <= MIMEPOOL_LOOKAHEAD; i++)
+    mimepool_queue_row(pool, store, pool->direction > 0 ? last + i : first - i);
+
+  if (pool->queued > 0)
+    pthread_cond_broadcast(&pool->work);
+  pthread_mutex_unlock(&pool->lock);
+}
+
+/* Record that owns metadata slot `slot`, store->count if none does any more */
+static size_t mimepool_find_record(const EntryStore* store, const MimePoolResult* result)
+{
+  if (result->record < store->count && store->records[result->record].meta == result->slot)
+    return result->record;
+  // The listing was sorted, or dirs streamed in, since it was asked for
+  for (size_t i = 0; i < store->count; i++)
+  {
+    if (store->records[i].meta == result->slot)
+      return i;
+  }
+  return store->count;
+}
+
+/*
+ * @MIMEPOOL_COLLECT
+ *
+ * UI thread only. Keeps every type the workers came up with since the last
+ * call in `store` (see entry_mime_keep). Returns how many entries got
+ * one, the rows showing them need a redraw.
+ */
+int mimepool_collect(MimePool* pool, EntryStore* store)
+{
+  int collected = 0;
+  pthread_mutex_lock(&pool->lock);
+  for (size_t i = 0; i < pool->result_count; i++)
+  {
+    size_t record = mimepool_find_record(store, &pool->results[i]);
+    if (record < store->count && entry_mime_keep(store, record, pool->results[i].type) == 0)
+      collected++;
+  }
+  pool->result_count = 0;
+  pool->collected += (unsigned long)collected;
+  pthread_mutex_unlock(&pool->lock);
+  return collected;
+}
+
+/*
+ * @MIMEPOOL_CANCEL
+ *
+ * UI thread only, when the listing the metadata slots belong to is thrown
+ * away. Never waits for the workers.
+ */
+void mimepool_cancel(MimePool* pool)
+{
+  pthread_mutex_lock(&pool->lock);
+  pool->generation++;
+  pool->queued       = 0;
+  pool->result_count = 0;
+  pool->last_first   = 0;
+  pool->direction    = 1;
+  if (pool->dir != NULL)
+    mimepool_dir_release(pool->dir);
+  pool->dir = NULL;
+  pthread_mutex_unlock(&pool->lock);
+}
+
+void mimepool_log_stats(MimePool* pool)
+{
+  pthread_mutex_lock(&pool->lock);
+  log_message(LOG_LEVEL_DEBUG,
+              " [MIMEPOOL] workers: %d, entries queued: %lu, collected: %lu, discarded: %lu",
+              pool->workers, pool->requested, pool->collected, pool->discarded);
+  pthread_mutex_unlock(&pool->lock);
+}
+
+/*
+ * @MIMEPOOL_FREE
+ *
+ * Tells the workers to stop and waits up to MIMEPOOL_STOP_MS for them.
+ * Returns 0 once they are all gone, -1 if one is still stuck (the pool and
+ * the MIME type state must then be left as they are).
+ */
+int mimepool_free(MimePool* pool)
+{
+  mimepool_cancel(pool);
+
+  struct timespec deadline;
+  clock_gettime(CLOCK_REALTIME, &deadline);
+  deadline.tv_nsec += (long)MIMEPOOL_STOP_MS * 1000000L;
+  deadline.tv_sec += deadline.tv_nsec / 1000000000L;
+  deadline.tv_nsec %= 1000000000L;
+
+  pthread_mutex_lock(&pool->lock);
+  pool->stopping = 1;
+  pthread_cond_broadcast(&pool->work);
+  while (pool->workers > 0)
+  {
+    if (pthread_cond_timedwait(&pool->gone, &pool->lock, &deadline) == ETIMEDOUT)
+      break;
+  }
+  int left = pool->workers;
+  pthread_mutex_unlock(&pool->lock);
+
+  if (left > 0)
+  {
+    log_message(LOG_LEVEL_ERROR, " [MIMEPOOL] %d worker(s) still busy, leaving them behind", left);
+    return -1;
+  }
+  return 0;
+}
@@ -0,0 +1,421 @@
+// // // // // //
+//             //
+//   LITE FM   //
+//             //
+// // // // // //
+
+/* BY nots1dd */
+
+#define _GNU_SOURCE
+
+#include "../include/mimetype.h"
+#include "../include/filecoproc.h"
+#include "../include/logging.h"
+#include "../include/mimecache.h"
+#include "../include/sniff.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#ifdef LITEFM_HAVE_LIBMAGIC
+#include <magic.h>
+#endif
+
+typedef char mimetype_max_is_a_coproc_answer[MIMETYPE_MAX == FILECOPROC_ANSWER_MAX ? 1 : -1];
+
+/* The UI thread's, behind mimetype_at and friends */
+static MimeClassifier ui;
+
+static char mime_type[MIMETYPE_MAX];
+
+/* Distinct MIME types seen this session, id i + 1 is interned[i] */
+static char*  interned[MIMETYPE_INTERN_MAX];
+static size_t interned_count;
+
+/*
+ * @MIMETYPE_CLASSIFIER_INIT
+ *
+ * Sets up a classifier for the calling thread: loads the magic database
+ * into a cookie of its own. Returns 0, or -1 if it falls back to running
+ * `file` (no libmagic in this build, or no usable database).
+ */
+int mimetype_classifier_init(MimeClassifier* classifier)
+{
+  memset(classifier, 0, sizeof(*classifier));
+  filecoproc_init(&classifier->coproc);
+#ifdef LITEFM_HAVE_LIBMAGIC
+  magic_t cookie = magic_open(MAGIC_MIME_TYPE | MAGIC_ERROR);
+  if (cookie == NULL)
+  {
+    log_message(LOG_LEVEL_ERROR, " [MIMETYPE] magic_open failed: %s", strerror(errno));
+    return -1;
+  }
+  if (magic_load(cookie, NULL) != 0)
+  {
+    log_message(LOG_LEVEL_ERROR, " [MIMETYPE] Unable to load the magic database (%s), using `file`",
+                magic_error(cookie));
+    magic_close(cookie);
+    return -1;
+  }
+  classifier->magic = cookie;
+  return 0;
+#else
+  return -1;
+#endif
+}
+
+void mimetype_classifier_free(MimeClassifier* classifier)
+{
+  filecoproc_stop(&classifier->coproc);
+#ifdef LITEFM_HAVE_LIBMAGIC
+  if (classifier->magic != NULL)
+    magic_close((magic_t)classifier->magic);
+#endif
+  classifier->magic = NULL;
+}
+
+/* `who` tells the classifiers of different threads apart in the log */
+void mimetype_classifier_log_stats(const MimeClassifier* classifier, const char* who)
+{
+  log_message(LOG_LEVEL_DEBUG, " [MIMETYPE] %s: classifications: %lu, sniffed: %lu, left to %s: %lu",
+              who, classifier->classified, classifier->sniffed,
+              classifier->magic != NULL ? "libmagic" : "`file`", classifier->leftovers);
+  if (classifier->magic == NULL)
+    filecoproc_log_stats(&classifier->coproc, who);
+}
+
+/*
+ * @MIMETYPE_INIT
+ *
+ * Maps the persistent cache and sets up the UI thread's classifier, once.
+ * Returns 0, or -1 if we fall back to running `file`.
+ */
+int mimetype_init(void)
+{
+  mimecache_init();
+  if (ui.magic != NULL)
+    return 0;
+  if (mimetype_classifier_init(&ui) == -1)
+  {
+#ifndef LITEFM_HAVE_LIBMAGIC
+    log_message(LOG_LEVEL_DEBUG, " [MIMETYPE] Built without libmagic, using `file`");
+#endif
+    return -1;
+  }
+#ifdef LITEFM_HAVE_LIBMAGIC
+  log_message(LOG_LEVEL_DEBUG, " [MIMETYPE] libmagic %d loaded", magic_version());
+#endif
+  return 0;
+}
+
+/* `keys` is how many keys were pressed this session, for the per key rate */
+void mimetype_log_stats(unsigned long keys)
+{
+  log_message(LOG_LEVEL_DEBUG, " [MIMETYPE] classifications: %lu over %lu keys (%.2f per key)",
+              ui.classified, keys, keys ? (double)ui.classified / (double)keys : 0.0);
+  mimetype_classifier_log_stats(&ui, "ui");
+  mimecache_log_stats();
+}
+
+void mimetype_free(void)
+{
+  mimecache_free();
+  mimetype_classifier_free(&ui);
+  for (size_t i = 0; i < interned_count; i++)
+    free(interned[i]);
+  interned_count = 0;
+}
+
+/* `file --brief --mime-type -` with `fd` as its stdin, the answer goes to `type` */
+static void run_file_on_fd(int fd, char* type)
+{
+  int pipefd[2];
+  snprintf(type, MIMETYPE_MAX, "Error");
+  if (pipe2(pipefd, O_CLOEXEC) == -1)
+    return;
+
+  pid_t pid = fork();
+  if (pid == -1)
+  {
+    close(pipefd[0]);
+    close(pipefd[1]);
+    return;
+  }
+  if (pid == 0)
+  {
+    int null_fd = open("/dev/null", O_WRONLY);
+    dup2(fd, STDIN_FILENO);
+    dup2(pipefd[1], STDOUT_FILENO);
+    if (null_fd != -1)
+      dup2(null_fd, STDERR_FILENO);
+    execlp("file", "file", "--brief", "--mime-type", "-", (char*)NULL);
+    _exit(127);
+  }
+
+  close(pipefd[1]);
+  size_t  len = 0;
+  ssize_t n;
+  while (len < MIMETYPE_MAX - 1 &&
+         ((n = read(pipefd[0], type + len, MIMETYPE_MAX - 1 - len)) > 0 ||
+          (n == -1 && errno == EINTR)))
+  {
+    if (n > 0)
+      len += (size_t)n;
+  }
+  close(pipefd[0]);
+  while (waitpid(pid, NULL, 0) == -1 && errno == EINTR)
+    ;
+
+  type[len]                   = '\0';
+  type[strcspn(type, "\n")] = '\0';
+  if (!filecoproc_is_mime_type(type))
+  {
+    if (type[0] != '\0')
+      log_message(LOG_LEVEL_DEBUG, " [MIMETYPE] `file` said: %s", type);
+    snprintf(type, MIMETYPE_MAX, "Unknown");
+  }
+}
+
+static const char* set_mime_type(const char* type)
+{
+  snprintf(mime_type, sizeof(mime_type), "%s", type);
+  return mime_type;
+}
+
+/* A copy of `type` that lasts the session */
+static const char* session_type(const char* type)
+{
+  if (strcmp(type, "Error") == 0)
+    return "Error";
+  uint16_t id = type[0] != '\0' ? mimetype_intern(type) : 0;
+  return id != 0 ? mimetype_name(id) : "Unknown";
+}
+
+/*
+ * The leftovers: `count` open files the signature table was not sure about.
+ * Without libmagic they go to the `file` coprocess, a batch per round trip,
+ * and only what it could not answer (or answered with something that is not
+ * a MIME type) gets a `file` run of its own.
+ */
+static void classify_leftovers(MimeClassifier* classifier, const int* fds, size_t count,
+                               char (*types)[MIMETYPE_MAX])
+{
+  classifier->leftovers += count;
+#ifdef LITEFM_HAVE_LIBMAGIC
+  if (classifier->magic != NULL)
+  {
+    for (size_t i = 0; i < count; i++)
+    {
+      const char* type = magic_descriptor((magic_t)classifier->magic, fds[i]);
+      if (type == NULL)
+        log_message(LOG_LEVEL_DEBUG, " [MIMETYPE] magic_descriptor: %s",
+                    magic_error((magic_t)classifier->magic));
+      snprintf(types[i], MIMETYPE_MAX, "%s",
+               type != NULL && filecoproc_is_mime_type(type) ? type : "Unknown");
+    }
+    return;
+  }
+#endif
+
+  size_t done  = 0;
+  int    tries = 0;
+  while (done < count && tries < 2)
+  {
+    size_t batch = count - done < FILECOPROC_BATCH ? count - done : FILECOPROC_BATCH;
+    size_t got   = filecoproc_classify(&classifier->coproc, fds + done, batch, types + done);
+    tries        = got == 0 ? tries + 1 : 0; // It restarts on the next call, once
+    done += got;
+  }
+  for (size_t i = 0; i < count; i++)
+    if (i >= done || types[i][0] == '\0')
+      run_file_on_fd(fds[i], types[i]);
+}
+
+/* What the signature table says about the head of `fd`, NULL if it is not sure */
+static const char* sniff_fd(MimeClassifier* classifier, int fd, const char* name)
+{
+  unsigned char head[SNIFF_BYTES];
+  ssize_t       n = pread(fd, head, sizeof(head), 0);
+  if (n <= 0)
+    return NULL;
+  const char* type = sniff_mime(head, (size_t)n, name);
+  if (type != NULL)
+    classifier->sniffed++;
+  return type;
+}
+
+/* MIME type of the file behind `fd`, one we just opened */
+const char* mimetype_of_fd(int fd)
+{
+  ui.classified++;
+  const char* type = sniff_fd(&ui, fd, NULL);
+  if (type != NULL)
+    return set_mime_type(type);
+  classify_leftovers(&ui, &fd, 1, &mime_type);
+  return mime_type;
+}
+
+/*
+ * @MIMETYPE_INTERN
+ *
+ * A small id for `type` that stays the same for the whole session, for
+ * keeping MIME types per entry. Returns 0 if the table is full.
+ */
+uint16_t mimetype_intern(const char* type)
+{
+  for (size_t i = 0; i < interned_count; i++)
+  {
+    if (strcmp(interned[i], type) == 0)
+      return (uint16_t)(i + 1);
+  }
+  if (interned_count == MIMETYPE_INTERN_MAX)
+    return 0;
+  char* copy = strdup(type);
+  if (copy == NULL)
+    return 0;
+  interned[interned_count++] = copy;
+  return (uint16_t)interned_count;
+}
+
+/* The MIME type behind an id from mimetype_intern */
+const char* mimetype_name(uint16_t id)
+{
+  if (id == 0 || id > interned_count)
+    return "Unknown";
+  return interned[id - 1];
+}
+
+/* What `file` calls anything that is not a non empty regular file */
+static const char* inode_type(const struct stat* st)
+{
+  if (S_ISLNK(st->st_mode))
+    return "inode/symlink";
+  if (S_ISDIR(st->st_mode))
+    return "inode/directory";
+  if (S_ISCHR(st->st_mode))
+    return "inode/chardevice";
+  if (S_ISBLK(st->st_mode))
+    return "inode/blockdevice";
+  if (S_ISFIFO(st->st_mode))
+    return "inode/fifo";
+  if (S_ISSOCK(st->st_mode))
+    return "inode/socket";
+  if (st->st_size == 0)
+    return "inode/x-empty";
+  return NULL;
+}
+
+/* Leftovers of a batch, still open, that go out together */
+typedef struct
+{
+  int         fds[MIMETYPE_BATCH];
+  size_t      slots[MIMETYPE_BATCH]; /* where in `types` each answer goes */
+  struct stat stats[MIMETYPE_BATCH];
+  size_t      count;
+} Pending;
+
+static void classify_pending(MimeClassifier* classifier, Pending* pending,
+                             char (*types)[MIMETYPE_MAX])
+{
+  char answers[MIMETYPE_BATCH][MIMETYPE_MAX];
+  classify_leftovers(classifier, pending->fds, pending->count, answers);
+  for (size_t i = 0; i < pending->count; i++)
+  {
+    memcpy(types[pending->slots[i]], answers[i], MIMETYPE_MAX);
+    if (filecoproc_is_mime_type(answers[i]))
+      mimecache_insert(&pending->stats[i], answers[i]);
+    close(pending->fds[i]);
+  }
+  pending->count = 0;
+}
+
+/*
+ * @MIMETYPE_CLASSIFY_INTO
+ *
+ * MIME types of `count` entries of `dir_fd` at once, with the calling
+ * thread's own classifier. What the persistent cache and the signature
+ * table cannot answer is collected and goes to libmagic or the `file`
+ * coprocess together, one round trip per MIMETYPE_BATCH files. `types[i]`
+ * gets a copy of the answer ("Unknown" for what cannot be opened, "Error"
+ * if `file` could not run).
+ */
+void mimetype_classify_into(MimeClassifier* classifier, int dir_fd, const char* const* names,
+                            size_t count, char (*types)[MIMETYPE_MAX])
+{
+  Pending pending;
+  pending.count = 0;
+
+  for (size_t i = 0; i < count; i++)
+  {
+    classifier->classified++;
+    snprintf(types[i], MIMETYPE_MAX, "Unknown");
+    struct stat st;
+    if (fstatat(dir_fd, names[i], &st, AT_SYMLINK_NOFOLLOW) == -1)
+      continue;
+
+    const char* type = inode_type(&st);
+    if (type != NULL)
+    {
+      snprintf(types[i], MIMETYPE_MAX, "%s", type);
+      continue;
+    }
+    if (mimecache_lookup(&st, types[i], MIMETYPE_MAX))
+      continue;
+
+    int fd = openat(dir_fd, names[i], O_RDONLY | O_NOCTTY | O_NOFOLLOW | O_CLOEXEC);
+    if (fd == -1)
+      continue;
+    type = sniff_fd(classifier, fd, names[i]);
+    if (type != NULL)
+    {
+      snprintf(types[i], MIMETYPE_MAX, "%s", type);
+      mimecache_insert(&st, type);
+      close(fd);
+      continue;
+    }
+
+    pending.fds[pending.count]   = fd;
+    pending.slots[pending.count] = i;
+    pending.stats[pending.count] = st;
+    if (++pending.count == MIMETYPE_BATCH)
+      classify_pending(classifier, &pending, types);
+  }
+  if (pending.count > 0)
+    classify_pending(classifier, &pending, types);
+}
+
+/*
+ * @MIMETYPE_CLASSIFY_AT
+ *
+ * mimetype_classify_into with the UI thread's classifier. `types` gets
+ * strings that last the session.
+ */
+void mimetype_classify_at(int dir_fd, const char* const* names, size_t count, const char** types)
+{
+  char answers[MIMETYPE_BATCH][MIMETYPE_MAX];
+  for (size_t done = 0; done < count; done += MIMETYPE_BATCH)
+  {
+    size_t batch = count - done < MIMETYPE_BATCH ? count - done : MIMETYPE_BATCH;
+    mimetype_classify_into(&ui, dir_fd, names + done, batch, answers);
+    for (size_t i = 0; i < batch; i++)
+      types[done + i] = session_type(answers[i]);
+  }
+}
+
+/*
+ * @MIMETYPE_AT
+ *
+ * MIME type of `name` relative to `dir_fd` (AT_FDCWD, or a path of its
+ * own). "Unknown" if it cannot be opened.
+ */
+const char* mimetype_at(int dir_fd, const char* name)
+{
+  mimetype_classify_into(&ui, dir_fd, &name, 1, &mime_type);
+  return mime_type;
+}
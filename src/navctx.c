@@ -0,0 +1,268 @@
+// // // // // //
+//             //
+//   LITE FM   //
+//             //
+// // // // // //
+
+/* BY nots1dd */
+
+#define _GNU_SOURCE
+
+#include "../include/navctx.h"
+#include "../include/logging.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define NAVCTX_OPEN_FLAGS (O_PATH | O_DIRECTORY | O_CLOEXEC)
+#define NAVCTX_MIN_FDS    16
+
+void navctx_init(NavContext* nav) { memset(nav, 0, sizeof(*nav)); }
+
+void navctx_free(NavContext* nav)
+{
+  for (size_t i = 0; i < nav->depth; i++)
+    close(nav->fds[i]);
+  free(nav->fds);
+  navctx_init(nav);
+}
+
+static int navctx_reserve(NavContext* nav, size_t depth)
+{
+  if (depth <= nav->capacity)
+    return 0;
+
+  size_t capacity = nav->capacity ? nav->capacity * 2 : NAVCTX_MIN_FDS;
+  while (capacity < depth)
+    capacity *= 2;
+  int* fds = realloc(nav->fds, capacity * sizeof(int));
+  if (fds == NULL)
+    return -1;
+  nav->fds      = fds;
+  nav->capacity = capacity;
+  return 0;
+}
+
+/*
+ * Makes `path` absolute (relative to the cwd) and drops empty, "." and ".."
+ * components lexically, the way the shell treats `cd ..`. `out` ends up as
+ * "/" or "/a/b" without a trailing slash.
+ */
+static int navctx_normalize(const char* path, char* out, size_t size)
+{
+  char absolute[PATH_MAX];
+  if (path[0] == '/')
+  {
+    if (snprintf(absolute, sizeof(absolute), "%s", path) >= (int)sizeof(absolute))
+      goto too_long;
+  }
+  else
+  {
+    char cwd[PATH_MAX];
+    if (getcwd(cwd, sizeof(cwd)) == NULL)
+      return -1;
+    if (snprintf(absolute, sizeof(absolute), "%s/%s", cwd, path) >= (int)sizeof(absolute))
+      goto too_long;
+  }
+
+  size_t      len = 0;
+  const char* p   = absolute;
+  while (*p)
+  {
+    while (*p == '/')
+      p++;
+    const char* start = p;
+    while (*p && *p != '/')
+      p++;
+    size_t n = (size_t)(p - start);
+
+    if (n == 0 || (n == 1 && start[0] == '.'))
+      continue;
+    if (n == 2 && start[0] == '.' && start[1] == '.')
+    {
+      while (len > 0 && out[len - 1] != '/')
+        len--;
+      if (len > 0)
+        len--;
+      continue;
+    }
+    if (len + 1 + n >= size)
+      goto too_long;
+    out[len++] = '/';
+    memcpy(out + len, start, n);
+    len += n;
+  }
+
+  if (len == 0)
+    out[len++] = '/';
+  out[len] = '\0';
+  return 0;
+
+too_long:
+  errno = ENAMETOOLONG;
+  return -1;
+}
+
+/* Number of leading components two normalized paths have in common */
+static size_t navctx_common(const char* a, const char* b)
+{
+  size_t shared = 0;
+  for (;;)
+  {
+    while (*a == '/')
+      a++;
+    while (*b == '/')
+      b++;
+    size_t na = strcspn(a, "/");
+    size_t nb = strcspn(b, "/");
+    if (na == 0 || na != nb || memcmp(a, b, na) != 0)
+      return shared;
+    shared++;
+    a += na;
+    b += nb;
+  }
+}
+
+/*
+ * @NAVCTX_OPEN
+ *
+ * Makes `path` the current directory. Only the components that differ from
+ * the current path are opened, so going to an ancestor costs no syscalls at
+ * all. On failure (errno is set) the context is left as it was.
+ */
+int navctx_open(NavContext* nav, const char* path)
+{
+  char target[PATH_MAX];
+  if (navctx_normalize(path, target, sizeof(target)) == -1)
+    return -1;
+
+  size_t components = 0;
+  for (const char* p = target; *p; p++)
+    components += *p == '/';
+  if (target[1] == '\0')
+    components = 0;
+
+  size_t keep = nav->depth ? 1 + navctx_common(nav->path, target) : 0;
+  if (keep > nav->depth)
+    keep = nav->depth;
+
+  size_t capacity = components + 1 > NAVCTX_MIN_FDS ? components + 1 : NAVCTX_MIN_FDS;
+  int*   fds      = malloc(capacity * sizeof(int));
+  if (fds == NULL)
+    return -1;
+  if (keep > 0)
+    memcpy(fds, nav->fds, keep * sizeof(int));
+
+  int    saved;
+  size_t depth = keep;
+  if (depth == 0)
+  {
+    fds[0] = open("/", NAVCTX_OPEN_FLAGS);
+    if (fds[0] == -1)
+      goto fail;
+    depth = 1;
+  }
+
+  // fds[i] is the directory of the i-th component, skip the ones we kept
+  const char* p = target;
+  for (size_t i = 1; i <= components; i++)
+  {
+    p++; // the '/' in front of the component
+    size_t n = strcspn(p, "/");
+    if (i >= depth)
+    {
+      char name[NAME_MAX + 1];
+      if (n > NAME_MAX)
+      {
+        errno = ENAMETOOLONG;
+        goto fail;
+      }
+      memcpy(name, p, n);
+      name[n] = '\0';
+
+      fds[depth] = openat(fds[depth - 1], name, NAVCTX_OPEN_FLAGS);
+      if (fds[depth] == -1)
+        goto fail;
+      depth++;
+    }
+    p += n;
+  }
+
+  for (size_t i = keep; i < nav->depth; i++)
+    close(nav->fds[i]);
+  free(nav->fds);
+  nav->fds      = fds;
+  nav->depth    = depth;
+  nav->capacity = capacity;
+  memcpy(nav->path, target, strlen(target) + 1);
+  return 0;
+
+fail:
+  saved = errno;
+  for (size_t i = keep; i < depth; i++)
+    close(fds[i]);
+  free(fds);
+  log_message(LOG_LEVEL_DEBUG, " [NAVCTX] Unable to open %s: %s", target, strerror(saved));
+  errno = saved;
+  return -1;
+}
+
+/*
+ * @NAVCTX_ENTER
+ *
+ * Descends into `name`, an entry of the current directory (symlinks to
+ * directories are followed). One openat, no matter how deep we are.
+ */
+int navctx_enter(NavContext* nav, const char* name)
+{
+  if (nav->depth == 0 || name[0] == '\0' || strchr(name, '/') != NULL ||
+      strcmp(name, ".") == 0 || strcmp(name, "..") == 0)
+  {
+    errno = EINVAL;
+    return -1;
+  }
+
+  size_t len = nav->depth > 1 ? strlen(nav->path) : 0; // "/" has no component
+  size_t n   = strlen(name);
+  if (len + 1 + n >= sizeof(nav->path))
+  {
+    errno = ENAMETOOLONG;
+    return -1;
+  }
+  if (navctx_reserve(nav, nav->depth + 1) == -1)
+    return -1;
+
+  int fd = openat(navctx_fd(nav), name, NAVCTX_OPEN_FLAGS);
+  if (fd == -1)
+    return -1;
+
+  nav->fds[nav->depth++] = fd;
+  nav->path[len]         = '/';
+  memcpy(nav->path + len + 1, name, n + 1);
+  return 0;
+}
+
+/* Goes to the parent directory. Returns -1 if we already are at "/". */
+int navctx_leave(NavContext* nav)
+{
+  if (nav->depth <= 1)
+    return -1;
+
+  close(nav->fds[--nav->depth]);
+  char* slash = strrchr(nav->path, '/');
+  if (slash == nav->path)
+    slash++;
+  *slash = '\0';
+  return 0;
+}
+
+/* The current directory, for the *at() family */
+int navctx_fd(const NavContext* nav) { return nav->depth ? nav->fds[nav->depth - 1] : AT_FDCWD; }
+
+/* A second reference to the current directory that stays valid after navigating away */
+int navctx_dup(const NavContext* nav) { return fcntl(navctx_fd(nav), F_DUPFD_CLOEXEC, 0); }
+
+const char* navctx_path(const NavContext* nav) { return nav->path; }
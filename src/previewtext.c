@@ -0,0 +1,117 @@
+// // // // // //
+//             //
+//   LITE FM   //
+//             //
+// // // // // //
+
+/* BY nots1dd */
+
+#define _GNU_SOURCE
+
+#include "../include/previewtext.h"
+#include "../include/logging.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static struct
+{
+  char*         buf; /* PREVIEWTEXT_MAX_BYTES + 1, allocated on first use */
+  unsigned long files;
+  unsigned long reads;  /* preads */
+  unsigned long bytes;  /* read by them */
+  unsigned long filled; /* had all the lines the pane can show */
+  unsigned long capped; /* stopped at `max_bytes` */
+} preview;
+
+/*
+ * @PREVIEWTEXT_READ
+ *
+ * Reads the first `max_lines` lines of `fd`, but no more than `max_bytes`
+ * (capped at PREVIEWTEXT_MAX_BYTES), into `view`. Returns 0, or -1 if
+ * nothing could be read at all; `view` holds what was read either way, the
+ * empty string if nothing.
+ */
+int previewtext_read(PreviewText* view, int fd, size_t max_lines, size_t max_bytes)
+{
+  view->text  = "";
+  view->len   = 0;
+  view->lines = 0;
+  if (preview.buf == NULL && (preview.buf = malloc(PREVIEWTEXT_MAX_BYTES + 1)) == NULL)
+  {
+    log_message(LOG_LEVEL_ERROR, " [PREVIEW] Unable to allocate the preview buffer");
+    return -1;
+  }
+  preview.files++;
+  if (max_bytes > PREVIEWTEXT_MAX_BYTES)
+    max_bytes = PREVIEWTEXT_MAX_BYTES;
+
+  size_t len    = 0; /* read so far */
+  size_t cut    = 0; /* just past the last complete line */
+  int    status = 0;
+  while (view->lines < max_lines && len < max_bytes)
+  {
+    size_t want = max_bytes - len;
+    if (want > PREVIEWTEXT_CHUNK)
+      want = PREVIEWTEXT_CHUNK;
+    ssize_t got = pread(fd, preview.buf + len, want, (off_t)len);
+    if (got == -1 && errno == EINTR)
+      continue;
+    if (got == -1)
+    {
+      // A directory, or a FIFO nobody writes to (it was opened non blocking)
+      if (len == 0)
+        status = -1;
+      break;
+    }
+    preview.reads++;
+    if (got == 0)
+      break;
+    preview.bytes += (unsigned long)got;
+
+    // Only what just came in, there is no '\n' in [cut, len)
+    const char* scan = preview.buf + len;
+    const char* end  = scan + got;
+    const char* nl;
+    while (view->lines < max_lines && (nl = memchr(scan, '\n', (size_t)(end - scan))) != NULL)
+    {
+      view->lines++;
+      scan = nl + 1;
+      cut  = (size_t)(scan - preview.buf);
+    }
+    len += (size_t)got;
+  }
+
+  if (view->lines == max_lines)
+    preview.filled++;
+  else
+  {
+    if (len == max_bytes)
+      preview.capped++;
+    // The last line has no '\n' (end of file), or was cut at `max_bytes`
+    if (len > cut)
+      view->lines++;
+    cut = len;
+  }
+
+  preview.buf[cut] = '\0';
+  view->text       = preview.buf;
+  view->len        = cut;
+  return status;
+}
+
+void previewtext_free(void)
+{
+  free(preview.buf);
+  preview.buf = NULL;
+}
+
+void previewtext_log_stats(void)
+{
+  log_message(LOG_LEVEL_DEBUG,
+              " [PREVIEW] files: %lu, preads: %lu, bytes read: %lu, stopped at the pane "
+              "height: %lu, at the byte limit: %lu",
+              preview.files, preview.reads, preview.bytes, preview.filled, preview.capped);
+}
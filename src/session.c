@@ -0,0 +1,149 @@
+// // // // // //
+//             //
+//   LITE FM   //
+//             //
+// // // // // //
+
+/* BY nots1dd */
+
+#define _GNU_SOURCE
+
+#include "../include/session.h"
+#include "../include/logging.h"
+#include "../include/systeminfo.h"
+
+#include <fcntl.h>
+#include <pwd.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+/* What the status bar shows, two decimals */
+static long long as_drawn(double gib) { return (long long)(gib * 100.0); }
+
+static void* session_disk_thread(void* arg)
+{
+  Session* session = (Session*)arg;
+
+  pthread_mutex_lock(&session->lock);
+  for (;;)
+  {
+    while (session->request_fd == -1 && !session->stopping)
+      pthread_cond_wait(&session->wake, &session->lock);
+    if (session->stopping)
+      break;
+
+    int fd              = session->request_fd;
+    session->request_fd = -1;
+    pthread_mutex_unlock(&session->lock);
+
+    // The only call that may hang, and nobody waits on it
+    double free_gib, total_gib;
+    int    ok = system_space_fd(fd, &free_gib, &total_gib) == 0;
+    close(fd);
+
+    pthread_mutex_lock(&session->lock);
+    if (!ok)
+      continue;
+    if (!session->disk_valid || as_drawn(free_gib) != as_drawn(session->free_gib) ||
+        as_drawn(total_gib) != as_drawn(session->total_gib))
+    {
+      session->free_gib     = free_gib;
+      session->total_gib    = total_gib;
+      session->disk_valid   = 1;
+      session->disk_changed = 1;
+      if (!session->stopping && session->notify_fd != -1)
+      {
+        uint64_t one = 1;
+        ssize_t  rc  = write(session->notify_fd, &one, sizeof(one));
+        (void)rc;
+      }
+    }
+  }
+  pthread_mutex_unlock(&session->lock);
+  return NULL;
+}
+
+/* `notify_fd` is bumped when the disk usage changed, -1 if nobody listens */
+void session_init(Session* session, int notify_fd)
+{
+  memset(session, 0, sizeof(*session));
+  session->notify_fd  = notify_fd;
+  session->request_fd = -1;
+  pthread_mutex_init(&session->lock, NULL);
+  pthread_cond_init(&session->wake, NULL);
+
+  struct passwd* pw = getpwuid(getuid());
+  snprintf(session->user, sizeof(session->user), "%s", pw ? pw->pw_name : "?");
+  if (gethostname(session->hostname, sizeof(session->hostname)) != 0)
+    snprintf(session->hostname, sizeof(session->hostname), "?");
+  session->hostname[sizeof(session->hostname) - 1] = '\0';
+}
+
+void session_free(Session* session)
+{
+  pthread_mutex_lock(&session->lock);
+  session->stopping = 1;
+  if (session->request_fd != -1)
+    close(session->request_fd);
+  session->request_fd = -1;
+  pthread_cond_signal(&session->wake);
+  pthread_mutex_unlock(&session->lock);
+}
+
+/*
+ * @SESSION_REFRESH_DISK
+ *
+ * Asks the worker for the disk usage of the filesystem `dir_fd` is on. The
+ * fd is duplicated, the caller keeps its own. Returns right away.
+ */
+void session_refresh_disk(Session* session, int dir_fd)
+{
+  int fd = fcntl(dir_fd, F_DUPFD_CLOEXEC, 0);
+  if (fd == -1)
+    return;
+
+  pthread_mutex_lock(&session->lock);
+  if (session->request_fd != -1)
+    close(session->request_fd); // Still stuck on an older one, this one replaces it
+  session->request_fd = fd;
+
+  if (!session->worker_started)
+  {
+    pthread_attr_t attr;
+    pthread_t      thread;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    int rc = pthread_create(&thread, &attr, session_disk_thread, session);
+    pthread_attr_destroy(&attr);
+    if (rc == 0)
+      session->worker_started = 1;
+    else
+      log_message(LOG_LEVEL_ERROR, " [SESSION] Unable to start disk usage worker: %s",
+                  strerror(rc));
+  }
+  pthread_cond_signal(&session->wake);
+  pthread_mutex_unlock(&session->lock);
+}
+
+/* The last disk usage the worker got. Returns 0 if there is none yet. */
+int session_disk(Session* session, double* free_gib, double* total_gib)
+{
+  pthread_mutex_lock(&session->lock);
+  int valid  = session->disk_valid;
+  *free_gib  = session->free_gib;
+  *total_gib = session->total_gib;
+  pthread_mutex_unlock(&session->lock);
+  return valid;
+}
+
+/* 1 once after the disk usage changed, the status bar has to be redrawn */
+int session_disk_changed(Session* session)
+{
+  pthread_mutex_lock(&session->lock);
+  int changed           = session->disk_changed;
+  session->disk_changed = 0;
+  pthread_mutex_unlock(&session->lock);
+  return changed;
+}
@@ -0,0 +1,387 @@
+// // // // // //
+//             //
+//   LITE FM   //
+//             //
+// // // // // //
+
+/* BY nots1dd */
+
+#define _GNU_SOURCE
+
+#include "../include/sniff.h"
+#include "../include/exttable.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/* Second look for signatures that several formats share, NULL if unsure */
+typedef const char* (*SniffRefine)(const unsigned char* buf, size_t len);
+
+static uint16_t le16(const unsigned char* p) { return (uint16_t)(p[0] | p[1] << 8); }
+
+static uint32_t le32(const unsigned char* p)
+{
+  return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static int has_bytes(const unsigned char* buf, size_t len, size_t offset, const char* bytes,
+                     size_t n)
+{
+  return len >= offset + n && memcmp(buf + offset, bytes, n) == 0;
+}
+
+/*
+ * ELF: by e_type. A shared object is either a library or a PIE executable,
+ * `file` goes by DF_1_PIE in the dynamic section for that, which is not in
+ * the head. Only one without an interpreter is surely a library, and
+ * PT_INTERP has to come before the first PT_LOAD.
+ */
+static const char* sniff_elf(const unsigned char* buf, size_t len)
+{
+  if (len < 52 || buf[5] != 1) // little endian only
+    return NULL;
+
+  switch (le16(buf + 16))
+  {
+    case 1:
+      return "application/x-object";
+    case 2:
+      return "application/x-executable";
+    case 4:
+      return "application/x-coredump";
+    case 3:
+      break;
+    default:
+      return NULL;
+  }
+
+  int    is64    = buf[4] == 2;
+  size_t phoff   = is64 ? le32(buf + 32) : le32(buf + 28);
+  size_t phentsz = le16(buf + (is64 ? 54 : 42));
+  size_t phnum   = le16(buf + (is64 ? 56 : 44));
+  if ((is64 && le32(buf + 36) != 0) || phentsz < 4)
+    return NULL;
+  for (size_t i = 0; i < phnum; i++)
+  {
+    size_t at = phoff + i * phentsz;
+    if (at + 4 > len || le32(buf + at) == 3) // past the head, or PT_INTERP
+      return NULL;
+    if (le32(buf + at) == 1) // PT_LOAD
+      break;
+  }
+  return "application/x-sharedlib";
+}
+
+static const char* sniff_riff(const unsigned char* buf, size_t len)
+{
+  if (has_bytes(buf, len, 8, "WEBP", 4))
+    return "image/webp";
+  if (has_bytes(buf, len, 8, "WAVE", 4))
+    return "audio/x-wav";
+  if (has_bytes(buf, len, 8, "AVI ", 4))
+    return "video/x-msvideo";
+  return NULL;
+}
+
+/*
+ * Zip: jars start with a META-INF/ entry carrying the 0xCAFE extra field.
+ * Office documents, epubs, apks... are zips too and libmagic knows them
+ * better, so anything with a telling first entry is left to it.
+ */
+static const char* sniff_zip(const unsigned char* buf, size_t len)
+{
+  if (len < 30)
+    return NULL;
+  size_t      name_len  = le16(buf + 26);
+  size_t      extra_len = le16(buf + 28);
+  const char* name      = (const char*)buf + 30;
+  if (30 + name_len + extra_len > len)
+    return NULL;
+
+  if (name_len == 9 && memcmp(name, "META-INF/", 9) == 0)
+  {
+    if (extra_len >= 4 && le16(buf + 30 + name_len) == 0xCAFE)
+      return "application/java-archive";
+    return NULL;
+  }
+
+  static const char* special[] = {"mimetype", "[Content_Types].xml", "_rels/", "META-INF/",
+                                  "AndroidManifest.xml", "docProps/", "word/", "xl/", "ppt/"};
+  for (size_t i = 0; i < sizeof(special) / sizeof(special[0]); i++)
+  {
+    size_t n = strlen(special[i]);
+    if (name_len >= n && memcmp(name, special[i], n) == 0)
+      return NULL;
+  }
+  return "application/zip";
+}
+
+static const char* sniff_ogg(const unsigned char* buf, size_t len)
+{
+  if (has_bytes(buf, len, 28, "\x01vorbis", 7) || has_bytes(buf, len, 28, "OpusHead", 8) ||
+      has_bytes(buf, len, 28, "\x7f" "FLAC", 5))
+    return "audio/ogg";
+  if (has_bytes(buf, len, 28, "\x80theora", 7))
+    return "video/ogg";
+  return NULL;
+}
+
+/* ISO base media (MP4 and friends), by major brand */
+static const char* sniff_ftyp(const unsigned char* buf, size_t len)
+{
+  static const struct
+  {
+    const char* brand;
+    const char* mime;
+  } brands[] = {
+    {"isom", "video/mp4"},       {"iso2", "video/mp4"},   {"mp41", "video/mp4"},
+    {"mp42", "video/mp4"},       {"avc1", "video/mp4"},   {"dash", "video/mp4"},
+    {"M4A ", "audio/x-m4a"},     {"M4V ", "video/x-m4v"}, {"qt  ", "video/quicktime"},
+    {"3gp4", "video/3gpp"},      {"3gp5", "video/3gpp"},  {"3gp6", "video/3gpp"},
+    {"heic", "image/heic"},      {"avif", "image/avif"},
+  };
+  if (len < 12)
+    return NULL;
+  for (size_t i = 0; i < sizeof(brands) / sizeof(brands[0]); i++)
+  {
+    if (memcmp(buf + 8, brands[i].brand, 4) == 0)
+      return brands[i].mime;
+  }
+  return NULL;
+}
+
+/* EBML: Matroska or WebM, by the DocType element near the start */
+static const char* sniff_ebml(const unsigned char* buf, size_t len)
+{
+  size_t end = len < 64 ? len : 64;
+  for (size_t i = 4; i + 3 < end; i++)
+  {
+    if (buf[i] != 0x42 || buf[i + 1] != 0x82 || (buf[i + 2] & 0x80) == 0)
+      continue;
+    size_t n = buf[i + 2] & 0x7f;
+    if (has_bytes(buf, len, i + 3, "webm", 4) && n == 4)
+      return "video/webm";
+    if (has_bytes(buf, len, i + 3, "matroska", 8) && n == 8)
+      return "video/x-matroska";
+    return NULL;
+  }
+  return NULL;
+}
+
+static const struct
+{
+  uint16_t    offset;
+  uint8_t     len;
+  const char* bytes;
+  const char* mime;   /* NULL to ask `refine` */
+  SniffRefine refine;
+} signatures[] = {
+  {0, 4, "\x7f" "ELF", NULL, sniff_elf},
+  {0, 8, "\x89PNG\r\n\x1a\n", "image/png", NULL},
+  {0, 3, "\xff\xd8\xff", "image/jpeg", NULL},
+  {0, 6, "GIF87a", "image/gif", NULL},
+  {0, 6, "GIF89a", "image/gif", NULL},
+  {0, 4, "RIFF", NULL, sniff_riff},
+  {0, 5, "%PDF-", "application/pdf", NULL},
+  {0, 4, "PK\x03\x04", NULL, sniff_zip},
+  {0, 4, "PK\x05\x06", "application/zip", NULL},
+  {0, 2, "\x1f\x8b", "application/gzip", NULL},
+  {0, 6, "\xfd" "7zXZ\0", "application/x-xz", NULL},
+  {0, 4, "\x28\xb5\x2f\xfd", "application/zstd", NULL},
+  {0, 6, "7z\xbc\xaf\x27\x1c", "application/x-7z-compressed", NULL},
+  {257, 5, "ustar", "application/x-tar", NULL},
+  {0, 4, "fLaC", "audio/flac", NULL},
+  {0, 4, "OggS", NULL, sniff_ogg},
+  {0, 3, "ID3", "audio/mpeg", NULL},
+  {4, 4, "ftyp", NULL, sniff_ftyp},
+  {0, 4, "\x1a\x45\xdf\xa3", NULL, sniff_ebml},
+};
+
+/* An MPEG-1/2 layer III frame header right at the start (MP3 without ID3 tag) */
+static int is_mp3_frame(const unsigned char* buf, size_t len)
+{
+  return len >= 4 && buf[0] == 0xFF && (buf[1] & 0xE0) == 0xE0 && ((buf[1] >> 1) & 3) == 1 &&
+         ((buf[1] >> 3) & 3) != 1 && (buf[2] >> 4) != 0x0F && (buf[2] >> 4) != 0;
+}
+
+/* Control bytes that still count as text (BEL, BS, HT, LF, VT, FF, CR, ESC), like `file` */
+static int is_text_control(unsigned char c) { return (c >= 7 && c <= 13) || c == 27; }
+
+/* Valid UTF-8, a sequence cut off by the end of the head is fine */
+static int is_utf8(const unsigned char* buf, size_t len)
+{
+  size_t i = 0;
+  while (i < len)
+  {
+    unsigned char c = buf[i];
+    size_t        n;
+    uint32_t      cp;
+    if (c < 0x80)
+    {
+      i++;
+      continue;
+    }
+    else if (c >= 0xC2 && c <= 0xDF)
+    {
+      n  = 1;
+      cp = c & 0x1F;
+    }
+    else if (c >= 0xE0 && c <= 0xEF)
+    {
+      n  = 2;
+      cp = c & 0x0F;
+    }
+    else if (c >= 0xF0 && c <= 0xF4)
+    {
+      n  = 3;
+      cp = c & 0x07;
+    }
+    else
+      return 0;
+
+    for (size_t k = 1; k <= n; k++)
+    {
+      if (i + k >= len)
+        return 1; // cut off
+      if ((buf[i + k] & 0xC0) != 0x80)
+        return 0;
+      cp = cp << 6 | (buf[i + k] & 0x3F);
+    }
+    // Overlong forms, surrogates, past U+10FFFF
+    if ((n == 2 && cp < 0x800) || (n == 3 && cp < 0x10000) || cp > 0x10FFFF ||
+        (cp >= 0xD800 && cp <= 0xDFFF))
+      return 0;
+    i += n + 1;
+  }
+  return 1;
+}
+
+/*
+ * @SNIFF_TEXT
+ *
+ * Text or binary. 16 bytes at a time with SSE2: one pass finds control
+ * bytes that are not whitespace/escape, DEL, and whether there are any
+ * non ASCII bytes at all. Only then is the head checked for valid UTF-8.
+ */
+SniffText sniff_text(const unsigned char* buf, size_t len)
+{
+  size_t i       = 0;
+  int    any_non = 0; // any byte >= 0x80
+
+#ifdef __SSE2__
+  const __m128i space = _mm_set1_epi8(0x20);
+  const __m128i del   = _mm_set1_epi8(0x7f);
+  const __m128i esc   = _mm_set1_epi8(27);
+  const __m128i bel   = _mm_set1_epi8(6);  // > 6
+  const __m128i cr    = _mm_set1_epi8(14); // < 14
+  for (; i + 16 <= len; i += 16)
+  {
+    __m128i v    = _mm_loadu_si128((const __m128i*)(buf + i));
+    int     high = _mm_movemask_epi8(v);
+    // Signed compare: bytes >= 0x80 are negative and also "below space", masked out by `high`
+    int ctrl = _mm_movemask_epi8(_mm_cmplt_epi8(v, space)) & ~high;
+    if (ctrl)
+    {
+      __m128i ok = _mm_or_si128(_mm_cmpeq_epi8(v, esc),
+                                _mm_and_si128(_mm_cmpgt_epi8(v, bel), _mm_cmplt_epi8(v, cr)));
+      if (ctrl & ~_mm_movemask_epi8(ok))
+        return SNIFF_BINARY;
+    }
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(v, del)))
+      return SNIFF_BINARY;
+    any_non |= high;
+  }
+#endif
+
+  for (; i < len; i++)
+  {
+    unsigned char c = buf[i];
+    if ((c < 0x20 && !is_text_control(c)) || c == 0x7f)
+      return SNIFF_BINARY;
+    any_non |= c >= 0x80;
+  }
+
+  if (!any_non)
+    return SNIFF_ASCII;
+  return is_utf8(buf, len) ? SNIFF_UTF8 : SNIFF_BINARY;
+}
+
+/* Script MIME type from a "#!" line, NULL for interpreters we do not know */
+static const char* sniff_shebang(const unsigned char* buf, size_t len)
+{
+  static const struct
+  {
+    const char* interpreter;
+    const char* mime;
+  } interpreters[] = {
+    {"sh", "text/x-shellscript"},      {"bash", "text/x-shellscript"},
+    {"dash", "text/x-shellscript"},    {"zsh", "text/x-shellscript"},
+    {"python", "text/x-script.python"}, {"python3", "text/x-script.python"},
+    {"perl", "text/x-perl"},           {"ruby", "text/x-ruby"},
+    {"node", "application/javascript"},
+  };
+
+  size_t end = 2;
+  while (end < len && buf[end] != '\n')
+    end++;
+
+  // The interpreter is the last path component of the first word, or the word after "env"
+  size_t at = 2;
+  for (int word = 0; word < 2; word++)
+  {
+    while (at < end && (buf[at] == ' ' || buf[at] == '\t'))
+      at++;
+    size_t start = at;
+    while (at < end && buf[at] != ' ' && buf[at] != '\t')
+      at++;
+    size_t name = start;
+    for (size_t k = start; k < at; k++)
+    {
+      if (buf[k] == '/')
+        name = k + 1;
+    }
+    size_t n = at - name;
+    if (word == 0 && n == 3 && memcmp(buf + name, "env", 3) == 0)
+      continue;
+    for (size_t k = 0; k < sizeof(interpreters) / sizeof(interpreters[0]); k++)
+    {
+      if (strlen(interpreters[k].interpreter) == n &&
+          memcmp(buf + name, interpreters[k].interpreter, n) == 0)
+        return interpreters[k].mime;
+    }
+    return NULL;
+  }
+  return NULL;
+}
+
+/*
+ * @SNIFF_MIME
+ *
+ * MIME type of a file from its first `len` bytes, `name` (may be NULL) is
+ * only used to vouch for text. NULL if this takes libmagic/`file`.
+ */
+const char* sniff_mime(const unsigned char* buf, size_t len, const char* name)
+{
+  for (size_t i = 0; i < sizeof(signatures) / sizeof(signatures[0]); i++)
+  {
+    if (!has_bytes(buf, len, signatures[i].offset, signatures[i].bytes, signatures[i].len))
+      continue;
+    return signatures[i].mime ? signatures[i].mime : signatures[i].refine(buf, len);
+  }
+  if (is_mp3_frame(buf, len))
+    return "audio/mpeg";
+
+  if (len == 0 || sniff_text(buf, len) == SNIFF_BINARY)
+    return NULL;
+  if (len > 2 && buf[0] == '#' && buf[1] == '!')
+    return sniff_shebang(buf, len);
+
+  const ExtInfo* ext = name ? ext_lookup(name) : NULL;
+  if (ext != NULL && ext->mime != NULL && ext->category == EXT_CATEGORY_TEXT)
+    return ext->mime;
+  return NULL;
+}
@@ -0,0 +1,184 @@
+// // // // // //
+//             //
+//   LITE FM   //
+//             //
+// // // // // //
+
+/* BY nots1dd */
+
+#define _GNU_SOURCE
+
+#include "../include/syntax.h"
+#include "../include/highlight.h"
+#include "../include/logging.h"
+#include "syntax_gen.h" /* generated from keywords/ at build time, see tools/syntax_gen.c */
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static struct
+{
+  Syntax        languages[SYNTAX_MAX_LANGUAGES];
+  size_t        count;
+  unsigned long lookups;
+  unsigned long builtin; /* languages served from syntax_gen.h */
+  unsigned long loads;   /* YAML files parsed, at most one per language */
+} syntaxes;
+
+/*
+ * <language>-keywords.yaml in the override directory. Returns 0 if there is
+ * one to read, -1 if not (the usual case).
+ */
+static int syntax_override_path(const char* language, char* path, size_t size)
+{
+  const char* dir = getenv(SYNTAX_ENV_DIR);
+  int         written;
+  if (dir != NULL && *dir != '\0')
+    written = snprintf(path, size, "%s/%s-keywords.yaml", dir, language);
+  else
+  {
+    const char* home = getenv("HOME");
+    if (home == NULL)
+      return -1;
+    written =
+      snprintf(path, size, "%s/%s/%s-keywords.yaml", home, SYNTAX_RELATIVE_DIR, language);
+  }
+  if (written < 0 || (size_t)written >= size)
+    return -1;
+  return access(path, R_OK) == 0 ? 0 : -1;
+}
+
+static const SyntaxTable* syntax_builtin(const char* language)
+{
+  for (size_t i = 0; i < SYNTAX_TABLE_COUNT; i++)
+  {
+    if (strcmp(syntax_tables[i].language, language) == 0)
+      return &syntax_tables[i];
+  }
+  return NULL;
+}
+
+static void syntax_release(Syntax* syntax)
+{
+  for (int i = 0; i < SYNTAX_SET_COUNT; i++)
+  {
+    if (syntax->sets[i] != NULL)
+      free_table(syntax->sets[i]);
+    syntax->sets[i] = NULL;
+  }
+}
+
+/* Parses the YAML at `path` into `syntax`, which keeps `loaded` = 0 if that fails */
+static void syntax_load(Syntax* syntax, const char* path)
+{
+  for (int i = 0; i < SYNTAX_SET_COUNT; i++)
+  {
+    if ((syntax->sets[i] = create_table()) == NULL)
+    {
+      syntax_release(syntax);
+      return;
+    }
+  }
+
+  log_message(LOG_LEVEL_DEBUG, " [SYNHASH] Loading in %s", path);
+  syntaxes.loads++;
+  syntax->loaded =
+    load_syntax(path, syntax->sets[SYNTAX_KEYWORDS], syntax->sets[SYNTAX_SINGLECOMMENTS],
+                syntax->sets[SYNTAX_MULTICOMMENTS1], syntax->sets[SYNTAX_MULTICOMMENTS2],
+                syntax->sets[SYNTAX_STRINGS], syntax->sets[SYNTAX_FUNCTIONS],
+                syntax->sets[SYNTAX_SYMBOLS], syntax->sets[SYNTAX_OPERATORS],
+                &syntax->singlecommentslen);
+  if (!syntax->loaded)
+    syntax_release(syntax); // Nothing is ever looked up in it
+}
+
+/* The user's file if there is one, the built in table if not */
+static void syntax_find(Syntax* syntax, const char* language)
+{
+  memset(syntax, 0, sizeof(*syntax));
+  snprintf(syntax->language, sizeof(syntax->language), "%s", language);
+
+  char path[PATH_MAX];
+  if (syntax_override_path(language, path, sizeof(path)) == 0)
+  {
+    syntax_load(syntax, path);
+    if (syntax->loaded)
+      return;
+    log_message(LOG_LEVEL_WARN, " [SYNHASH] Falling back to the built in syntax of %s",
+                language);
+  }
+
+  if ((syntax->table = syntax_builtin(language)) == NULL)
+    return;
+  syntax->singlecommentslen = syntax->table->singlecommentslen;
+  syntax->loaded            = 1;
+  syntaxes.builtin++;
+}
+
+/*
+ * @SYNTAX_GET
+ *
+ * The syntax definition of `language` (a `syntax` from exttable.def),
+ * looked up the first time it is asked for. NULL if there is none or it
+ * could not be loaded, the file is then shown without highlighting.
+ */
+const Syntax* syntax_get(const char* language)
+{
+  if (language == NULL)
+    return NULL;
+
+  syntaxes.lookups++;
+  for (size_t i = 0; i < syntaxes.count; i++)
+  {
+    const Syntax* syntax = &syntaxes.languages[i];
+    if (strcmp(syntax->language, language) == 0)
+      return syntax->loaded ? syntax : NULL;
+  }
+
+  if (syntaxes.count == SYNTAX_MAX_LANGUAGES || strlen(language) >= SYNTAX_NAME_MAX)
+  {
+    log_message(LOG_LEVEL_ERROR, " [SYNHASH] No room for the syntax of %s", language);
+    return NULL;
+  }
+  Syntax* syntax = &syntaxes.languages[syntaxes.count++];
+  syntax_find(syntax, language);
+  return syntax->loaded ? syntax : NULL;
+}
+
+/* Whether `word` is in `set`, `syntax` being one syntax_get handed out */
+int syntax_has_word(const Syntax* syntax, SyntaxSet set, const char* word)
+{
+  const SyntaxTable* table = syntax->table;
+  if (table == NULL)
+    return search(syntax->sets[set], word);
+
+  uint32_t          hash  = syntax_hash(word, table->seed);
+  uint32_t          slot  = syntax_slot(hash, table->displace[hash & (table->buckets - 1)]);
+  const SyntaxWord* entry = &table->words[slot & (table->slots - 1)];
+  return entry->word != NULL && (entry->sets & (1u << set)) && strcmp(entry->word, word) == 0;
+}
+
+/* Whether the character at `c` is a word of its own in `set`, as hash_table_contains */
+int syntax_has_char(const Syntax* syntax, SyntaxSet set, const char* c)
+{
+  if (syntax->table == NULL)
+    return hash_table_contains(syntax->sets[set], c);
+  return (syntax->table->chars[(unsigned char)*c] >> set) & 1;
+}
+
+void syntax_free(void)
+{
+  for (size_t i = 0; i < syntaxes.count; i++)
+    syntax_release(&syntaxes.languages[i]);
+  syntaxes.count = 0;
+}
+
+void syntax_log_stats(void)
+{
+  log_message(LOG_LEVEL_DEBUG,
+              " [SYNHASH] lookups: %lu, built in: %lu, YAML files parsed: %lu, languages: %zu",
+              syntaxes.lookups, syntaxes.builtin, syntaxes.loads, syntaxes.count);
+}
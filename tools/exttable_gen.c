@@ -0,0 +1,157 @@
+// // // // // //
+//             //
+//   LITE FM   //
+//             //
+// // // // // //
+
+/*
+ * ---------------------------------------------------------------------------
+ *  File:        exttable_gen.c
+ *  Description: Builds the perfect hash table of include/exttable.def and
+ *               writes it out as C (exttable_gen.h).
+ *
+ *  Author:      Siddharth Karanam
+ *  Created:     <17/10/26>
+ *
+ *  Copyright:   2024 nots1dd. All rights reserved.
+ *
+ *  License:     <GNU GPL v3>
+ *
+ *  Notes:       Usage: exttable_gen <output>
+ *
+ *               The slot count is the next power of two holding twice the
+ *               entries. Seeds are tried in order until `ext_hash` puts
+ *               every extension in a slot of its own, so the output only
+ *               changes when the list does. The Makefile, CMake and meson
+ *               run it as a build step, the list is compiled in here.
+ *
+ *  Revision History:
+ *      <17/10/26> - Initial creation.
+ *
+ * ---------------------------------------------------------------------------
+ */
+
+#include "../include/exttable.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define EXT(ext, category, archive, mime, syntax)                                          \
+  {ext, sizeof(ext) - 1, EXT_CATEGORY_##category, EXT_ARCHIVE_##archive, mime, syntax},
+
+static const ExtInfo entries[] = {
+#include "../include/exttable.def"
+};
+
+#undef EXT
+
+#define ENTRY_COUNT (sizeof(entries) / sizeof(entries[0]))
+
+static const char* category_names[] = {"EXT_CATEGORY_NONE",  "EXT_CATEGORY_TEXT",
+                                       "EXT_CATEGORY_ARCHIVE", "EXT_CATEGORY_AUDIO",
+                                       "EXT_CATEGORY_IMAGE", "EXT_CATEGORY_VIDEO"};
+static const char* archive_names[]  = {"EXT_ARCHIVE_NONE", "EXT_ARCHIVE_ZIP",
+                                       "EXT_ARCHIVE_TAR",  "EXT_ARCHIVE_GZIP",
+                                       "EXT_ARCHIVE_XZ",   "EXT_ARCHIVE_BZIP2",
+                                       "EXT_ARCHIVE_SEVENZIP"};
+
+static void print_string(FILE* out, const char* s)
+{
+  if (s == NULL)
+    fprintf(out, "NULL");
+  else
+    fprintf(out, "\"%s\"", s);
+}
+
+int main(int argc, char** argv)
+{
+  if (argc != 2)
+  {
+    fprintf(stderr, "Usage: %s <output>\n", argv[0]);
+    return 1;
+  }
+
+  size_t slots = 1;
+  while (slots < 2 * ENTRY_COUNT)
+    slots *= 2;
+
+  int* slot_of = malloc(slots * sizeof(int));
+  if (slot_of == NULL)
+    return 1;
+
+  for (size_t i = 0; i < ENTRY_COUNT; i++)
+  {
+    if (entries[i].len > EXT_MAX_LEN)
+    {
+      fprintf(stderr, "exttable_gen: '%s' is longer than EXT_MAX_LEN\n", entries[i].ext);
+      return 1;
+    }
+    for (size_t j = 0; j < i; j++)
+    {
+      if (strcmp(entries[i].ext, entries[j].ext) == 0)
+      {
+        fprintf(stderr, "exttable_gen: '%s' is listed twice\n", entries[i].ext);
+        return 1;
+      }
+    }
+  }
+
+  uint32_t seed;
+  for (seed = 0;; seed++)
+  {
+    memset(slot_of, -1, slots * sizeof(int));
+    size_t i;
+    for (i = 0; i < ENTRY_COUNT; i++)
+    {
+      uint32_t slot = ext_hash(entries[i].ext, entries[i].len, seed) & (slots - 1);
+      if (slot_of[slot] != -1)
+        break;
+      slot_of[slot] = (int)i;
+    }
+    if (i == ENTRY_COUNT)
+      break;
+    if (seed == UINT32_MAX)
+    {
+      fprintf(stderr, "exttable_gen: no perfect seed for %zu slots\n", slots);
+      return 1;
+    }
+  }
+
+  FILE* out = fopen(argv[1], "w");
+  if (out == NULL)
+  {
+    perror(argv[1]);
+    return 1;
+  }
+
+  fprintf(out,
+          "/* Generated by tools/exttable_gen.c from include/exttable.def, do not edit */\n\n");
+  fprintf(out, "#define EXT_TABLE_SEED  %uu\n", seed);
+  fprintf(out, "#define EXT_TABLE_SLOTS %zu\n\n", slots);
+  fprintf(out, "static const ExtInfo ext_table[EXT_TABLE_SLOTS] = {\n");
+  for (size_t slot = 0; slot < slots; slot++)
+  {
+    if (slot_of[slot] == -1)
+      continue;
+    const ExtInfo* e = &entries[slot_of[slot]];
+    fprintf(out, "  [%zu] = {\"%s\", %u, %s, %s, ", slot, e->ext, e->len,
+            category_names[e->category], archive_names[e->archive]);
+    print_string(out, e->mime);
+    fprintf(out, ", ");
+    print_string(out, e->syntax);
+    fprintf(out, "},\n");
+  }
+  fprintf(out, "};\n");
+
+  // Leaves no half written header behind
+  if (fclose(out) != 0)
+  {
+    perror(argv[1]);
+    remove(argv[1]);
+    return 1;
+  }
+
+  free(slot_of);
+  return 0;
+}
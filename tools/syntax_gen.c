@@ -0,0 +1,417 @@
+// // // // // //
+//             //
+//   LITE FM   //
+//             //
+// // // // // //
+
+/*
+ * ---------------------------------------------------------------------------
+ *  File:        syntax_gen.c
+ *  Description: Compiles keywords/<language>-keywords.yaml into the
+ *               SyntaxTables of syntax_gen.h (see include/syntax.h).
+ *
+ *  Author:      Siddharth Karanam
+ *  Created:     <17/10/26>
+ *
+ *  Copyright:   2024 nots1dd. All rights reserved.
+ *
+ *  License:     <GNU GPL v3>
+ *
+ *  Notes:       Usage: syntax_gen <output> <language>-keywords.yaml...
+ *
+ *               The YAML is read the way load_syntax reads it (a scalar
+ *               naming a set opens it, the end of a sequence closes it,
+ *               the last `singlecommentslen` wins) so a built in table
+ *               answers what the HashTables of the same file would.
+ *
+ *               Per language, every distinct word gets the bits of the
+ *               sets it is in. The slot count is the next power of two
+ *               holding twice the words, with a quarter as many buckets.
+ *               A single seed that puts ~150 words in slots of their own
+ *               is too rare to search for, so the table seed only picks
+ *               the bucket and each bucket gets a displacement of its own
+ *               (hash and displace), tried in order from 0 with the
+ *               fullest buckets first. The languages are written sorted by
+ *               name, so the output only changes when a file does. The Makefile, CMake and meson
+ *               run it as a build step.
+ *
+ *  Revision History:
+ *      <17/10/26> - Initial creation.
+ *
+ * ---------------------------------------------------------------------------
+ */
+
+#define _GNU_SOURCE
+
+#include "../include/syntax.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <yaml.h>
+
+#define SUFFIX           "-keywords.yaml"
+#define SYNTAX_GEN_TRIES (1u << 20) /* seeds tried, for a bucket and for the whole language */
+
+/* The set names as they appear in the YAML, in SyntaxSet order */
+static const char* set_names[SYNTAX_SET_COUNT] = {
+  "keywords", "singlecomments", "multicomments1", "multicomments2",
+  "strings",  "functions",      "symbols",        "operators"};
+
+typedef struct
+{
+  char*   word;
+  uint8_t sets;
+} Word;
+
+typedef struct
+{
+  char     language[SYNTAX_NAME_MAX];
+  Word*    words;
+  size_t   count;
+  size_t   cap;
+  int      singlecommentslen;
+  uint32_t seed; /* the rest once its words are placed */
+  uint32_t buckets;
+  uint32_t slots;
+} Language;
+
+static int add_word(Language* lang, const char* word, int set)
+{
+  for (size_t i = 0; i < lang->count; i++)
+  {
+    if (strcmp(lang->words[i].word, word) == 0)
+    {
+      lang->words[i].sets |= (uint8_t)(1u << set);
+      return 0;
+    }
+  }
+  if (lang->count == lang->cap)
+  {
+    size_t cap   = lang->cap ? lang->cap * 2 : 64;
+    Word*  words = realloc(lang->words, cap * sizeof(Word));
+    if (words == NULL)
+      return -1;
+    lang->words = words;
+    lang->cap   = cap;
+  }
+  if ((lang->words[lang->count].word = strdup(word)) == NULL)
+    return -1;
+  lang->words[lang->count++].sets = (uint8_t)(1u << set);
+  return 0;
+}
+
+/* `path` must end in SUFFIX, what comes before it (past the last '/') is the language */
+static int language_of(const char* path, char* language)
+{
+  const char* base = strrchr(path, '/');
+  base             = base ? base + 1 : path;
+  size_t len       = strlen(base);
+  if (len <= strlen(SUFFIX) || strcmp(base + len - strlen(SUFFIX), SUFFIX) != 0)
+    return -1;
+  len -= strlen(SUFFIX);
+  if (len >= SYNTAX_NAME_MAX)
+    return -1;
+  memcpy(language, base, len);
+  language[len] = '\0';
+  return 0;
+}
+
+static int read_language(const char* path, Language* lang)
+{
+  FILE* fh = fopen(path, "r");
+  if (fh == NULL)
+  {
+    perror(path);
+    return -1;
+  }
+
+  yaml_parser_t parser;
+  yaml_event_t  event;
+  if (!yaml_parser_initialize(&parser))
+  {
+    fclose(fh);
+    return -1;
+  }
+  yaml_parser_set_input_file(&parser, fh);
+
+  int set    = -1; /* the one being read, SYNTAX_SET_COUNT for singlecommentslen */
+  int status = 0;
+  int done   = 0;
+  while (!done && status == 0)
+  {
+    if (!yaml_parser_parse(&parser, &event))
+    {
+      fprintf(stderr, "syntax_gen: %s:%zu: %s\n", path, parser.problem_mark.line + 1,
+              parser.problem ? parser.problem : "parse error");
+      status = -1;
+      break;
+    }
+
+    if (event.type == YAML_STREAM_END_EVENT)
+      done = 1;
+    else if (event.type == YAML_SEQUENCE_END_EVENT)
+      set = -1;
+    else if (event.type == YAML_SCALAR_EVENT)
+    {
+      const char* value = (const char*)event.data.scalar.value;
+      if (set == SYNTAX_SET_COUNT)
+        lang->singlecommentslen = atoi(value);
+      else if (set >= 0)
+        status = add_word(lang, value, set);
+      else if (strcmp(value, "singlecommentslen") == 0)
+        set = SYNTAX_SET_COUNT;
+      else
+      {
+        for (int i = 0; i < SYNTAX_SET_COUNT; i++)
+        {
+          if (strcmp(value, set_names[i]) == 0)
+            set = i;
+        }
+      }
+    }
+    yaml_event_delete(&event);
+  }
+
+  yaml_parser_delete(&parser);
+  fclose(fh);
+  return status;
+}
+
+/* `s` as a C string literal. '?' is escaped so no trigraph can sneak in. */
+static void print_string(FILE* out, const char* s)
+{
+  fputc('"', out);
+  for (; *s != '\0'; s++)
+  {
+    unsigned char c = (unsigned char)*s;
+    if (c == '"' || c == '\\' || c == '?')
+      fprintf(out, "\\%c", c);
+    else if (c >= 0x20 && c < 0x7f)
+      fputc(c, out);
+    else
+      fprintf(out, "\\%03o", c);
+  }
+  fputc('"', out);
+}
+
+/*
+ * Tries to give every word of a bucket (`members`, `count` of them) a slot
+ * of its own under one displacement. Returns 0 and sets `slot_of` and
+ * `displace` if one of the first SYNTAX_GEN_TRIES does it.
+ */
+static int place_bucket(const uint32_t* hashes, const size_t* members, size_t count,
+                        int* slot_of, uint32_t slots, uint32_t* displace)
+{
+  for (uint32_t d = 0; d < SYNTAX_GEN_TRIES; d++)
+  {
+    size_t i;
+    for (i = 0; i < count; i++)
+    {
+      uint32_t slot = syntax_slot(hashes[members[i]], d) & (slots - 1);
+      if (slot_of[slot] != -1)
+        break;
+      slot_of[slot] = (int)members[i];
+    }
+    if (i == count)
+    {
+      *displace = d;
+      return 0;
+    }
+    while (i-- > 0) // Give back what this displacement took
+      slot_of[syntax_slot(hashes[members[i]], d) & (slots - 1)] = -1;
+  }
+  return -1;
+}
+
+/*
+ * Places the words of `lang`: their `syntax_hash` under `seed` picks the
+ * bucket, `syntax_slot` with the bucket's displacement the slot. Fullest
+ * buckets go first.
+ */
+static int place_words(Language* lang, int* slot_of, uint32_t* displace, size_t* members,
+                       uint32_t* hashes)
+{
+  for (lang->seed = 0; lang->seed < SYNTAX_GEN_TRIES; lang->seed++)
+  {
+    memset(slot_of, -1, lang->slots * sizeof(int));
+    memset(displace, 0, lang->buckets * sizeof(uint32_t));
+    for (size_t i = 0; i < lang->count; i++)
+      hashes[i] = syntax_hash(lang->words[i].word, lang->seed);
+
+    int placed = 1;
+    for (size_t size = lang->count; size > 0 && placed; size--)
+    {
+      for (uint32_t b = 0; b < lang->buckets && placed; b++)
+      {
+        size_t count = 0;
+        for (size_t i = 0; i < lang->count; i++)
+        {
+          if ((hashes[i] & (lang->buckets - 1)) == b)
+            members[count++] = i;
+        }
+        if (count == size)
+          placed = place_bucket(hashes, members, count, slot_of, lang->slots, &displace[b]) == 0;
+      }
+    }
+    if (placed)
+      return 0;
+  }
+  fprintf(stderr, "syntax_gen: no perfect hash for %s\n", lang->language);
+  return -1;
+}
+
+/* The buckets and words of `lang` in their slots */
+static int write_words(FILE* out, Language* lang, size_t index)
+{
+  lang->slots = 1;
+  while (lang->slots < 2 * lang->count)
+    lang->slots *= 2;
+  lang->buckets = lang->slots > 4 ? lang->slots / 4 : 1;
+
+  int*      slot_of  = malloc(lang->slots * sizeof(int));
+  uint32_t* displace = malloc(lang->buckets * sizeof(uint32_t));
+  size_t*   members  = malloc((lang->count ? lang->count : 1) * sizeof(size_t));
+  uint32_t* hashes   = malloc((lang->count ? lang->count : 1) * sizeof(uint32_t));
+  if (slot_of == NULL || displace == NULL || members == NULL || hashes == NULL ||
+      place_words(lang, slot_of, displace, members, hashes) == -1)
+  {
+    free(slot_of);
+    free(displace);
+    free(members);
+    free(hashes);
+    return -1;
+  }
+
+  fprintf(out, "static const uint32_t syntax_displace_%zu[%u] = {", index, lang->buckets);
+  for (uint32_t b = 0; b < lang->buckets; b++)
+    fprintf(out, "%s%s%uu", b ? "," : "", b % 8 ? " " : "\n  ", displace[b]);
+  fprintf(out, "\n};\n\n");
+
+  fprintf(out, "static const SyntaxWord syntax_words_%zu[%u] = {\n", index, lang->slots);
+  if (lang->count == 0)
+    fprintf(out, "  {NULL, 0},\n");
+  for (uint32_t slot = 0; slot < lang->slots; slot++)
+  {
+    if (slot_of[slot] == -1)
+      continue;
+    const Word* word = &lang->words[slot_of[slot]];
+    fprintf(out, "  [%u] = {", slot);
+    print_string(out, word->word);
+    fprintf(out, ", 0x%02x},\n", word->sets);
+  }
+  fprintf(out, "};\n\n");
+  free(slot_of);
+  free(displace);
+  free(members);
+  free(hashes);
+  return 0;
+}
+
+static void write_table(FILE* out, const Language* lang, size_t index)
+{
+  uint8_t chars[256] = {0};
+
+  // What hash_table_contains finds: words of one character (or none, for '\0')
+  for (size_t i = 0; i < lang->count; i++)
+  {
+    const char* word = lang->words[i].word;
+    if (word[0] == '\0' || word[1] == '\0')
+      chars[(unsigned char)word[0]] |= lang->words[i].sets;
+  }
+
+  fprintf(out, "  {\"%s\", %uu, %u, syntax_displace_%zu, %u, syntax_words_%zu, %d, {",
+          lang->language, lang->seed, lang->buckets, index, lang->slots, index,
+          lang->singlecommentslen);
+  int written = 0;
+  for (int c = 0; c < 256; c++)
+  {
+    if (chars[c] == 0)
+      continue;
+    fprintf(out, "%s[%d] = 0x%02x", written == 0 ? "\n    " : written % 6 ? ", " : ",\n    ", c,
+            chars[c]);
+    written++;
+  }
+  fprintf(out, "}},\n");
+}
+
+static int compare_languages(const void* a, const void* b)
+{
+  return strcmp(((const Language*)a)->language, ((const Language*)b)->language);
+}
+
+int main(int argc, char** argv)
+{
+  if (argc < 2)
+  {
+    fprintf(stderr, "Usage: %s <output> <language>%s...\n", argv[0], SUFFIX);
+    return 1;
+  }
+
+  size_t    count = (size_t)argc - 2;
+  Language* langs = calloc(count ? count : 1, sizeof(Language));
+  if (langs == NULL)
+    return 1;
+
+  for (size_t i = 0; i < count; i++)
+  {
+    const char* path = argv[i + 2];
+    if (language_of(path, langs[i].language) == -1)
+    {
+      fprintf(stderr, "syntax_gen: %s is not <language>%s (language up to %d chars)\n", path,
+              SUFFIX, SYNTAX_NAME_MAX - 1);
+      return 1;
+    }
+    for (size_t j = 0; j < i; j++)
+    {
+      if (strcmp(langs[i].language, langs[j].language) == 0)
+      {
+        fprintf(stderr, "syntax_gen: %s is given twice\n", langs[i].language);
+        return 1;
+      }
+    }
+    if (read_language(path, &langs[i]) == -1)
+      return 1;
+  }
+  qsort(langs, count, sizeof(Language), compare_languages);
+
+  FILE* out = fopen(argv[1], "w");
+  if (out == NULL)
+  {
+    perror(argv[1]);
+    return 1;
+  }
+
+  fprintf(out,
+          "/* Generated by tools/syntax_gen.c from the keywords/ YAML files, do not edit */\n\n");
+  for (size_t i = 0; i < count; i++)
+  {
+    if (write_words(out, &langs[i], i) == -1)
+    {
+      fclose(out);
+      remove(argv[1]);
+      return 1;
+    }
+  }
+  fprintf(out, "#define SYNTAX_TABLE_COUNT %zu\n\n", count);
+  fprintf(out, "static const SyntaxTable syntax_tables[SYNTAX_TABLE_COUNT + 1] = {\n");
+  for (size_t i = 0; i < count; i++)
+    write_table(out, &langs[i], i);
+  fprintf(out, "  {NULL, 0, 0, NULL, 0, NULL, 0, {0}}, /* keeps the array non empty */\n};\n");
+
+  if (fclose(out) != 0)
+  {
+    perror(argv[1]);
+    remove(argv[1]);
+    return 1;
+  }
+
+  for (size_t i = 0; i < count; i++)
+  {
+    for (size_t j = 0; j < langs[i].count; j++)
+      free(langs[i].words[j].word);
+    free(langs[i].words);
+  }
+  free(langs);
+  return 0;
+}